@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "WFCSubsystem.h"
+#include "WFCSymmetry.h"
 #include "Delegates/Delegate.h"
 #include "Internationalization/Text.h"
 #include "Templates/SharedPointer.h"
@@ -24,6 +25,10 @@ struct FWFCModelData
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "WaveFunctionCollapse")
 	TMap<FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap> Constraints;
 
+	// Tiles declared once with their symmetry class, expanded into rotated Constraints by PopulateModel
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "WaveFunctionCollapse")
+	TArray<FWFCSymmetricTile> SymmetricTiles;
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "WaveFunctionCollapse", meta = (AllowedClasses = "StaticMesh, Blueprint"))
 	TArray<FSoftObjectPath> SpawnExclusion;
 };
@@ -41,16 +46,87 @@ public:
 	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Speed")
 	FIntVector WFCResolution = FIntVector(5, 5, 1);
 	
+	// Chunks farther than this from every player are evicted down to their compact record. 0 disables distance eviction.
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Chunks")
+	float ChunkEvictionRadius = 210000.0f;
+
+	// Budget for the memory of resident chunks in MB. 0 disables the budget.
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Chunks")
+	float ChunkMemoryBudgetMB = 512.0f;
+
+	// Chunk collision is only created within this distance of the player and its projectiles. 0 creates it when a chunk is spawned.
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Chunks")
+	float CollisionRadius = 21000.0f;
+
+	// Time spent per frame creating and removing chunk collision, in milliseconds
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Chunks")
+	float CollisionBudgetMs = 1.0f;
+
+	// Tiles without simple collision collide through a box around their bounds
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Chunks")
+	bool bUseCollisionProxies = true;
+
+	// Beyond this distance chunks are drawn as one merged proxy mesh. 0 disables chunk proxies.
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Chunks")
+	float ChunkProxySwapDistance = 70000.0f;
+	
+	// Generate chunks on a fixed lattice seeded from WorldSeed, so the same city comes back whatever order chunks are shot in
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Generation")
+	bool bDeterministicGeneration = false;
+
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Generation")
+	int32 WorldSeed = 0;
+
+	// Solves first try to keep the margin cells solved by earlier overlapping solves
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Generation")
+	bool bReuseProvisionalTiles = true;
+
+	// Maximum amount of solved windows kept by the solution cache. 0 disables the cache.
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Generation")
+	int32 SolutionCacheCapacity = 4096;
+
+	// Random seeds are drawn from 1 to this value, so solves repeat and hit the solution cache. 0 draws from the whole range.
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Generation")
+	int32 RandomSeedPoolSize = 0;
+
+	// Tile selection of the solver, compare them with wfc.Benchmark.Heuristics
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Generation")
+	EWFCObservationHeuristic ObservationHeuristic = EWFCObservationHeuristic::MinEntropy;
+
+	// Noise added to tile entropies by the WeightedEntropyNoise heuristic
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Generation", meta = (ClampMin = "0.0"))
+	float ObservationNoise = 0.1f;
+
+	// Record the generation requests of every session into Saved/WFCJournals, replay them with wfc.Journal.Replay
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Generation")
+	bool bRecordSessionJournal = false;
+	
 	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Model")
 	FSoftObjectPath BaseModel;
 
 	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Model")
 	FWFCModelData ModelData;
+
+	// Coarse model solved over district cells, leave empty for single-level generation
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Districts", meta = (AllowedClasses = "/Script/WaveFunctionCollapse.WaveFunctionCollapseModel"))
+	FSoftObjectPath DistrictModel;
+
+	// Fine tiles allowed per district option BaseObject
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Districts")
+	TMap<FSoftObjectPath, FWFCDistrictTileSet> DistrictTileSets;
+
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Districts")
+	FIntVector DistrictResolution = FIntVector(5, 5, 1);
+
+	// Amount of fine cells covered by a district cell along each axis
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = "Districts")
+	FIntVector DistrictCellSize = FIntVector(9, 9, 1);
 	
 	void PopulateModel(UWaveFunctionCollapseModel* model) const
 	{
 		model->TileSize = ModelData.TileSize;
 		model->Constraints = ModelData.Constraints;
+		FWFCSymmetry::ExpandTiles(ModelData.SymmetricTiles, model->Constraints);
 		model->SpawnExclusion = ModelData.SpawnExclusion;
 	}
 	
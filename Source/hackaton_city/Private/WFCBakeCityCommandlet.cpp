@@ -0,0 +1,290 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCBakeCityCommandlet.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "UObject/Package.h"
+#include "WaveFunctionCollapseModel.h"
+#include "hackaton_city/HackatonCityDeveloperSettings.h"
+#include "hackaton_city/Public/WFCSubsystem.h"
+#if WITH_EDITOR
+#include "FileHelpers.h"
+#include "WorldPartition/WorldPartition.h"
+#include "WorldPartition/DataLayer/DataLayerInstance.h"
+#include "WorldPartition/DataLayer/DataLayerManager.h"
+#endif
+
+namespace
+{
+	bool ParseIntPoint(const FString& Params, const TCHAR* Name, FIntPoint& OutValue)
+	{
+		FString Value, X, Y;
+		if (!FParse::Value(*Params, Name, Value, false) || !Value.Split(TEXT(","), &X, &Y))
+		{
+			return false;
+		}
+		OutValue = FIntPoint(FCString::Atoi(*X), FCString::Atoi(*Y));
+		return true;
+	}
+}
+
+UWFCBakeCityCommandlet::UWFCBakeCityCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UWFCBakeCityCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapName;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName))
+	{
+		UE_LOG(LogTemp, Error, TEXT("WFCBakeCity: missing -Map="));
+		return 1;
+	}
+	int32 WorldSeed = 0;
+	FParse::Value(*Params, TEXT("Seed="), WorldSeed);
+	FIntPoint Extent(8, 8);
+	ParseIntPoint(Params, TEXT("Extent="), Extent);
+	FIntPoint Origin(0, 0);
+	ParseIntPoint(Params, TEXT("Origin="), Origin);
+	int32 BandRows = 4;
+	FParse::Value(*Params, TEXT("BandRows="), BandRows);
+	BandRows = FMath::Max(BandRows, 1);
+
+	// Load the map and initialize it like the editor does, which also initializes its World Partition
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogTemp, Error, TEXT("WFCBakeCity: could not load map %s"), *MapName);
+		return 1;
+	}
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	if (!World->bIsWorldInitialized)
+	{
+		UWorld::InitializationValues InitializationValues;
+		InitializationValues.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true);
+		World->InitWorld(InitializationValues);
+		World->PersistentLevel->UpdateModelComponents();
+		World->UpdateWorldComponents(true, false);
+	}
+	ON_SCOPE_EXIT
+	{
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+	};
+	if (!World->IsPartitionedWorld())
+	{
+		UE_LOG(LogTemp, Error, TEXT("WFCBakeCity: %s is not a World Partition map"), *MapName);
+		return 1;
+	}
+
+	const UHackatonCityDeveloperSettings* Settings = GetDefault<UHackatonCityDeveloperSettings>();
+	UWaveFunctionCollapseModel* Model = nullptr;
+	FString ModelPath;
+	if (FParse::Value(*Params, TEXT("Model="), ModelPath))
+	{
+		Model = LoadObject<UWaveFunctionCollapseModel>(nullptr, *ModelPath);
+	}
+	else if ((Model = Cast<UWaveFunctionCollapseModel>(Settings->BaseModel.TryLoad())) != nullptr)
+	{
+		Settings->PopulateModel(Model);
+	}
+	if (!Model)
+	{
+		UE_LOG(LogTemp, Error, TEXT("WFCBakeCity: could not load model %s"), ModelPath.IsEmpty() ? *Settings->BaseModel.ToString() : *ModelPath);
+		return 1;
+	}
+
+	const UDataLayerInstance* DataLayerInstance = nullptr;
+	FString DataLayerPath;
+	if (FParse::Value(*Params, TEXT("DataLayer="), DataLayerPath))
+	{
+		const UDataLayerManager* DataLayerManager = UDataLayerManager::GetDataLayerManager(World);
+		DataLayerInstance = DataLayerManager ? DataLayerManager->GetDataLayerInstanceFromAssetName(FName(*DataLayerPath)) : nullptr;
+		if (!DataLayerInstance)
+		{
+			UE_LOG(LogTemp, Error, TEXT("WFCBakeCity: data layer %s is not used by %s"), *DataLayerPath, *MapName);
+			return 1;
+		}
+	}
+
+	// A writer subsystem owning the spawned chunks of the current band, and one solver context with its settings per task
+	UWFCSubsystem* Writer = CreateWriter(World, Model, WorldSeed);
+	ON_SCOPE_EXIT
+	{
+		Writer->RemoveFromRoot();
+	};
+	if (!Writer->CompiledModel->IsValid())
+	{
+		return 1;
+	}
+	TArray<FWFCSolverContext> Solvers;
+	const int32 NumSolvers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	Solvers.SetNum(NumSolvers);
+	for (FWFCSolverContext& Solver : Solvers)
+	{
+		Solver.CopySettings(Writer->Solver);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("WFCBakeCity: baking %dx%d chunks from %s into %s with %d solvers, seed %d"),
+		Extent.X, Extent.Y, *Origin.ToString(), *MapName, NumSolvers, WorldSeed);
+
+	const double StartTime = FPlatformTime::Seconds();
+	TMap<FIntVector, FWFCChunk> PrimaryChunks;
+	int32 NumBakedChunks = 0;
+	int32 NumFailedChunks = 0;
+	int32 NumSavedPackages = 0;
+	for (int32 BandMinY = Origin.Y; BandMinY < Origin.Y + Extent.Y; BandMinY += BandRows)
+	{
+		const int32 BandMaxY = FMath::Min(BandMinY + BandRows, Origin.Y + Extent.Y) - 1;
+
+		// Secondary chunks of the band need the primaries one row and one column around it, even outside of the extent,
+		// so border chunks match the runtime generation of the same seed
+		TArray<FIntVector> PrimaryCoords;
+		TArray<FIntVector> SecondaryCoords;
+		for (int32 Y = BandMinY - 1; Y <= BandMaxY + 1; Y++)
+		{
+			for (int32 X = Origin.X - 1; X <= Origin.X + Extent.X; X++)
+			{
+				const FIntVector ChunkCoord(X, Y, 0);
+				if (UWFCSubsystem::IsPrimaryChunk(ChunkCoord))
+				{
+					if (!PrimaryChunks.Contains(ChunkCoord))
+					{
+						PrimaryCoords.Add(ChunkCoord);
+					}
+				}
+				else if (Y >= BandMinY && Y <= BandMaxY && X >= Origin.X && X < Origin.X + Extent.X)
+				{
+					SecondaryCoords.Add(ChunkCoord);
+				}
+			}
+		}
+
+		TArray<FWFCChunk> SolvedChunks;
+		Writer->SolveChunks(PrimaryCoords, Solvers, PrimaryChunks, SolvedChunks);
+		for (int32 ChunkIndex = 0; ChunkIndex < PrimaryCoords.Num(); ChunkIndex++)
+		{
+			PrimaryChunks.Add(PrimaryCoords[ChunkIndex], MoveTemp(SolvedChunks[ChunkIndex]));
+		}
+		Writer->SolveChunks(SecondaryCoords, Solvers, PrimaryChunks, SolvedChunks);
+
+		// Spawn the chunks of the band, primaries first, in the writer context
+		TArray<FWFCChunk> BandChunks;
+		for (const TPair<FIntVector, FWFCChunk>& PrimaryChunk : PrimaryChunks)
+		{
+			const FIntVector& ChunkCoord = PrimaryChunk.Key;
+			if (ChunkCoord.Y >= BandMinY && ChunkCoord.Y <= BandMaxY && ChunkCoord.X >= Origin.X && ChunkCoord.X < Origin.X + Extent.X)
+			{
+				BandChunks.Add(PrimaryChunk.Value);
+			}
+		}
+		BandChunks.Append(MoveTemp(SolvedChunks));
+
+		TArray<UPackage*> PackagesToSave;
+		for (FWFCChunk& Chunk : BandChunks)
+		{
+			if (Chunk.OptionIds.IsEmpty())
+			{
+				UE_LOG(LogTemp, Error, TEXT("WFCBakeCity: could not solve chunk %s"), *Writer->GetChunkCoord(Chunk.MinCell).ToString());
+				NumFailedChunks++;
+				continue;
+			}
+
+			const FIntVector OriginCell = Chunk.OriginCell;
+			Writer->SpawnChunkRecord(MoveTemp(Chunk));
+			const FWFCChunk* SpawnedChunk = Writer->FindChunk(OriginCell);
+			TArray<AActor*, TInlineAllocator<8>> ChunkActors;
+			ChunkActors.Add(SpawnedChunk->Actor.Get());
+			for (const TWeakObjectPtr<AActor>& TileActor : SpawnedChunk->TileActors)
+			{
+				ChunkActors.Add(TileActor.Get());
+			}
+			for (AActor* ChunkActor : ChunkActors)
+			{
+				if (!ChunkActor)
+				{
+					continue;
+				}
+				if (DataLayerInstance)
+				{
+					ChunkActor->AddDataLayer(DataLayerInstance);
+				}
+				if (UPackage* ExternalPackage = ChunkActor->GetExternalPackage())
+				{
+					PackagesToSave.Add(ExternalPackage);
+				}
+			}
+			NumBakedChunks++;
+		}
+
+		// Write the band to disk, then drop its actors before solving the next one
+		if (!PackagesToSave.IsEmpty() && !UEditorLoadingAndSavingUtils::SavePackages(PackagesToSave, false))
+		{
+			UE_LOG(LogTemp, Error, TEXT("WFCBakeCity: could not save the chunks of rows %d to %d"), BandMinY, BandMaxY);
+			return 1;
+		}
+		NumSavedPackages += PackagesToSave.Num();
+		Writer->ClearCity();
+
+		// Only the primaries around the last row are needed by the next band
+		for (auto It = PrimaryChunks.CreateIterator(); It; ++It)
+		{
+			if (It.Key().Y < BandMaxY)
+			{
+				It.RemoveCurrent();
+			}
+		}
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+		UE_LOG(LogTemp, Display, TEXT("WFCBakeCity: rows %d to %d baked, %d chunks in %.1fs"),
+			BandMinY, BandMaxY, NumBakedChunks, FPlatformTime::Seconds() - StartTime);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("WFCBakeCity: %d chunks baked into %d packages, %d failed, in %.1fs"),
+		NumBakedChunks, NumSavedPackages, NumFailedChunks, FPlatformTime::Seconds() - StartTime);
+	return NumFailedChunks == 0 ? 0 : 1;
+#else
+	UE_LOG(LogTemp, Error, TEXT("WFCBakeCity requires an editor build"));
+	return 1;
+#endif
+}
+
+UWFCSubsystem* UWFCBakeCityCommandlet::CreateWriter(UWorld* World, UWaveFunctionCollapseModel* Model, int32 WorldSeed) const
+{
+	const UHackatonCityDeveloperSettings* Settings = GetDefault<UHackatonCityDeveloperSettings>();
+
+	// Baked chunks keep their collision and full geometry, nothing is evicted or swapped for proxies
+	UWFCSubsystem* Writer = NewObject<UWFCSubsystem>(World);
+	Writer->AddToRoot();
+	Writer->WFCModel = Model;
+	Writer->DistrictModel = Cast<UWaveFunctionCollapseModel>(Settings->DistrictModel.TryLoad());
+	Writer->DistrictTileSets = Settings->DistrictTileSets;
+	Writer->DistrictResolution = Settings->DistrictResolution;
+	Writer->DistrictCellSize = Settings->DistrictCellSize;
+	Writer->Solver.Resolution = Settings->WFCResolution;
+	Writer->ChunkEvictionRadius = 0.0f;
+	Writer->ChunkMemoryBudgetMB = 0.0f;
+	Writer->CollisionRadius = 0.0f;
+	Writer->bUseCollisionProxies = Settings->bUseCollisionProxies;
+	Writer->ChunkProxySwapDistance = 0.0f;
+	Writer->bDeterministicGeneration = true;
+	Writer->WorldSeed = WorldSeed;
+	Writer->Solver.ObservationHeuristic = Settings->ObservationHeuristic;
+	Writer->Solver.ObservationNoise = Settings->ObservationNoise;
+	Writer->CompileModel();
+	return Writer;
+}
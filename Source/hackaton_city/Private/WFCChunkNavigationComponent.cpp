@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCChunkNavigationComponent.h"
+#include "hackaton_city/Public/WFCSubsystem.h"
+#include "AI/Navigation/NavCollisionBase.h"
+#include "AI/NavigationSystemHelpers.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "PhysicsEngine/BodySetup.h"
+
+namespace
+{
+	template<typename FunctionType>
+	void ForEachNavigationComponent(const AActor* Owner, FunctionType Function)
+	{
+		if (!Owner)
+		{
+			return;
+		}
+
+		// Only the components that collide once the chunk collision is enabled, collision proxies included
+		for (const UActorComponent* Component : Owner->GetComponents())
+		{
+			const UInstancedStaticMeshComponent* ISMComponent = Cast<UInstancedStaticMeshComponent>(Component);
+			if (ISMComponent && ISMComponent->GetStaticMesh() && ISMComponent->ComponentHasTag(UWFCSubsystem::CollisionComponentTag))
+			{
+				Function(*ISMComponent);
+			}
+		}
+	}
+}
+
+UWFCChunkNavigationComponent::UWFCChunkNavigationComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	Mobility = EComponentMobility::Static;
+	SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
+	SetGenerateOverlapEvents(false);
+	SetCanEverAffectNavigation(true);
+	bHasCustomNavigableGeometry = EHasCustomNavigableGeometry::EvenIfNotCollidable;
+}
+
+FBoxSphereBounds UWFCChunkNavigationComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	FBox Box(ForceInit);
+	ForEachNavigationComponent(GetOwner(), [&Box](const UInstancedStaticMeshComponent& ISMComponent)
+	{
+		// Computed from the instances, the cached bounds of the component may predate its last instances
+		Box += ISMComponent.CalcBounds(ISMComponent.GetComponentTransform()).GetBox();
+	});
+	return Box.IsValid ? FBoxSphereBounds(Box) : FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.0);
+}
+
+bool UWFCChunkNavigationComponent::DoCustomNavigableGeometryExport(FNavigableGeometryExport& GeomExport) const
+{
+	ForEachNavigationComponent(GetOwner(), [&GeomExport](const UInstancedStaticMeshComponent& ISMComponent)
+	{
+		const UStaticMesh* StaticMesh = ISMComponent.GetStaticMesh();
+		const UNavCollisionBase* NavCollision = StaticMesh->GetNavCollision();
+		UBodySetup* BodySetup = StaticMesh->GetBodySetup();
+
+		// Dynamic obstacles carve the navmesh through modifiers, not geometry
+		if (NavCollision && NavCollision->IsDynamicObstacle())
+		{
+			return;
+		}
+
+		// Same choice as UStaticMeshComponent: the convex navigation collision when the mesh has one, the body setup otherwise
+		const bool bExportNavCollision = NavCollision && NavCollision->HasConvexGeometry();
+		for (int32 InstanceIndex = 0; InstanceIndex < ISMComponent.GetInstanceCount(); InstanceIndex++)
+		{
+			FTransform InstanceTransform;
+			ISMComponent.GetInstanceTransform(InstanceIndex, InstanceTransform, true);
+			if (bExportNavCollision)
+			{
+				NavCollision->ExportGeometry(InstanceTransform, GeomExport);
+			}
+			else if (BodySetup)
+			{
+				GeomExport.ExportRigidBodySetup(*BodySetup, InstanceTransform);
+			}
+		}
+	});
+
+	// The component has no geometry of its own to export
+	return false;
+}
@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCChunkProxy.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/MaterialInterface.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshResources.h"
+
+const FName FWFCChunkProxy::MaterialSlotName(TEXT("WFCChunkProxy"));
+
+namespace
+{
+	// Normal of a triangle with the winding of the engine
+	FVector3f GetTriangleNormal(const FVector3f& P0, const FVector3f& P1, const FVector3f& P2)
+	{
+		return ((P2 - P0) ^ (P1 - P0)).GetSafeNormal();
+	}
+
+	void GatherBoxGeometry(const FBox3f& Box, FWFCProxyGeometry& OutGeometry)
+	{
+		for (int32 Corner = 0; Corner < 8; Corner++)
+		{
+			OutGeometry.Positions.Add(FVector3f(
+				(Corner & 1) ? Box.Max.X : Box.Min.X,
+				(Corner & 2) ? Box.Max.Y : Box.Min.Y,
+				(Corner & 4) ? Box.Max.Z : Box.Min.Z));
+		}
+
+		// Corners of each face, wound outwards below
+		static constexpr uint32 Faces[6][4] = {
+			{ 0, 2, 6, 4 }, { 1, 3, 7, 5 },
+			{ 0, 1, 5, 4 }, { 2, 3, 7, 6 },
+			{ 0, 1, 3, 2 }, { 4, 5, 7, 6 } };
+		const FVector3f BoxCenter = Box.GetCenter();
+		for (const uint32 (&Face)[4] : Faces)
+		{
+			const FVector3f FaceCenter = (OutGeometry.Positions[Face[0]] + OutGeometry.Positions[Face[2]]) * 0.5f;
+			const uint32 Triangles[2][3] = { { Face[0], Face[1], Face[2] }, { Face[0], Face[2], Face[3] } };
+			for (const uint32 (&Triangle)[3] : Triangles)
+			{
+				const FVector3f Normal = GetTriangleNormal(OutGeometry.Positions[Triangle[0]], OutGeometry.Positions[Triangle[1]], OutGeometry.Positions[Triangle[2]]);
+				const bool bOutwards = (Normal | (FaceCenter - BoxCenter)) >= 0.0f;
+				OutGeometry.Indices.Append({ Triangle[0], bOutwards ? Triangle[1] : Triangle[2], bOutwards ? Triangle[2] : Triangle[1] });
+			}
+		}
+	}
+}
+
+void FWFCChunkProxy::GatherMeshGeometry(const UStaticMesh* StaticMesh, int32 MaxTriangles, FWFCProxyGeometry& OutGeometry)
+{
+	OutGeometry.Positions.Reset();
+	OutGeometry.Indices.Reset();
+	OutGeometry.Sections.Reset();
+
+	const FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData();
+	if (!RenderData || RenderData->LODResources.IsEmpty())
+	{
+		return;
+	}
+	const FStaticMeshLODResources& LODResources = RenderData->LODResources.Last();
+
+	// Detailed meshes are merged as their bounding box, with the material of their first section
+	if (LODResources.GetNumTriangles() > MaxTriangles)
+	{
+		GatherBoxGeometry(FBox3f(StaticMesh->GetBoundingBox()), OutGeometry);
+		const int32 MaterialIndex = LODResources.Sections.IsEmpty() ? 0 : LODResources.Sections[0].MaterialIndex;
+		OutGeometry.Sections.Add({ 0, OutGeometry.Indices.Num(), FSoftObjectPath(StaticMesh->GetMaterial(MaterialIndex)) });
+		return;
+	}
+
+	// Vertex and index data stay readable on the CPU only for meshes with bAllowCPUAccess, or in the editor
+	const FPositionVertexBuffer& PositionBuffer = LODResources.VertexBuffers.PositionVertexBuffer;
+	if (!PositionBuffer.GetVertexData() || LODResources.IndexBuffer.GetIndexDataSize() == 0)
+	{
+		return;
+	}
+	OutGeometry.Positions.SetNumUninitialized(PositionBuffer.GetNumVertices());
+	for (uint32 VertexIndex = 0; VertexIndex < PositionBuffer.GetNumVertices(); VertexIndex++)
+	{
+		OutGeometry.Positions[VertexIndex] = PositionBuffer.VertexPosition(VertexIndex);
+	}
+	LODResources.IndexBuffer.GetCopy(OutGeometry.Indices);
+	for (const FStaticMeshSection& Section : LODResources.Sections)
+	{
+		if (Section.NumTriangles > 0)
+		{
+			OutGeometry.Sections.Add({ static_cast<int32>(Section.FirstIndex), static_cast<int32>(Section.NumTriangles * 3), FSoftObjectPath(StaticMesh->GetMaterial(Section.MaterialIndex)) });
+		}
+	}
+}
+
+void FWFCChunkProxy::BuildMeshDescription(const TArray<FWFCProxyInstances>& Instances, FWFCProxyMesh& OutProxyMesh)
+{
+	FMeshDescription& OutMeshDescription = OutProxyMesh.MeshDescription;
+	FStaticMeshAttributes Attributes(OutMeshDescription);
+	Attributes.Register();
+
+	TVertexAttributesRef<FVector3f> VertexPositions = Attributes.GetVertexPositions();
+	TVertexInstanceAttributesRef<FVector3f> VertexNormals = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesRef<FVector3f> VertexTangents = Attributes.GetVertexInstanceTangents();
+	TVertexInstanceAttributesRef<float> VertexBinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+	TVertexInstanceAttributesRef<FVector2f> VertexUVs = Attributes.GetVertexInstanceUVs();
+	VertexUVs.SetNumChannels(1);
+
+	int32 NumTriangles = 0;
+	for (const FWFCProxyInstances& MeshInstances : Instances)
+	{
+		NumTriangles += MeshInstances.Geometry->Indices.Num() / 3 * MeshInstances.Transforms.Num();
+	}
+	OutMeshDescription.ReserveNewVertices(NumTriangles * 3);
+	OutMeshDescription.ReserveNewVertexInstances(NumTriangles * 3);
+	OutMeshDescription.ReserveNewTriangles(NumTriangles);
+
+	// One polygon group per material, in order of first use
+	TMap<FSoftObjectPath, FPolygonGroupID> MaterialPolygonGroups;
+	OutProxyMesh.Materials.Reset();
+	for (const FWFCProxyInstances& MeshInstances : Instances)
+	{
+		for (const FWFCProxySection& Section : MeshInstances.Geometry->Sections)
+		{
+			if (!MaterialPolygonGroups.Contains(Section.Material))
+			{
+				const FPolygonGroupID PolygonGroup = OutMeshDescription.CreatePolygonGroup();
+				Attributes.GetPolygonGroupMaterialSlotNames()[PolygonGroup] = GetMaterialSlotName(OutProxyMesh.Materials.Num());
+				MaterialPolygonGroups.Add(Section.Material, PolygonGroup);
+				OutProxyMesh.Materials.Add(Section.Material);
+			}
+		}
+	}
+
+	// Flat shaded, every triangle gets its own vertices
+	for (const FWFCProxyInstances& MeshInstances : Instances)
+	{
+		const FWFCProxyGeometry& Geometry = *MeshInstances.Geometry;
+		for (const FTransform& Transform : MeshInstances.Transforms)
+		{
+			// Mirroring transforms flip the winding
+			const bool bFlipWinding = Transform.GetDeterminant() < 0.0f;
+			for (const FWFCProxySection& Section : Geometry.Sections)
+			{
+				const FPolygonGroupID PolygonGroup = MaterialPolygonGroups[Section.Material];
+				const int32 EndIndex = FMath::Min(Section.FirstIndex + Section.NumIndices, Geometry.Indices.Num());
+				for (int32 Index = Section.FirstIndex; Index + 2 < EndIndex; Index += 3)
+				{
+					FVector3f Corners[3];
+					for (int32 Corner = 0; Corner < 3; Corner++)
+					{
+						Corners[Corner] = FVector3f(Transform.TransformPosition(FVector(Geometry.Positions[Geometry.Indices[Index + Corner]])));
+					}
+					if (bFlipWinding)
+					{
+						Swap(Corners[1], Corners[2]);
+					}
+
+					const FVector3f Normal = GetTriangleNormal(Corners[0], Corners[1], Corners[2]);
+					if (Normal.IsZero())
+					{
+						continue;
+					}
+					const FVector3f Tangent = (Corners[1] - Corners[0]).GetSafeNormal();
+
+					FVertexInstanceID TriangleInstances[3];
+					for (int32 Corner = 0; Corner < 3; Corner++)
+					{
+						const FVertexID VertexID = OutMeshDescription.CreateVertex();
+						VertexPositions[VertexID] = Corners[Corner];
+
+						const FVertexInstanceID VertexInstanceID = OutMeshDescription.CreateVertexInstance(VertexID);
+						VertexNormals[VertexInstanceID] = Normal;
+						VertexTangents[VertexInstanceID] = Tangent;
+						VertexBinormalSigns[VertexInstanceID] = 1.0f;
+						VertexUVs.Set(VertexInstanceID, 0, FVector2f(Corners[Corner].X, Corners[Corner].Y) / 100.0f);
+						TriangleInstances[Corner] = VertexInstanceID;
+					}
+					OutMeshDescription.CreateTriangle(PolygonGroup, MakeArrayView(TriangleInstances));
+				}
+			}
+		}
+	}
+}
+
+FName FWFCChunkProxy::GetMaterialSlotName(int32 MaterialIndex)
+{
+	return FName(MaterialSlotName, NAME_EXTERNAL_TO_INTERNAL(MaterialIndex));
+}
+
+uint32 FWFCChunkProxy::GetLayoutHash(const FWFCChunk& Chunk, uint32 ModelHash, float TileSize)
+{
+	uint32 Hash = FCrc::MemCrc32(Chunk.OptionIds.GetData(), Chunk.OptionIds.Num() * Chunk.OptionIds.GetTypeSize());
+	Hash = HashCombine(Hash, ModelHash);
+	Hash = HashCombine(Hash, GetTypeHash(TileSize));
+	Hash = HashCombine(Hash, GetTypeHash(Chunk.Size));
+	Hash = HashCombine(Hash, GetTypeHash(Chunk.MinCell - Chunk.OriginCell));
+	return Hash;
+}
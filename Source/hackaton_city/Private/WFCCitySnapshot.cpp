@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCCitySnapshot.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+
+namespace
+{
+	void SerializeChunkRecord(FArchive& Ar, FWFCChunk& Chunk)
+	{
+		Ar << Chunk.OriginCell;
+		Ar << Chunk.Seed;
+		Ar << Chunk.MinCell;
+		Ar << Chunk.Size;
+		Ar << Chunk.bDeterministic;
+
+		// Deterministic chunks are solved again from their seed, their option IDs are not stored
+		int32 NumCells = Chunk.bDeterministic ? 0 : Chunk.OptionIds.Num();
+		Ar << NumCells;
+		const int64 NumBytes = static_cast<int64>(NumCells) * static_cast<int64>(sizeof(uint16));
+		if (Ar.IsLoading())
+		{
+			const bool bValidNumCells = NumCells == Chunk.Size.X * Chunk.Size.Y * Chunk.Size.Z || (Chunk.bDeterministic && NumCells == 0);
+			if (NumCells < 0 || !bValidNumCells || NumBytes > Ar.TotalSize() - Ar.Tell())
+			{
+				Ar.SetError();
+				return;
+			}
+			Chunk.OptionIds.SetNumUninitialized(NumCells);
+		}
+		Ar.Serialize(Chunk.OptionIds.GetData(), NumBytes);
+	}
+}
+
+FString FWFCCitySnapshot::GetSlotFilename(const FString& SlotName)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("WFCCities"), SlotName + TEXT(".wfccity"));
+}
+
+bool FWFCCitySnapshot::Save(const FString& Filename, const FWFCCompiledModel& CompiledModel, const FIntVector& Resolution, const TMap<FIntVector, FWFCChunk>& Chunks, int32 WorldSeed)
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unable to write city snapshot: %s"), *Filename);
+		return false;
+	}
+
+	// Header
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	uint32 ModelHash = CompiledModel.ModelHash;
+	float TileSize = CompiledModel.TileSize;
+	FIntVector FileResolution = Resolution;
+	int32 NumOptions = CompiledModel.NumOptions();
+	int32 NumChunks = Chunks.Num();
+	*Writer << FileMagic << FileVersion << ModelHash << TileSize << FileResolution << NumOptions << NumChunks << WorldSeed;
+
+	// Palette
+	for (const FWaveFunctionCollapseOption& Option : CompiledModel.Options)
+	{
+		FString BaseObject = Option.BaseObject.ToString();
+		FRotator BaseRotator = Option.BaseRotator;
+		FVector BaseScale3D = Option.BaseScale3D;
+		*Writer << BaseObject << BaseRotator << BaseScale3D;
+	}
+
+	// Chunk records
+	for (const TPair<FIntVector, FWFCChunk>& ChunkPair : Chunks)
+	{
+		SerializeChunkRecord(*Writer, const_cast<FWFCChunk&>(ChunkPair.Value));
+	}
+
+	return Writer->Close();
+}
+
+bool FWFCCitySnapshot::Load(const FString& Filename, const FWFCCompiledModel& CompiledModel, const FIntVector& Resolution, TArray<FWFCChunk>& OutChunks, int32& OutWorldSeed)
+{
+	// Map the file when the platform supports it, otherwise read it in one go
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> FileData;
+	TArrayView<const uint8> FileView;
+
+	FOpenMappedResult OpenResult = FPlatformFileManager::Get().GetPlatformFile().OpenMappedEx(*Filename);
+	if (OpenResult.HasValue())
+	{
+		MappedFile = OpenResult.StealValue();
+		if (MappedFile->GetFileSize() > 0)
+		{
+			MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+		}
+	}
+	if (MappedRegion)
+	{
+		FileView = MakeArrayView(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+	}
+	else if (FFileHelper::LoadFileToArray(FileData, *Filename))
+	{
+		FileView = FileData;
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unable to read city snapshot: %s"), *Filename);
+		return false;
+	}
+
+	FMemoryReaderView Reader(FileView);
+
+	// Header
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	uint32 ModelHash = 0;
+	float TileSize = 0.0f;
+	FIntVector FileResolution = FIntVector::ZeroValue;
+	int32 NumOptions = 0;
+	int32 NumChunks = 0;
+	int32 FileWorldSeed = 0;
+	Reader << FileMagic << FileVersion << ModelHash << TileSize << FileResolution << NumOptions << NumChunks << FileWorldSeed;
+	if (Reader.IsError() || FileMagic != Magic || FileVersion != Version || NumOptions < 0 || NumChunks < 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid city snapshot: %s"), *Filename);
+		return false;
+	}
+	// Chunk layouts and deterministic seeds depend on the solve window
+	if (FileResolution != Resolution)
+	{
+		UE_LOG(LogTemp, Error, TEXT("City snapshot resolution %dx%dx%d differs from the current resolution %dx%dx%d: %s"),
+			FileResolution.X, FileResolution.Y, FileResolution.Z, Resolution.X, Resolution.Y, Resolution.Z, *Filename);
+		return false;
+	}
+	if (TileSize != CompiledModel.TileSize)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("City snapshot tile size %f differs from the model tile size %f"), TileSize, CompiledModel.TileSize);
+	}
+
+	// Palette, only remapped when the model changed since the snapshot was saved
+	const bool bRemapOptions = ModelHash != CompiledModel.ModelHash || NumOptions != CompiledModel.NumOptions();
+	TArray<uint16> FileToModelOptionId;
+	int32 NumMissingOptions = 0;
+	for (int32 Index = 0; Index < NumOptions; Index++)
+	{
+		FString BaseObject;
+		FRotator BaseRotator;
+		FVector BaseScale3D;
+		Reader << BaseObject << BaseRotator << BaseScale3D;
+		if (bRemapOptions)
+		{
+			FWaveFunctionCollapseOption Option;
+			Option.BaseObject = FSoftObjectPath(BaseObject);
+			Option.BaseRotator = BaseRotator;
+			Option.BaseScale3D = BaseScale3D;
+			const uint16 OptionId = CompiledModel.FindOptionId(Option);
+			NumMissingOptions += OptionId == FWFCCompiledModel::InvalidOptionId ? 1 : 0;
+			FileToModelOptionId.Add(OptionId);
+		}
+	}
+	if (bRemapOptions)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("City snapshot was saved with another model, remapping %d options (%d missing)"), NumOptions, NumMissingOptions);
+	}
+
+	// Chunk records
+	OutChunks.Reset(static_cast<int32>(FMath::Min<int64>(NumChunks, Reader.TotalSize() - Reader.Tell())));
+	for (int32 Index = 0; Index < NumChunks && !Reader.IsError(); Index++)
+	{
+		FWFCChunk& Chunk = OutChunks.AddDefaulted_GetRef();
+		SerializeChunkRecord(Reader, Chunk);
+		if (bRemapOptions)
+		{
+			for (uint16& OptionId : Chunk.OptionIds)
+			{
+				OptionId = FileToModelOptionId.IsValidIndex(OptionId) ? FileToModelOptionId[OptionId] : FWFCCompiledModel::InvalidOptionId;
+			}
+		}
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Truncated city snapshot: %s"), *Filename);
+		OutChunks.Reset();
+		return false;
+	}
+	OutWorldSeed = FileWorldSeed;
+	return true;
+}
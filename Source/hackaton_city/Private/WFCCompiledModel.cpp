@@ -0,0 +1,284 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCCompiledModel.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	// Compiled models in use by any world, keyed by model hash
+	FCriticalSection SharedModelsLock;
+	TMap<uint32, TWeakPtr<const FWFCCompiledModel, ESPMode::ThreadSafe>> SharedModels;
+
+	bool OptionLess(const FWaveFunctionCollapseOption& A, const FWaveFunctionCollapseOption& B)
+	{
+		const int32 PathCompare = A.BaseObject.ToString().Compare(B.BaseObject.ToString());
+		if (PathCompare != 0)
+		{
+			return PathCompare < 0;
+		}
+		if (A.BaseRotator.Yaw != B.BaseRotator.Yaw)
+		{
+			return A.BaseRotator.Yaw < B.BaseRotator.Yaw;
+		}
+		if (A.BaseRotator.Pitch != B.BaseRotator.Pitch)
+		{
+			return A.BaseRotator.Pitch < B.BaseRotator.Pitch;
+		}
+		if (A.BaseRotator.Roll != B.BaseRotator.Roll)
+		{
+			return A.BaseRotator.Roll < B.BaseRotator.Roll;
+		}
+		if (A.BaseScale3D.X != B.BaseScale3D.X)
+		{
+			return A.BaseScale3D.X < B.BaseScale3D.X;
+		}
+		if (A.BaseScale3D.Y != B.BaseScale3D.Y)
+		{
+			return A.BaseScale3D.Y < B.BaseScale3D.Y;
+		}
+		return A.BaseScale3D.Z < B.BaseScale3D.Z;
+	}
+}
+
+void FWFCCompiledModel::Compile(const UWaveFunctionCollapseModel* Model)
+{
+	Options.Reset();
+	OptionToId.Reset();
+	ModelHash = 0;
+	TileSize = 0.0f;
+	NumMaskWords = 0;
+	AdjacencyMasks.Reset();
+	Weights.Reset();
+	WeightLogWeights.Reset();
+	InitialOptionIds.Reset();
+	SpawnExclusion.Reset();
+	for (int32 Face = 0; Face < NumFaces; Face++)
+	{
+		BorderMasks[Face].Reset();
+		EmptyBorderMasks[Face].Reset();
+	}
+
+	if (!Model)
+	{
+		return;
+	}
+	TileSize = Model->TileSize;
+
+	// Gather every option referenced by the model, constraint keys and adjacent options alike
+	TSet<FWaveFunctionCollapseOption> UniqueOptions;
+	for (const TPair<FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap>& Constraint : Model->Constraints)
+	{
+		UniqueOptions.Add(Constraint.Key);
+		for (const TPair<EWaveFunctionCollapseAdjacency, FWaveFunctionCollapseOptions>& Adjacency : Constraint.Value.AdjacencyToOptionsMap)
+		{
+			UniqueOptions.Append(Adjacency.Value.Options);
+		}
+	}
+
+	if (UniqueOptions.Num() >= InvalidOptionId)
+	{
+		UE_LOG(LogTemp, Error, TEXT("WFC Model %s has too many options to compile: %d"), *Model->GetName(), UniqueOptions.Num());
+		return;
+	}
+
+	Options = UniqueOptions.Array();
+	Options.Sort(&OptionLess);
+	OptionToId.Reserve(Options.Num());
+	for (int32 OptionId = 0; OptionId < Options.Num(); OptionId++)
+	{
+		OptionToId.Add(Options[OptionId], static_cast<uint16>(OptionId));
+	}
+
+	// Weights and the initial tile, so solves never read the model
+	Weights.SetNumZeroed(Options.Num());
+	WeightLogWeights.SetNumZeroed(Options.Num());
+	for (int32 OptionId = 0; OptionId < Options.Num(); OptionId++)
+	{
+		const FWaveFunctionCollapseAdjacencyToOptionsMap* AdjacencyToOptionsMap = Model->Constraints.Find(Options[OptionId]);
+		Weights[OptionId] = AdjacencyToOptionsMap ? AdjacencyToOptionsMap->Weight : 0.0f;
+		WeightLogWeights[OptionId] = Weights[OptionId] > 0.0f ? Weights[OptionId] * FMath::Loge(Weights[OptionId]) : 0.0f;
+	}
+	for (const TPair<FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap>& Constraint : Model->Constraints)
+	{
+		if (Constraint.Key.BaseObject != FWaveFunctionCollapseOption::BorderOption.BaseObject)
+		{
+			InitialOptionIds.Add(OptionToId.FindChecked(Constraint.Key));
+		}
+	}
+	SpawnExclusion.Append(Model->SpawnExclusion);
+
+	// Hash the palette together with weights and adjacency IDs
+	TArray<uint32> HashData;
+	for (const FWaveFunctionCollapseOption& Option : Options)
+	{
+		HashData.Add(FCrc::StrCrc32(*FString::Printf(TEXT("%s|%f|%f|%f|%f|%f|%f"),
+			*Option.BaseObject.ToString(),
+			Option.BaseRotator.Pitch, Option.BaseRotator.Yaw, Option.BaseRotator.Roll,
+			Option.BaseScale3D.X, Option.BaseScale3D.Y, Option.BaseScale3D.Z)));
+
+		if (const FWaveFunctionCollapseAdjacencyToOptionsMap* AdjacencyToOptionsMap = Model->Constraints.Find(Option))
+		{
+			HashData.Add(GetTypeHash(AdjacencyToOptionsMap->Weight));
+			for (uint8 Adjacency = 0; Adjacency <= static_cast<uint8>(EWaveFunctionCollapseAdjacency::Down); Adjacency++)
+			{
+				TArray<uint16> AdjacentIds;
+				if (const FWaveFunctionCollapseOptions* AdjacentOptions = AdjacencyToOptionsMap->AdjacencyToOptionsMap.Find(static_cast<EWaveFunctionCollapseAdjacency>(Adjacency)))
+				{
+					for (const FWaveFunctionCollapseOption& AdjacentOption : AdjacentOptions->Options)
+					{
+						AdjacentIds.Add(OptionToId.FindChecked(AdjacentOption));
+					}
+				}
+				AdjacentIds.Sort();
+				HashData.Add(Adjacency);
+				for (uint16 AdjacentId : AdjacentIds)
+				{
+					HashData.Add(AdjacentId);
+				}
+			}
+		}
+	}
+	HashData.Add(GetTypeHash(TileSize));
+
+	// The order of the initial tile changes the solves, the spawn exclusions their success
+	for (uint16 OptionId : InitialOptionIds)
+	{
+		HashData.Add(OptionId);
+	}
+	TArray<FString> SpawnExclusionPaths;
+	for (const FSoftObjectPath& ExcludedObject : SpawnExclusion)
+	{
+		SpawnExclusionPaths.Add(ExcludedObject.ToString());
+	}
+	SpawnExclusionPaths.Sort();
+	for (const FString& ExcludedPath : SpawnExclusionPaths)
+	{
+		HashData.Add(FCrc::StrCrc32(*ExcludedPath));
+	}
+	ModelHash = FCrc::MemCrc32(HashData.GetData(), HashData.Num() * HashData.GetTypeSize());
+
+	// Adjacency masks, the adjacency lists of every option as bits
+	const int32 NumWords = FMath::DivideAndRoundUp(Options.Num(), 64);
+	NumMaskWords = NumWords <= 1 ? 1 : (NumWords <= 2 ? 2 : (NumWords <= 4 ? 4 : NumWords));
+	AdjacencyMasks.SetNumZeroed(Options.Num() * NumFaces * NumMaskWords);
+	for (int32 OptionId = 0; OptionId < Options.Num(); OptionId++)
+	{
+		const FWaveFunctionCollapseAdjacencyToOptionsMap* AdjacencyToOptionsMap = Model->Constraints.Find(Options[OptionId]);
+		if (!AdjacencyToOptionsMap)
+		{
+			continue;
+		}
+		for (int32 Face = 0; Face < NumFaces; Face++)
+		{
+			if (const FWaveFunctionCollapseOptions* AdjacentOptions = AdjacencyToOptionsMap->AdjacencyToOptionsMap.Find(static_cast<EWaveFunctionCollapseAdjacency>(Face)))
+			{
+				uint64* Mask = &AdjacencyMasks[(OptionId * NumFaces + Face) * NumMaskWords];
+				for (const FWaveFunctionCollapseOption& AdjacentOption : AdjacentOptions->Options)
+				{
+					const uint16 AdjacentId = OptionToId.FindChecked(AdjacentOption);
+					Mask[AdjacentId >> 6] |= uint64(1) << (AdjacentId & 63);
+				}
+			}
+		}
+	}
+
+	// Border masks, the adjacency lists of the border and empty options as bits
+	auto BuildFaceMasks = [this, Model](const FWaveFunctionCollapseOption& OutsideOption, TBitArray<> (&OutMasks)[NumFaces])
+	{
+		const FWaveFunctionCollapseAdjacencyToOptionsMap* AdjacencyToOptionsMap = Model->Constraints.Find(OutsideOption);
+		if (!AdjacencyToOptionsMap)
+		{
+			return;
+		}
+		for (int32 Face = 0; Face < NumFaces; Face++)
+		{
+			if (const FWaveFunctionCollapseOptions* AdjacentOptions = AdjacencyToOptionsMap->AdjacencyToOptionsMap.Find(static_cast<EWaveFunctionCollapseAdjacency>(Face)))
+			{
+				OutMasks[Face].Init(false, Options.Num());
+				for (const FWaveFunctionCollapseOption& AdjacentOption : AdjacentOptions->Options)
+				{
+					OutMasks[Face][OptionToId.FindChecked(AdjacentOption)] = true;
+				}
+			}
+		}
+	};
+	BuildFaceMasks(FWaveFunctionCollapseOption::BorderOption, BorderMasks);
+	BuildFaceMasks(FWaveFunctionCollapseOption::EmptyOption, EmptyBorderMasks);
+}
+
+TSharedRef<const FWFCCompiledModel> FWFCCompiledModel::CompileShared(const UWaveFunctionCollapseModel* Model)
+{
+	TSharedRef<FWFCCompiledModel> CompiledModel = MakeShared<FWFCCompiledModel>();
+	CompiledModel->Compile(Model);
+	if (!CompiledModel->IsValid())
+	{
+		return CompiledModel;
+	}
+
+	FScopeLock Lock(&SharedModelsLock);
+	if (TSharedPtr<const FWFCCompiledModel> SharedModel = SharedModels.FindRef(CompiledModel->ModelHash).Pin())
+	{
+		if (SharedModel->Options == CompiledModel->Options)
+		{
+			return SharedModel.ToSharedRef();
+		}
+	}
+
+	// Drop the models no world uses anymore
+	for (auto It = SharedModels.CreateIterator(); It; ++It)
+	{
+		if (!It->Value.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	SharedModels.Add(CompiledModel->ModelHash, CompiledModel);
+	return CompiledModel;
+}
+
+uint16 FWFCCompiledModel::FindOptionId(const FWaveFunctionCollapseOption& Option) const
+{
+	const uint16* FoundId = OptionToId.Find(Option);
+	return FoundId ? *FoundId : InvalidOptionId;
+}
+
+const FWaveFunctionCollapseOption* FWFCCompiledModel::GetOption(uint16 OptionId) const
+{
+	return Options.IsValidIndex(OptionId) ? &Options[OptionId] : nullptr;
+}
+
+float FWFCCompiledModel::CalculateShannonEntropy(const TArray<FWaveFunctionCollapseOption>& TileOptions) const
+{
+	TArray<uint16, TInlineAllocator<64>> TileOptionIds;
+	for (const FWaveFunctionCollapseOption& Option : TileOptions)
+	{
+		TileOptionIds.Add(FindOptionId(Option));
+	}
+	return CalculateShannonEntropy(TileOptionIds);
+}
+
+float FWFCCompiledModel::CalculateShannonEntropy(TConstArrayView<uint16> TileOptionIds) const
+{
+	float SumWeights = 0.0f;
+	float SumWeightLogWeights = 0.0f;
+	for (const uint16 OptionId : TileOptionIds)
+	{
+		if (OptionId != InvalidOptionId)
+		{
+			SumWeights += Weights[OptionId];
+			SumWeightLogWeights += WeightLogWeights[OptionId];
+		}
+	}
+	if (SumWeights <= 0.0f)
+	{
+		return -1.0f;
+	}
+	return FMath::Loge(SumWeights) - SumWeightLogWeights / SumWeights;
+}
+
+bool FWFCCompiledModel::IsObjectSpawnable(const FSoftObjectPath& BaseObject) const
+{
+	return !(BaseObject == FWaveFunctionCollapseOption::EmptyOption.BaseObject
+		|| BaseObject == FWaveFunctionCollapseOption::VoidOption.BaseObject
+		|| SpawnExclusion.Contains(BaseObject));
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCPlacedTiles.h"
+
+FIntVector FWFCPlacedTiles::GetPageCoord(const FIntVector& AbsoluteCell)
+{
+	return FIntVector(FMath::DivideAndRoundDown(AbsoluteCell.X, PageSize), FMath::DivideAndRoundDown(AbsoluteCell.Y, PageSize), AbsoluteCell.Z);
+}
+
+int32 FWFCPlacedTiles::GetPageCellIndex(const FIntVector& AbsoluteCell, const FIntVector& PageCoord)
+{
+	return (AbsoluteCell.X - PageCoord.X * PageSize) + (AbsoluteCell.Y - PageCoord.Y * PageSize) * PageSize;
+}
+
+void FWFCPlacedTiles::Add(const FIntVector& AbsoluteCell, uint16 OptionId)
+{
+	check(OptionId != FWFCCompiledModel::InvalidOptionId);
+
+	const FIntVector PageCoord = GetPageCoord(AbsoluteCell);
+	FPage* Page = Pages.Find(PageCoord);
+	if (!Page)
+	{
+		Page = &Pages.Add(PageCoord);
+		for (uint16& PageOptionId : Page->OptionIds)
+		{
+			PageOptionId = FWFCCompiledModel::InvalidOptionId;
+		}
+	}
+
+	uint16& CellOptionId = Page->OptionIds[GetPageCellIndex(AbsoluteCell, PageCoord)];
+	if (CellOptionId == FWFCCompiledModel::InvalidOptionId)
+	{
+		Page->NumCells++;
+		NumCells++;
+	}
+	CellOptionId = OptionId;
+}
+
+bool FWFCPlacedTiles::Remove(const FIntVector& AbsoluteCell)
+{
+	const FIntVector PageCoord = GetPageCoord(AbsoluteCell);
+	FPage* Page = Pages.Find(PageCoord);
+	if (!Page)
+	{
+		return false;
+	}
+
+	uint16& CellOptionId = Page->OptionIds[GetPageCellIndex(AbsoluteCell, PageCoord)];
+	if (CellOptionId == FWFCCompiledModel::InvalidOptionId)
+	{
+		return false;
+	}
+	CellOptionId = FWFCCompiledModel::InvalidOptionId;
+	NumCells--;
+
+	// Evicted areas give their pages back
+	if (--Page->NumCells == 0)
+	{
+		Pages.Remove(PageCoord);
+	}
+	return true;
+}
+
+uint16 FWFCPlacedTiles::Find(const FIntVector& AbsoluteCell) const
+{
+	const FIntVector PageCoord = GetPageCoord(AbsoluteCell);
+	const FPage* Page = Pages.Find(PageCoord);
+	return Page ? Page->OptionIds[GetPageCellIndex(AbsoluteCell, PageCoord)] : FWFCCompiledModel::InvalidOptionId;
+}
+
+const uint16* FWFCPlacedTiles::FindPage(const FIntVector& PageCoord) const
+{
+	const FPage* Page = Pages.Find(PageCoord);
+	return Page ? Page->OptionIds : nullptr;
+}
+
+void FWFCPlacedTiles::Empty()
+{
+	Pages.Empty();
+	NumCells = 0;
+}
+
+SIZE_T FWFCPlacedTiles::GetAllocatedSize() const
+{
+	return Pages.GetAllocatedSize();
+}
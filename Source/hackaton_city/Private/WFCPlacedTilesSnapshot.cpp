@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCPlacedTilesSnapshot.h"
+
+uint16 FWFCPlacedTilesSnapshot::Find(const FIntVector& AbsoluteCell) const
+{
+	const FIntVector PageCoord = FWFCPlacedTiles::GetPageCoord(AbsoluteCell);
+	const TSharedRef<const FPage>* Page = Pages.Find(PageCoord);
+	return Page ? (**Page)[FWFCPlacedTiles::GetPageCellIndex(AbsoluteCell, PageCoord)] : FWFCCompiledModel::InvalidOptionId;
+}
+
+void FWFCPlacedTilesPublisher::Publish(const FWFCPlacedTiles& PlacedTiles, const TSharedRef<const FWFCCompiledModel>& CompiledModel, const FIntVector& MinCell, const FIntVector& MaxCell)
+{
+	TSharedPtr<FWFCPlacedTilesSnapshot> Snapshot(new FWFCPlacedTilesSnapshot(++LatestVersion, CompiledModel));
+	if (Latest)
+	{
+		Snapshot->Pages = Latest->Pages;
+	}
+
+	// Only the pages overlapping the changed cells are copied again
+	const FIntVector MinPage = FWFCPlacedTiles::GetPageCoord(MinCell);
+	const FIntVector MaxPage = FWFCPlacedTiles::GetPageCoord(MaxCell);
+	for (int32 Z = MinPage.Z; Z <= MaxPage.Z; Z++)
+	{
+		for (int32 Y = MinPage.Y; Y <= MaxPage.Y; Y++)
+		{
+			for (int32 X = MinPage.X; X <= MaxPage.X; X++)
+			{
+				const FIntVector PageCoord(X, Y, Z);
+				if (const uint16* PageOptionIds = PlacedTiles.FindPage(PageCoord))
+				{
+					TSharedRef<FWFCPlacedTilesSnapshot::FPage> Page = MakeShared<FWFCPlacedTilesSnapshot::FPage>();
+					FMemory::Memcpy(Page->GetData(), PageOptionIds, sizeof(FWFCPlacedTilesSnapshot::FPage));
+					Snapshot->Pages.Add(PageCoord, Page);
+				}
+				else
+				{
+					Snapshot->Pages.Remove(PageCoord);
+				}
+			}
+		}
+	}
+
+	Latest = Snapshot;
+	Store();
+}
+
+void FWFCPlacedTilesPublisher::PublishEmpty(const TSharedRef<const FWFCCompiledModel>& CompiledModel)
+{
+	Latest = MakeShareable(new FWFCPlacedTilesSnapshot(++LatestVersion, CompiledModel));
+	Store();
+}
+
+void FWFCPlacedTilesPublisher::FlushPending()
+{
+	if (bPending)
+	{
+		Store();
+	}
+}
+
+void FWFCPlacedTilesPublisher::Store()
+{
+	const int32 Current = CurrentSlot.load();
+	for (int32 Offset = 1; Offset <= NumSlots; Offset++)
+	{
+		const int32 SlotIndex = (FMath::Max(Current, 0) + Offset) % NumSlots;
+		if (SlotIndex == Current)
+		{
+			continue;
+		}
+
+		// Take the slot first, then look for readers.  A reader registering after this check sees the slot taken.
+		FSlot& Slot = Slots[SlotIndex];
+		Slot.Version.store(0);
+		if (Slot.NumReaders.load() != 0)
+		{
+			continue;
+		}
+		Slot.Snapshot = Latest;
+		Slot.Version.store(LatestVersion);
+		CurrentSlot.store(SlotIndex);
+		bPending = false;
+		return;
+	}
+
+	// Every other slot has a reader copying its pointer right now, the version is stored on the next publication or flush
+	bPending = true;
+}
+
+TSharedPtr<const FWFCPlacedTilesSnapshot> FWFCPlacedTilesPublisher::Acquire() const
+{
+	for (;;)
+	{
+		const int32 SlotIndex = CurrentSlot.load();
+		if (SlotIndex == INDEX_NONE)
+		{
+			return nullptr;
+		}
+
+		FSlot& Slot = Slots[SlotIndex];
+		Slot.NumReaders.fetch_add(1);
+		TSharedPtr<const FWFCPlacedTilesSnapshot> Snapshot;
+		if (Slot.Version.load() != 0 && CurrentSlot.load() == SlotIndex)
+		{
+			Snapshot = Slot.Snapshot;
+		}
+		Slot.NumReaders.fetch_sub(1);
+
+		// The slot was taken by a newer publication in the meantime
+		if (Snapshot)
+		{
+			return Snapshot;
+		}
+	}
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCReplication.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "hackaton_city/Public/WFCSubsystem.h"
+
+uint32 FWFCGenerationEvent::GetChunkChecksum(const FWFCChunk& Chunk)
+{
+	return FCrc::MemCrc32(Chunk.OptionIds.GetData(), Chunk.OptionIds.Num() * Chunk.OptionIds.GetTypeSize());
+}
+
+void FWFCGenerationEventArray::PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize)
+{
+	if (Owner)
+	{
+		Owner->OnEventsReplicated();
+	}
+}
+
+AWFCGenerationReplicator::AWFCGenerationReplicator()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	Events.Owner = this;
+}
+
+void AWFCGenerationReplicator::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UWFCSubsystem* WFCSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>())
+	{
+		WFCSubsystem->SetGenerationReplicator(this);
+	}
+}
+
+void AWFCGenerationReplicator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AWFCGenerationReplicator, Events);
+}
+
+void AWFCGenerationReplicator::AddEvent(FWFCGenerationEvent&& Event)
+{
+	Events.MarkItemDirty(Events.Events.Add_GetRef(MoveTemp(Event)));
+}
+
+void AWFCGenerationReplicator::OnEventsReplicated()
+{
+	// Events can arrive before BeginPlay, they are applied once the subsystem knows this actor
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+	if (UWFCSubsystem* WFCSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>())
+	{
+		WFCSubsystem->ApplyGenerationEvents();
+	}
+}
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCSessionJournal.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+FString FWFCSessionJournal::GetSlotFilename(const FString& SlotName)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("WFCJournals"), SlotName + TEXT(".wfcjournal"));
+}
+
+bool FWFCSessionJournal::Save(const FString& Filename) const
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unable to write session journal: %s"), *Filename);
+		return false;
+	}
+
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	int32 FileWorldSeed = WorldSeed;
+	uint32 FileSolverSettingsHash = SolverSettingsHash;
+	int32 FileNumChunksAtStart = NumChunksAtStart;
+	int32 NumEntries = Entries.Num();
+	*Writer << FileMagic << FileVersion << FileWorldSeed << FileSolverSettingsHash << FileNumChunksAtStart << NumEntries;
+	for (const FWFCJournalEntry& Entry : Entries)
+	{
+		*Writer << const_cast<FWFCJournalEntry&>(Entry);
+	}
+
+	return Writer->Close();
+}
+
+bool FWFCSessionJournal::Load(const FString& Filename)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Reader)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unable to read session journal: %s"), *Filename);
+		return false;
+	}
+
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	int32 NumEntries = 0;
+	*Reader << FileMagic << FileVersion << WorldSeed << SolverSettingsHash << NumChunksAtStart << NumEntries;
+	if (Reader->IsError() || FileMagic != Magic || FileVersion < 1 || FileVersion > Version || NumEntries < 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid session journal: %s"), *Filename);
+		return false;
+	}
+
+	Entries.Reset(static_cast<int32>(FMath::Min<int64>(NumEntries, Reader->TotalSize() - Reader->Tell())));
+	for (int32 Index = 0; Index < NumEntries && !Reader->IsError(); Index++)
+	{
+		*Reader << Entries.AddDefaulted_GetRef();
+	}
+
+	if (Reader->IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Truncated session journal: %s"), *Filename);
+		Entries.Reset();
+		return false;
+	}
+	return true;
+}
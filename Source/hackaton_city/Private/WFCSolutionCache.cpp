@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCSolutionCache.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+
+namespace
+{
+	void SerializeEntry(FArchive& Ar, FWFCBoundarySignature& Signature, FWFCCachedSolution& Solution)
+	{
+		Ar << Signature.ModelHash;
+		Ar << Signature.Resolution;
+		Ar << Signature.Seed;
+		Ar << Signature.TryCount;
+		Ar << Signature.SolverSettingsHash;
+		Ar << Signature.BoundaryCells;
+		Ar << Signature.DistrictIds;
+		Ar << Solution.bSolved;
+		Ar << Solution.Seed;
+		Ar << Solution.OptionIds;
+	}
+}
+
+void FWFCBoundarySignature::Finalize()
+{
+	BoundaryCells.Sort();
+
+	const uint32 HeaderData[] = { ModelHash, static_cast<uint32>(Resolution.X), static_cast<uint32>(Resolution.Y), static_cast<uint32>(Resolution.Z), static_cast<uint32>(Seed), static_cast<uint32>(TryCount), SolverSettingsHash };
+	Hash = FCrc::MemCrc32(HeaderData, sizeof(HeaderData));
+	Hash = FCrc::MemCrc32(BoundaryCells.GetData(), BoundaryCells.Num() * BoundaryCells.GetTypeSize(), Hash);
+	Hash = FCrc::MemCrc32(DistrictIds.GetData(), DistrictIds.Num() * DistrictIds.GetTypeSize(), Hash);
+}
+
+void FWFCSolutionCache::SetCapacity(int32 Capacity)
+{
+	if (Entries.Max() != FMath::Max(Capacity, 0))
+	{
+		Entries.Empty(FMath::Max(Capacity, 0));
+	}
+}
+
+const FWFCCachedSolution* FWFCSolutionCache::Find(const FWFCBoundarySignature& Signature)
+{
+	const FWFCCachedSolution* Solution = Entries.Max() > 0 ? Entries.FindAndTouch(Signature) : nullptr;
+	Solution ? NumHits++ : NumMisses++;
+	return Solution;
+}
+
+void FWFCSolutionCache::Add(const FWFCBoundarySignature& Signature, FWFCCachedSolution&& Solution)
+{
+	if (Entries.Max() > 0)
+	{
+		Entries.Add(Signature, MoveTemp(Solution));
+	}
+}
+
+void FWFCSolutionCache::Empty()
+{
+	Entries.Empty(Entries.Max());
+	NumHits = 0;
+	NumMisses = 0;
+}
+
+FString FWFCSolutionCache::GetCacheFilename(uint32 ModelHash)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("WFCCache"), FString::Printf(TEXT("%08x.wfccache"), ModelHash));
+}
+
+bool FWFCSolutionCache::Save(const FString& Filename) const
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unable to write solution cache: %s"), *Filename);
+		return false;
+	}
+
+	// The iterator goes from the most recently used entry, reversed so Load restores the same order
+	TArray<TPair<FWFCBoundarySignature, FWFCCachedSolution>> OrderedEntries;
+	OrderedEntries.Reserve(Entries.Num());
+	for (TLruCache<FWFCBoundarySignature, FWFCCachedSolution>::TConstIterator It(Entries); It; ++It)
+	{
+		OrderedEntries.Emplace(It.Key(), It.Value());
+	}
+
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	int32 NumEntries = OrderedEntries.Num();
+	*Writer << FileMagic << FileVersion << NumEntries;
+	for (int32 Index = OrderedEntries.Num() - 1; Index >= 0; Index--)
+	{
+		SerializeEntry(*Writer, OrderedEntries[Index].Key, OrderedEntries[Index].Value);
+	}
+
+	return Writer->Close();
+}
+
+bool FWFCSolutionCache::Load(const FString& Filename, uint32 ModelHash)
+{
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *Filename, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	int32 NumEntries = 0;
+	Reader << FileMagic << FileVersion << NumEntries;
+	if (!Reader.IsError() && FileMagic == Magic && FileVersion != Version)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Skipping solution cache saved with version %u: %s"), FileVersion, *Filename);
+		return false;
+	}
+	if (Reader.IsError() || FileMagic != Magic || NumEntries < 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid solution cache: %s"), *Filename);
+		return false;
+	}
+
+	int32 NumLoaded = 0;
+	for (int32 Index = 0; Index < NumEntries && !Reader.IsError(); Index++)
+	{
+		FWFCBoundarySignature Signature;
+		FWFCCachedSolution Solution;
+		SerializeEntry(Reader, Signature, Solution);
+		if (!Reader.IsError() && Signature.ModelHash == ModelHash)
+		{
+			Signature.Finalize();
+			Add(Signature, MoveTemp(Solution));
+			NumLoaded++;
+		}
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Truncated solution cache: %s"), *Filename);
+		return false;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Loaded %d solved windows from %s"), NumLoaded, *Filename);
+	return true;
+}
+
+void FWFCSolutionCache::LogStats() const
+{
+	const int64 NumLookups = NumHits + NumMisses;
+	UE_LOG(LogTemp, Display, TEXT("Solution cache: %d/%d entries, %lld hits, %lld misses (%.1f%% hit rate)"),
+		Entries.Num(), Entries.Max(), NumHits, NumMisses, NumLookups > 0 ? 100.0 * NumHits / NumLookups : 0.0);
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCSolveArena.h"
+
+namespace
+{
+	SIZE_T GetTilesAllocatedSize(const TArray<FWaveFunctionCollapseTile>& Tiles)
+	{
+		SIZE_T AllocatedSize = Tiles.GetAllocatedSize();
+		for (const FWaveFunctionCollapseTile& Tile : Tiles)
+		{
+			AllocatedSize += Tile.RemainingOptions.GetAllocatedSize();
+		}
+		return AllocatedSize;
+	}
+
+	SIZE_T GetOptionIdsAllocatedSize(const TArray<TArray<uint16>>& OptionIds)
+	{
+		SIZE_T AllocatedSize = OptionIds.GetAllocatedSize();
+		for (const TArray<uint16>& TileOptionIds : OptionIds)
+		{
+			AllocatedSize += TileOptionIds.GetAllocatedSize();
+		}
+		return AllocatedSize;
+	}
+}
+
+void FWFCSolveArena::Reserve(int32 NumCells, int32 NumOptions)
+{
+	Tiles.Reserve(NumCells);
+	TileOptionIds.Reserve(NumCells);
+	RemainingTiles.Reserve(NumCells);
+	InitializedTiles.Reserve(NumCells);
+	InitializedTileOptionIds.Reserve(NumCells);
+	InitializedRemainingTiles.Reserve(NumCells);
+	ObservationQueue.Reserve(NumCells);
+	PropagationQueue.Reserve(NumCells);
+	AllowedOptionWords.Reserve(FMath::DivideAndRoundUp(NumOptions, 64));
+	CumulativeDensity.Reserve(NumOptions);
+}
+
+void FWFCSolveArena::ResetCachedTiles()
+{
+	InitialTiles.Reset();
+	BorderTiles.Reset();
+	BorderTileOptionIds.Reset();
+}
+
+void FWFCSolveArena::CopyTile(const FWaveFunctionCollapseTile& Source, FWaveFunctionCollapseTile& Dest)
+{
+	// TArray assignment only reallocates when the destination is too small
+	Dest.RemainingOptions = Source.RemainingOptions;
+	Dest.ShannonEntropy = Source.ShannonEntropy;
+}
+
+void FWFCSolveArena::CopyTiles(const TArray<FWaveFunctionCollapseTile>& Source, TArray<FWaveFunctionCollapseTile>& Dest)
+{
+	Dest.SetNum(Source.Num(), EAllowShrinking::No);
+	for (int32 index = 0; index < Source.Num(); index++)
+	{
+		CopyTile(Source[index], Dest[index]);
+	}
+}
+
+void FWFCSolveArena::CopyTileOptionIds(const TArray<TArray<uint16>>& Source, TArray<TArray<uint16>>& Dest)
+{
+	Dest.SetNum(Source.Num(), EAllowShrinking::No);
+	for (int32 index = 0; index < Source.Num(); index++)
+	{
+		Dest[index] = Source[index];
+	}
+}
+
+SIZE_T FWFCSolveArena::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = GetTilesAllocatedSize(Tiles) + GetTilesAllocatedSize(InitializedTiles);
+	AllocatedSize += GetOptionIdsAllocatedSize(TileOptionIds) + GetOptionIdsAllocatedSize(InitializedTileOptionIds);
+	AllocatedSize += RemainingTiles.GetAllocatedSize() + InitializedRemainingTiles.GetAllocatedSize();
+	AllocatedSize += ObservationQueue.GetAllocatedSize() + PropagationQueue.GetAllocatedSize();
+	AllocatedSize += AllowedOptionWords.GetAllocatedSize() + CumulativeDensity.GetAllocatedSize();
+	AllocatedSize += InitialTiles.GetAllocatedSize() + BorderTiles.GetAllocatedSize() + BorderTileOptionIds.GetAllocatedSize();
+	for (const TPair<uint32, FWaveFunctionCollapseTile>& InitialTile : InitialTiles)
+	{
+		AllocatedSize += InitialTile.Value.RemainingOptions.GetAllocatedSize();
+	}
+	for (const TPair<uint64, FWaveFunctionCollapseTile>& BorderTile : BorderTiles)
+	{
+		AllocatedSize += BorderTile.Value.RemainingOptions.GetAllocatedSize();
+	}
+	for (const TPair<uint64, TArray<uint16>>& BorderOptionIds : BorderTileOptionIds)
+	{
+		AllocatedSize += BorderOptionIds.Value.GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
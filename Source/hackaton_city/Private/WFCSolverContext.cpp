@@ -0,0 +1,960 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCSolverContext.h"
+#include "HAL/IConsoleManager.h"
+#include "Algo/Reverse.h"
+
+static TAutoConsoleVariable<bool> CVarWFCForceDynamicKernel(
+	TEXT("wfc.Solver.ForceDynamicKernel"),
+	false,
+	TEXT("Propagate with the dynamic width kernel whatever the mask width of the model, solves must stay identical"));
+
+void FWFCSolverContext::CopySettings(const FWFCSolverContext& Other)
+{
+	CompiledModel = Other.CompiledModel;
+	DistrictMasks = Other.DistrictMasks;
+	Resolution = Other.Resolution;
+	bUseEmptyBorder = Other.bUseEmptyBorder;
+	ObservationHeuristic = Other.ObservationHeuristic;
+	ObservationNoise = Other.ObservationNoise;
+}
+
+bool FWFCSolverContext::SolveWindow(int32 TryCount, const TMap<FIntVector, FWaveFunctionCollapseOption>& ProvisionalStarterOptions, int32& InOutRandomSeed)
+{
+	TArray<FWaveFunctionCollapseTile>& Tiles = SolveArena.Tiles;
+
+	// One attempt with the provisional tiles, propagation rejects them if they conflict with the placed tiles
+	if (!ProvisionalStarterOptions.IsEmpty())
+	{
+		const TMap<FIntVector, FWaveFunctionCollapseOption> PlacedStarterOptions = StarterOptions;
+		StarterOptions.Append(ProvisionalStarterOptions);
+		int32 ProvisionalRandomSeed = InOutRandomSeed;
+		if (SolveTiles(1, ProvisionalRandomSeed, Tiles))
+		{
+			InOutRandomSeed = ProvisionalRandomSeed;
+			NumProvisionalAdoptions++;
+			return true;
+		}
+		if (IsSolveCancelled())
+		{
+			return false;
+		}
+		UE_LOG(LogTemp, Display, TEXT("Provisional tiles rejected, solving from the placed tiles only"));
+		StarterOptions = PlacedStarterOptions;
+		NumProvisionalRejections++;
+	}
+	return SolveTiles(TryCount, InOutRandomSeed, Tiles);
+}
+
+bool FWFCSolverContext::SolveChunk(int32 TryCount, int32& InOutRandomSeed, TArray<uint16>& OutOptionIds)
+{
+	TArray<FWaveFunctionCollapseTile>& Tiles = SolveArena.Tiles;
+	if (!SolveTiles(TryCount, InOutRandomSeed, Tiles))
+	{
+		return false;
+	}
+
+	// Keep every inner cell, empty options included, so neighbors can be constrained by them
+	const FIntVector Stride = GetChunkStride();
+	const FIntVector WindowOffset = GetChunkWindowOffset();
+	OutOptionIds.SetNumUninitialized(Stride.X * Stride.Y * Stride.Z);
+	for (int32 CellIndex = 0; CellIndex < OutOptionIds.Num(); CellIndex++)
+	{
+		const FIntVector CellPosition(CellIndex % Stride.X, (CellIndex / Stride.X) % Stride.Y, CellIndex / (Stride.X * Stride.Y));
+		const FWaveFunctionCollapseTile& Tile = Tiles[UWaveFunctionCollapseBPLibrary::PositionAsIndex(CellPosition + WindowOffset, Resolution)];
+		OutOptionIds[CellIndex] = Tile.RemainingOptions.Num() == 1 ? CompiledModel->FindOptionId(Tile.RemainingOptions[0]) : FWFCCompiledModel::InvalidOptionId;
+	}
+	return true;
+}
+
+bool FWFCSolverContext::SolveTiles(int32 TryCount, int32& InOutRandomSeed, TArray<FWaveFunctionCollapseTile>& Tiles)
+{
+	// A window solved before with the same boundary and seed is copied from the solution cache
+	FWFCBoundarySignature Signature;
+	const bool bUseSolutionCache = SolutionCache && SolutionCache->GetCapacity() > 0 && TryCount > 0 && MakeBoundarySignature(TryCount, InOutRandomSeed, Signature);
+	if (bUseSolutionCache)
+	{
+		if (const FWFCCachedSolution* CachedSolution = SolutionCache->Find(Signature))
+		{
+			Tiles.SetNum(CachedSolution->OptionIds.Num(), EAllowShrinking::No);
+			for (int32 index = 0; index < Tiles.Num(); index++)
+			{
+				Tiles[index].RemainingOptions.Reset();
+				Tiles[index].ShannonEntropy = 0.0f;
+				if (const FWaveFunctionCollapseOption* CachedOption = CompiledModel->GetOption(CachedSolution->OptionIds[index]))
+				{
+					Tiles[index].RemainingOptions.Add(*CachedOption);
+				}
+			}
+			InOutRandomSeed = CachedSolution->Seed;
+			return CachedSolution->bSolved;
+		}
+	}
+
+	// Scratch memory comes from the solve arena, grown once for the window and model
+	checkf(!SolveArena.bSolving, TEXT("Nested solves would overwrite the solve arena"));
+	TGuardValue<bool> SolvingGuard(SolveArena.bSolving, true);
+	SolveArena.Reserve(Resolution.X * Resolution.Y * Resolution.Z, CompiledModel->NumOptions());
+	TArray<int32>& RemainingTiles = SolveArena.RemainingTiles;
+	TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue = SolveArena.ObservationQueue;
+	ObservationQueue.Reset();
+
+	InitializeWFC(Tiles, RemainingTiles);
+
+	bool bSuccessfulSolve = false;
+
+	if (TryCount > 1)
+	{
+		//Copy Original Initialized tiles
+		FWFCSolveArena::CopyTiles(Tiles, SolveArena.InitializedTiles);
+		FWFCSolveArena::CopyTileOptionIds(SolveArena.TileOptionIds, SolveArena.InitializedTileOptionIds);
+		SolveArena.InitializedRemainingTiles = RemainingTiles;
+
+		int32 CurrentTry = 1;
+		bSuccessfulSolve = ObservationPropagation(Tiles, RemainingTiles, ObservationQueue, InOutRandomSeed);
+		FRandomStream RandomStream(InOutRandomSeed);
+		while (!bSuccessfulSolve && CurrentTry<TryCount && !IsSolveCancelled())
+		{
+			CurrentTry += 1;
+			UE_LOG(LogTemp, Warning, TEXT("Failed with Seed Value: %d. Trying again.  Attempt number: %d"), InOutRandomSeed, CurrentTry);
+			InOutRandomSeed = RandomStream.RandRange(1, TNumericLimits<int32>::Max());
+			
+			// Start from Original Initialized tiles, copied into the option arrays of the failed attempt
+			FWFCSolveArena::CopyTiles(SolveArena.InitializedTiles, Tiles);
+			FWFCSolveArena::CopyTileOptionIds(SolveArena.InitializedTileOptionIds, SolveArena.TileOptionIds);
+			RemainingTiles = SolveArena.InitializedRemainingTiles;
+			ObservationQueue.Reset();
+			bSuccessfulSolve = ObservationPropagation(Tiles, RemainingTiles, ObservationQueue, InOutRandomSeed);
+		}
+	}
+	else if (TryCount == 1)
+	{
+		bSuccessfulSolve = ObservationPropagation(Tiles, RemainingTiles, ObservationQueue, InOutRandomSeed);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid TryCount on Collapse: %d"), TryCount);
+	}
+
+	// A cancelled solve tells nothing about the seed
+	if (bUseSolutionCache && !IsSolveCancelled())
+	{
+		FWFCCachedSolution Solution;
+		Solution.bSolved = bSuccessfulSolve;
+		Solution.Seed = InOutRandomSeed;
+		if (bSuccessfulSolve)
+		{
+			Solution.OptionIds.SetNumUninitialized(Tiles.Num());
+			for (int32 index = 0; index < Tiles.Num(); index++)
+			{
+				const TArray<uint16>& TileOptionIds = SolveArena.TileOptionIds[index];
+				Solution.OptionIds[index] = TileOptionIds.Num() == 1 ? TileOptionIds[0] : FWFCCompiledModel::InvalidOptionId;
+			}
+		}
+		SolutionCache->Add(Signature, MoveTemp(Solution));
+	}
+	return bSuccessfulSolve;
+}
+
+bool FWFCSolverContext::GatherBoundaryCells(TArray<uint32>& OutBoundaryCells) const
+{
+	// Window cell indices are packed in the upper 16 bits, like in MakeBoundarySignature
+	OutBoundaryCells.Reset(StarterOptions.Num());
+	if (Resolution.X * Resolution.Y * Resolution.Z > MAX_uint16)
+	{
+		return false;
+	}
+	for (const TPair<FIntVector, FWaveFunctionCollapseOption>& StarterOption : StarterOptions)
+	{
+		const uint16 OptionId = CompiledModel->FindOptionId(StarterOption.Value);
+		if (OptionId == FWFCCompiledModel::InvalidOptionId)
+		{
+			return false;
+		}
+		const uint32 WindowIndex = UWaveFunctionCollapseBPLibrary::PositionAsIndex(StarterOption.Key, Resolution);
+		OutBoundaryCells.Add((WindowIndex << 16) | OptionId);
+	}
+	OutBoundaryCells.Sort();
+	return true;
+}
+
+bool FWFCSolverContext::MakeBoundarySignature(int32 TryCount, int32 RandomSeed, FWFCBoundarySignature& OutSignature) const
+{
+	if (!CompiledModel->IsValid() || Resolution.X * Resolution.Y * Resolution.Z > MAX_uint16)
+	{
+		return false;
+	}
+
+	OutSignature.ModelHash = CompiledModel->ModelHash;
+	OutSignature.Resolution = Resolution;
+	OutSignature.Seed = RandomSeed;
+	OutSignature.TryCount = TryCount;
+	OutSignature.SolverSettingsHash = GetSolverSettingsHash();
+	if (!GatherBoundaryCells(OutSignature.BoundaryCells))
+	{
+		return false;
+	}
+	OutSignature.DistrictIds = WindowDistrictIds;
+	OutSignature.Finalize();
+	return true;
+}
+
+uint32 FWFCSolverContext::GetSolverSettingsHash() const
+{
+	uint32 Hash = GetTypeHash(bUseEmptyBorder);
+	Hash = HashCombine(Hash, GetTypeHash(ObservationHeuristic));
+	if (ObservationHeuristic == EWFCObservationHeuristic::WeightedEntropyNoise)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(ObservationNoise));
+	}
+	return Hash;
+}
+
+const FWFCDistrictMask* FWFCSolverContext::FindWindowDistrictMask(int32 WindowIndex) const
+{
+	if (!WindowDistrictIds.IsValidIndex(WindowIndex) || !DistrictMasks->IsValidIndex(WindowDistrictIds[WindowIndex]))
+	{
+		return nullptr;
+	}
+	const FWFCDistrictMask& DistrictMask = (*DistrictMasks)[WindowDistrictIds[WindowIndex]];
+	return DistrictMask.InitialTile.RemainingOptions.IsEmpty() ? nullptr : &DistrictMask;
+}
+
+FIntVector FWFCSolverContext::GetChunkStride() const
+{
+	return GetChunkStride(Resolution);
+}
+
+FIntVector FWFCSolverContext::GetChunkStride(const FIntVector& WindowResolution)
+{
+	// The outer ring of the solve window is only used as margin.  Unlike the inner window of SpawnActorFromTiles, even
+	// resolutions keep one margin cell on both sides, so both seams of a chunk are constrained.
+	return FIntVector(
+		FMath::Max(WindowResolution.X - 2, 1),
+		FMath::Max(WindowResolution.Y - 2, 1),
+		FMath::Max(WindowResolution.Z, 1));
+}
+
+FIntVector FWFCSolverContext::GetChunkWindowOffset() const
+{
+	const FIntVector Stride = GetChunkStride();
+	return FIntVector((Resolution.X - Stride.X) / 2, (Resolution.Y - Stride.Y) / 2, 0);
+}
+
+void FWFCSolverContext::InitializeWFC(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles)
+{
+	int32 SwapIndex = 0;
+	ScanlineCursor = 0;
+
+	// The initial tile of a model is built once and kept by the solve arena
+	FWaveFunctionCollapseTile* CachedInitialTile = SolveArena.InitialTiles.Find(CompiledModel->ModelHash);
+	if (!CachedInitialTile)
+	{
+		FWaveFunctionCollapseTile NewInitialTile;
+		if (BuildInitialTile(NewInitialTile))
+		{
+			CachedInitialTile = &SolveArena.InitialTiles.Add(CompiledModel->ModelHash, MoveTemp(NewInitialTile));
+		}
+	}
+
+	if (CachedInitialTile)
+	{
+		const FWaveFunctionCollapseTile& InitialTile = *CachedInitialTile;
+		float MinEntropy = InitialTile.ShannonEntropy;
+
+		// Tiles and their option IDs are written in place, so the arrays of a previous solve are reused
+		Tiles.SetNum(Resolution.X * Resolution.Y * Resolution.Z, EAllowShrinking::No);
+		TArray<TArray<uint16>>& TileOptionIds = SolveArena.TileOptionIds;
+		TileOptionIds.SetNum(Tiles.Num(), EAllowShrinking::No);
+		RemainingTiles.Reset();
+		auto AddTile = [&](int32 TileIndex)
+		{
+			const FWaveFunctionCollapseTile& Tile = Tiles[TileIndex];
+			RemainingTiles.Add(TileIndex);
+
+			// Scanline reads the index order instead
+			if (ObservationHeuristic == EWFCObservationHeuristic::Scanline)
+			{
+				return;
+			}
+
+			// swap lower entropy tile to the beginning of RemainingTiles
+			if (Tile.ShannonEntropy < MinEntropy)
+			{
+				RemainingTiles.Swap(0, RemainingTiles.Num() - 1);
+				MinEntropy = Tile.ShannonEntropy;
+				SwapIndex = 0;
+			}
+
+			// else, swap min entropy tile with the previous min entropy index+1
+			else if (Tile.ShannonEntropy == MinEntropy && Tile.ShannonEntropy != InitialTile.ShannonEntropy)
+			{
+				SwapIndex += 1;
+				RemainingTiles.Swap(SwapIndex, RemainingTiles.Num() - 1);
+			}
+		};
+
+		// Border mask of each face, empty for unconstrained faces.  Windows one cell thick have no border along that axis.
+		const TBitArray<>* FaceMasks[FWFCCompiledModel::NumFaces] = {};
+		const int32 FaceAxisResolutions[FWFCCompiledModel::NumFaces] = { Resolution.X, Resolution.X, Resolution.Y, Resolution.Y, Resolution.Z, Resolution.Z };
+		bool bHasBorder = false;
+		for (int32 Face = 0; Face < FWFCCompiledModel::NumFaces; Face++)
+		{
+			const TBitArray<>& BorderMask = CompiledModel->BorderMasks[Face];
+			const TBitArray<>& EmptyBorderMask = CompiledModel->EmptyBorderMasks[Face];
+			FaceMasks[Face] = !BorderMask.IsEmpty() ? &BorderMask : (bUseEmptyBorder && !EmptyBorderMask.IsEmpty() ? &EmptyBorderMask : nullptr);
+			if (FaceAxisResolutions[Face] <= 1)
+			{
+				FaceMasks[Face] = nullptr;
+			}
+			bHasBorder |= FaceMasks[Face] != nullptr;
+		}
+
+		// Border tiles are masked once per face combination and district, then kept by the solve arena
+		auto CopyBorderTile = [&](const FWaveFunctionCollapseTile& BaseTile, const TArray<uint16>& BaseOptionIds, uint16 DistrictOptionId, uint32 FaceBits, int32 TileIndex)
+		{
+			const uint64 Key = (static_cast<uint64>(CompiledModel->ModelHash) << 32) | (static_cast<uint64>(bUseEmptyBorder) << 24) | (static_cast<uint64>(DistrictOptionId) << 8) | FaceBits;
+			if (const FWaveFunctionCollapseTile* CachedBorderTile = SolveArena.BorderTiles.Find(Key))
+			{
+				FWFCSolveArena::CopyTile(*CachedBorderTile, Tiles[TileIndex]);
+				TileOptionIds[TileIndex] = SolveArena.BorderTileOptionIds.FindChecked(Key);
+				return;
+			}
+
+			TBitArray<> Mask;
+			for (int32 Face = 0; Face < FWFCCompiledModel::NumFaces; Face++)
+			{
+				if (FaceBits & (1 << Face))
+				{
+					Mask = Mask.IsEmpty() ? *FaceMasks[Face] : TBitArray<>::BitwiseAND(Mask, *FaceMasks[Face], EBitwiseOperatorFlags::MinSize);
+				}
+			}
+
+			FWaveFunctionCollapseTile BorderTile;
+			TArray<uint16> BorderOptionIds;
+			for (int32 OptionIndex = 0; OptionIndex < BaseOptionIds.Num(); OptionIndex++)
+			{
+				const uint16 OptionId = BaseOptionIds[OptionIndex];
+				if (Mask.IsValidIndex(OptionId) && Mask[OptionId])
+				{
+					BorderTile.RemainingOptions.Add(BaseTile.RemainingOptions[OptionIndex]);
+					BorderOptionIds.Add(OptionId);
+				}
+			}
+
+			// A border no option can face is left unconstrained rather than failing every attempt
+			if (BorderTile.RemainingOptions.IsEmpty())
+			{
+				UE_LOG(LogTemp, Warning, TEXT("No option allowed on border faces %x, border left unconstrained"), FaceBits);
+				BorderTile = BaseTile;
+				BorderOptionIds = BaseOptionIds;
+			}
+			else
+			{
+				BorderTile.ShannonEntropy = CompiledModel->CalculateShannonEntropy(BorderOptionIds);
+			}
+			FWFCSolveArena::CopyTile(BorderTile, Tiles[TileIndex]);
+			TileOptionIds[TileIndex] = BorderOptionIds;
+			SolveArena.BorderTiles.Add(Key, MoveTemp(BorderTile));
+			SolveArena.BorderTileOptionIds.Add(Key, MoveTemp(BorderOptionIds));
+		};
+
+		for (int32 Z = 0;Z < Resolution.Z; Z++)
+		{
+			for (int32 Y = 0;Y < Resolution.Y; Y++)
+			{
+				for (int32 X = 0;X < Resolution.X; X++)
+				{
+					const int32 TileIndex = UWaveFunctionCollapseBPLibrary::PositionAsIndex(FIntVector(X, Y, Z), Resolution);
+					FWaveFunctionCollapseTile& Tile = Tiles[TileIndex];
+					const FWFCDistrictMask* DistrictMask = FindWindowDistrictMask(TileIndex);
+
+					uint32 FaceBits = 0;
+					if (bHasBorder)
+					{
+						const bool bOnFace[FWFCCompiledModel::NumFaces] = { X == 0, X == Resolution.X - 1, Y == 0, Y == Resolution.Y - 1, Z == 0, Z == Resolution.Z - 1 };
+						for (int32 Face = 0; Face < FWFCCompiledModel::NumFaces; Face++)
+						{
+							FaceBits |= (bOnFace[Face] && FaceMasks[Face]) ? (1 << Face) : 0;
+						}
+					}
+
+					// Pre-populate with starter tiles
+					if (FWaveFunctionCollapseOption* StarterOption = StarterOptions.Find(FIntVector(X, Y, Z)))
+					{
+						Tile.RemainingOptions.Reset();
+						Tile.RemainingOptions.Add(*StarterOption);
+						TileOptionIds[TileIndex].Reset();
+						TileOptionIds[TileIndex].Add(CompiledModel->FindOptionId(*StarterOption));
+						Tile.ShannonEntropy = CompiledModel->CalculateShannonEntropy(TileOptionIds[TileIndex]);
+						AddTile(TileIndex);
+					}
+
+					// Pre-populate with border tiles, restricted to the district of the cell as well
+					else if (FaceBits != 0)
+					{
+						const uint16 DistrictOptionId = DistrictMask ? WindowDistrictIds[TileIndex] : FWFCCompiledModel::InvalidOptionId;
+						CopyBorderTile(DistrictMask ? DistrictMask->InitialTile : InitialTile, DistrictMask ? DistrictMask->InitialOptionIds : CompiledModel->InitialOptionIds,
+							DistrictOptionId, FaceBits, TileIndex);
+						AddTile(TileIndex);
+					}
+
+					// Restrict the initial options to the district of the cell
+					else if (DistrictMask)
+					{
+						FWFCSolveArena::CopyTile(DistrictMask->InitialTile, Tile);
+						TileOptionIds[TileIndex] = DistrictMask->InitialOptionIds;
+						AddTile(TileIndex);
+					}
+
+					// Fill the rest with initial tiles
+					else
+					{
+						FWFCSolveArena::CopyTile(InitialTile, Tile);
+						TileOptionIds[TileIndex] = CompiledModel->InitialOptionIds;
+						RemainingTiles.Add(TileIndex);
+					}
+				}
+			}
+		}
+		// Tiles were added in ascending index order, Scanline pops the lowest index from the back
+		if (ObservationHeuristic == EWFCObservationHeuristic::Scanline)
+		{
+			Algo::Reverse(RemainingTiles);
+		}
+
+		// Keep the same starting options for the next run
+		// StarterOptions.Empty();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not create Initial Tile from Model"));
+	}
+
+}
+
+void FWFCSolverContext::SyncTileOptionIds(const TArray<FWaveFunctionCollapseTile>& Tiles)
+{
+	SolveArena.TileOptionIds.SetNum(Tiles.Num(), EAllowShrinking::No);
+	for (int32 index = 0; index < Tiles.Num(); index++)
+	{
+		TArray<uint16>& TileOptionIds = SolveArena.TileOptionIds[index];
+		TileOptionIds.Reset();
+		for (const FWaveFunctionCollapseOption& Option : Tiles[index].RemainingOptions)
+		{
+			TileOptionIds.Add(CompiledModel->FindOptionId(Option));
+		}
+	}
+}
+
+bool FWFCSolverContext::BuildInitialTile(FWaveFunctionCollapseTile& InitialTile) const
+{
+	TArray<FWaveFunctionCollapseOption> InitialOptions;
+	for (uint16 OptionId : CompiledModel->InitialOptionIds)
+	{
+		InitialOptions.Add(CompiledModel->Options[OptionId]);
+	}
+
+	if (!InitialOptions.IsEmpty())
+	{
+		InitialTile.RemainingOptions = InitialOptions;
+		InitialTile.ShannonEntropy = CompiledModel->CalculateShannonEntropy(CompiledModel->InitialOptionIds);
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool FWFCSolverContext::Observe(TArray<FWaveFunctionCollapseTile>& Tiles, 
+	TArray<int32>& RemainingTiles, 
+	TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue,
+	int32 RandomSeed)
+{
+	float MinEntropy = 0;
+	int32 LastSameMinEntropyIndex = 0;
+	int32 SelectedMinEntropyIndex = 0;
+	int32 MinEntropyIndex = 0;
+	FRandomStream RandomStream(RandomSeed);
+
+	// Other heuristics pick a single tile and do not keep RemainingTiles sorted
+	if (ObservationHeuristic != EWFCObservationHeuristic::MinEntropy)
+	{
+		SelectedMinEntropyIndex = SelectObservedTile(Tiles, RemainingTiles, RandomStream);
+		LastSameMinEntropyIndex = SelectedMinEntropyIndex;
+		MinEntropyIndex = RemainingTiles[SelectedMinEntropyIndex];
+	}
+
+	// Find MinEntropy Tile Indices
+	else if (RemainingTiles.Num() > 1)
+	{
+		for (int32 index = 0; index<RemainingTiles.Num(); index++)
+		{
+			if (index == 0)
+			{
+				MinEntropy = Tiles[RemainingTiles[index]].ShannonEntropy;
+			}
+			else
+			{
+				if (Tiles[RemainingTiles[index]].ShannonEntropy > MinEntropy)
+				{
+					break;
+				}
+				else
+				{
+					LastSameMinEntropyIndex += 1;
+				}
+			}
+		}
+		SelectedMinEntropyIndex = RandomStream.RandRange(0, LastSameMinEntropyIndex);
+		MinEntropyIndex = RemainingTiles[SelectedMinEntropyIndex];
+	}
+	else
+	{
+		MinEntropyIndex = RemainingTiles[0];
+	}
+
+	// Rand Selection of Weighted Options using Cumulative Density
+	TArray<float>& CumulativeDensity = SolveArena.CumulativeDensity;
+	CumulativeDensity.Reset();
+	float CumulativeWeight = 0;
+	TArray<uint16>& SelectedOptionIds = SolveArena.TileOptionIds[MinEntropyIndex];
+	for (const uint16 OptionId : SelectedOptionIds)
+	{
+		CumulativeWeight += CompiledModel->GetWeight(OptionId);
+		CumulativeDensity.Add(CumulativeWeight);
+	}
+	
+	int32 SelectedOptionIndex = 0;
+	float RandomDensity = RandomStream.FRandRange(0.0f, CumulativeDensity.Last());
+	for (int32 Index = 0; Index < CumulativeDensity.Num(); Index++)
+	{
+		if (CumulativeDensity[Index] > RandomDensity)
+		{
+			SelectedOptionIndex = Index;
+			break;
+		}
+	}
+
+	// Make Selection, keeping the option array of the tile
+	TArray<FWaveFunctionCollapseOption>& SelectedRemainingOptions = Tiles[MinEntropyIndex].RemainingOptions;
+	if (SelectedOptionIndex != 0)
+	{
+		SelectedRemainingOptions[0] = SelectedRemainingOptions[SelectedOptionIndex];
+		SelectedOptionIds[0] = SelectedOptionIds[SelectedOptionIndex];
+	}
+	SelectedRemainingOptions.SetNum(1, EAllowShrinking::No);
+	SelectedOptionIds.SetNum(1, EAllowShrinking::No);
+	Tiles[MinEntropyIndex].ShannonEntropy = TNumericLimits<float>::Max();
+
+	if (SelectedMinEntropyIndex != LastSameMinEntropyIndex)
+	{
+		RemainingTiles.Swap(SelectedMinEntropyIndex, LastSameMinEntropyIndex);
+	}
+	RemainingTiles.RemoveAtSwap(LastSameMinEntropyIndex);
+
+	if (!RemainingTiles.IsEmpty())
+	{
+		// if MinEntropy has changed after removal, find new MinEntropy and swap to front of array
+		if (ObservationHeuristic == EWFCObservationHeuristic::MinEntropy && Tiles[RemainingTiles[0]].ShannonEntropy != MinEntropy)
+		{
+			int32 SwapToIndex = 0;
+			for (int32 index = 0; index < RemainingTiles.Num(); index++)
+			{
+				if (index == 0)
+				{
+					MinEntropy = Tiles[RemainingTiles[index]].ShannonEntropy;
+				}
+				else
+				{
+					if (Tiles[RemainingTiles[index]].ShannonEntropy < MinEntropy)
+					{
+						SwapToIndex = 0;
+						MinEntropy = Tiles[RemainingTiles[index]].ShannonEntropy;
+						RemainingTiles.Swap(SwapToIndex, index);
+					}
+					else if (Tiles[RemainingTiles[index]].ShannonEntropy == MinEntropy)
+					{
+						SwapToIndex += 1;
+						RemainingTiles.Swap(SwapToIndex, index);
+					}
+				}
+			}
+		}
+
+		// Add Adjacent Tile Indices to Queue
+		AddAdjacentIndicesToQueue(MinEntropyIndex, RemainingTiles, ObservationQueue);
+
+		// Continue To Propagation
+		return true;
+	}
+	else
+	{
+		// Do Not Continue to Propagation
+		return false;
+	}
+}
+
+int32 FWFCSolverContext::SelectObservedTile(const TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, FRandomStream& RandomStream)
+{
+	int32 SelectedIndex = 0;
+	switch (ObservationHeuristic)
+	{
+	case EWFCObservationHeuristic::MinRemainingValues:
+	{
+		// Reservoir sampling keeps the tie-breaking uniform in a single pass
+		int32 MinNumOptions = TNumericLimits<int32>::Max();
+		int32 NumTies = 0;
+		for (int32 index = 0; index < RemainingTiles.Num(); index++)
+		{
+			const int32 NumOptions = Tiles[RemainingTiles[index]].RemainingOptions.Num();
+			if (NumOptions < MinNumOptions)
+			{
+				MinNumOptions = NumOptions;
+				SelectedIndex = index;
+				NumTies = 1;
+			}
+			else if (NumOptions == MinNumOptions && RandomStream.RandHelper(++NumTies) == 0)
+			{
+				SelectedIndex = index;
+			}
+		}
+		break;
+	}
+	case EWFCObservationHeuristic::WeightedEntropyNoise:
+	{
+		float MinNoisyEntropy = TNumericLimits<float>::Max();
+		for (int32 index = 0; index < RemainingTiles.Num(); index++)
+		{
+			const float NoisyEntropy = Tiles[RemainingTiles[index]].ShannonEntropy + RandomStream.FRand() * ObservationNoise;
+			if (NoisyEntropy < MinNoisyEntropy)
+			{
+				MinNoisyEntropy = NoisyEntropy;
+				SelectedIndex = index;
+			}
+		}
+		break;
+	}
+	case EWFCObservationHeuristic::Scanline:
+	{
+		// Observed tiles are left with max entropy, so the cursor skips them without searching RemainingTiles
+		while (Tiles.IsValidIndex(ScanlineCursor) && Tiles[ScanlineCursor].ShannonEntropy == TNumericLimits<float>::Max())
+		{
+			ScanlineCursor++;
+		}
+		// Removing the last tile keeps the descending order, so the next lowest index is last again
+		SelectedIndex = RemainingTiles.Num() - 1;
+
+		// Remaining tiles not set up by InitializeWFC, sort them once and continue from the lowest remaining index
+		if (RemainingTiles.Last() != ScanlineCursor)
+		{
+			RemainingTiles.Sort(TGreater<int32>());
+			ScanlineCursor = RemainingTiles.Last();
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	return SelectedIndex;
+}
+
+namespace
+{
+	/**
+	 * Options allowed on a tile as bits by option ID.  Fixed-width masks live on the stack and their word loops unroll,
+	 * the dynamic width of 0 words uses the scratch words of the solve arena.
+	 */
+	template<int32 NumWords>
+	struct TWFCOptionMask
+	{
+		uint64 Words[NumWords];
+
+		explicit TWFCOptionMask(TArray<uint64>& /*ScratchWords*/)
+		{
+		}
+
+		void Reset(int32 /*NumMaskWords*/)
+		{
+			for (int32 Word = 0; Word < NumWords; Word++)
+			{
+				Words[Word] = 0;
+			}
+		}
+
+		void Append(const uint64* OtherWords)
+		{
+			for (int32 Word = 0; Word < NumWords; Word++)
+			{
+				Words[Word] |= OtherWords[Word];
+			}
+		}
+
+		bool Contains(uint16 OptionId) const
+		{
+			return (Words[OptionId >> 6] >> (OptionId & 63)) & 1;
+		}
+	};
+
+	template<>
+	struct TWFCOptionMask<0>
+	{
+		TArray<uint64>& Words;
+
+		explicit TWFCOptionMask(TArray<uint64>& ScratchWords)
+			: Words(ScratchWords)
+		{
+		}
+
+		void Reset(int32 NumMaskWords)
+		{
+			Words.Reset();
+			Words.SetNumZeroed(NumMaskWords);
+		}
+
+		void Append(const uint64* OtherWords)
+		{
+			for (int32 Word = 0; Word < Words.Num(); Word++)
+			{
+				Words[Word] |= OtherWords[Word];
+			}
+		}
+
+		bool Contains(uint16 OptionId) const
+		{
+			return (Words[OptionId >> 6] >> (OptionId & 63)) & 1;
+		}
+	};
+
+	struct FWFCNeighborOffset
+	{
+		FIntVector Offset;
+		EWaveFunctionCollapseAdjacency Adjacency;
+	};
+
+	// Same order as before the kernels, the queue order decides the propagation order and thus the solve
+	static const FWFCNeighborOffset NeighborOffsets[] = {
+		{ FIntVector(1, 0, 0), EWaveFunctionCollapseAdjacency::Front },
+		{ FIntVector(-1, 0, 0), EWaveFunctionCollapseAdjacency::Back },
+		{ FIntVector(0, 1, 0), EWaveFunctionCollapseAdjacency::Right },
+		{ FIntVector(0, -1, 0), EWaveFunctionCollapseAdjacency::Left },
+		{ FIntVector(0, 0, 1), EWaveFunctionCollapseAdjacency::Up },
+		{ FIntVector(0, 0, -1), EWaveFunctionCollapseAdjacency::Down } };
+}
+
+void FWFCSolverContext::AddAdjacentIndicesToQueue(int32 CenterIndex, const TArray<int32>& RemainingTiles, TMap<int32,FWaveFunctionCollapseQueueElement>& OutQueue) const
+{
+	if (Resolution.Z > 1)
+	{
+		AddAdjacentIndicesToQueueKernel<true>(CenterIndex, RemainingTiles, OutQueue);
+	}
+	else
+	{
+		AddAdjacentIndicesToQueueKernel<false>(CenterIndex, RemainingTiles, OutQueue);
+	}
+}
+
+template<bool bIs3D>
+void FWFCSolverContext::AddAdjacentIndicesToQueueKernel(int32 CenterIndex, const TArray<int32>& RemainingTiles, TMap<int32,FWaveFunctionCollapseQueueElement>& OutQueue) const
+{
+	const FIntVector Position = UWaveFunctionCollapseBPLibrary::IndexAsPosition(CenterIndex, Resolution);
+	constexpr int32 NumNeighbors = bIs3D ? 6 : 4;
+	for (int32 Neighbor = 0; Neighbor < NumNeighbors; Neighbor++)
+	{
+		const FIntVector AdjacentPosition = Position + NeighborOffsets[Neighbor].Offset;
+		if (AdjacentPosition.X < 0 || AdjacentPosition.Y < 0 || AdjacentPosition.Z < 0
+			|| AdjacentPosition.X >= Resolution.X || AdjacentPosition.Y >= Resolution.Y || AdjacentPosition.Z >= Resolution.Z)
+		{
+			continue;
+		}
+		const int32 AdjacentIndex = UWaveFunctionCollapseBPLibrary::PositionAsIndex(AdjacentPosition, Resolution);
+		if (RemainingTiles.Contains(AdjacentIndex))
+		{
+			OutQueue.Add(AdjacentIndex, FWaveFunctionCollapseQueueElement(CenterIndex, NeighborOffsets[Neighbor].Adjacency));
+		}
+	}
+}
+
+bool FWFCSolverContext::Propagate(TArray<FWaveFunctionCollapseTile>& Tiles, 
+	TArray<int32>& RemainingTiles, 
+	TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue, 
+	int32& PropagationCount)
+{
+	checkf(SolveArena.TileOptionIds.Num() == Tiles.Num(), TEXT("Option IDs out of sync with the tiles, call SyncTileOptionIds first"));
+
+	// Models of up to 64, 128 and 256 options get fixed-width masks, single layer windows skip the Up and Down neighbors.
+	// The dynamic width kernel can be forced to check that the fixed-width kernels solve identically.
+	const bool bIs3D = Resolution.Z > 1;
+	const bool bDynamicKernel = bForceDynamicKernel || CVarWFCForceDynamicKernel.GetValueOnAnyThread();
+	switch (bDynamicKernel ? 0 : CompiledModel->NumMaskWords)
+	{
+	case 1:
+		return bIs3D ? PropagateKernel<1, true>(Tiles, RemainingTiles, ObservationQueue, PropagationCount) : PropagateKernel<1, false>(Tiles, RemainingTiles, ObservationQueue, PropagationCount);
+	case 2:
+		return bIs3D ? PropagateKernel<2, true>(Tiles, RemainingTiles, ObservationQueue, PropagationCount) : PropagateKernel<2, false>(Tiles, RemainingTiles, ObservationQueue, PropagationCount);
+	case 4:
+		return bIs3D ? PropagateKernel<4, true>(Tiles, RemainingTiles, ObservationQueue, PropagationCount) : PropagateKernel<4, false>(Tiles, RemainingTiles, ObservationQueue, PropagationCount);
+	default:
+		return bIs3D ? PropagateKernel<0, true>(Tiles, RemainingTiles, ObservationQueue, PropagationCount) : PropagateKernel<0, false>(Tiles, RemainingTiles, ObservationQueue, PropagationCount);
+	}
+}
+
+template<int32 NumWords, bool bIs3D>
+bool FWFCSolverContext::PropagateKernel(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue, int32& PropagationCount)
+{
+	const FWFCCompiledModel& Palette = *CompiledModel;
+	TArray<TArray<uint16>>& TileOptionIds = SolveArena.TileOptionIds;
+	TMap<int32, FWaveFunctionCollapseQueueElement>& PropagationQueue = SolveArena.PropagationQueue;
+	TWFCOptionMask<NumWords> AllowedOptions(SolveArena.AllowedOptionWords);
+	PropagationQueue.Reset();
+
+	while (!ObservationQueue.IsEmpty())
+	{
+		for (TPair<int32, FWaveFunctionCollapseQueueElement>& ObservationAdjacenctElement : ObservationQueue)
+		{
+			// Make sure the tile to check is still a valid remaining tile
+			if (!RemainingTiles.Contains(ObservationAdjacenctElement.Key))
+			{
+				continue;
+			}
+			
+			TArray<FWaveFunctionCollapseOption>& ObservationRemainingOptions = Tiles[ObservationAdjacenctElement.Key].RemainingOptions;
+			TArray<uint16>& ObservationOptionIds = TileOptionIds[ObservationAdjacenctElement.Key];
+
+			// Get check against options, the union of the adjacency masks of the neighbor options on this face
+			const int32 Face = static_cast<int32>(ObservationAdjacenctElement.Value.Adjacency);
+			AllowedOptions.Reset(Palette.NumMaskWords);
+			for (const uint16 CenterOptionId : TileOptionIds[ObservationAdjacenctElement.Value.CenterObjectIndex])
+			{
+				if (CenterOptionId != FWFCCompiledModel::InvalidOptionId)
+				{
+					AllowedOptions.Append(Palette.GetAdjacencyMask(CenterOptionId, Face));
+				}
+			}
+				
+			// Filter the Remaining Options and their IDs in place, keeping their order
+			int32 NumKeptOptions = 0;
+			for (int32 OptionIndex = 0; OptionIndex < ObservationOptionIds.Num(); OptionIndex++)
+			{
+				const uint16 OptionId = ObservationOptionIds[OptionIndex];
+				if (OptionId != FWFCCompiledModel::InvalidOptionId && AllowedOptions.Contains(OptionId))
+				{
+					if (NumKeptOptions != OptionIndex)
+					{
+						ObservationRemainingOptions[NumKeptOptions] = MoveTemp(ObservationRemainingOptions[OptionIndex]);
+						ObservationOptionIds[NumKeptOptions] = OptionId;
+					}
+					NumKeptOptions++;
+				}
+			}
+			const bool bAddToPropagationQueue = NumKeptOptions < ObservationOptionIds.Num();
+			ObservationRemainingOptions.SetNum(NumKeptOptions, EAllowShrinking::No);
+			ObservationOptionIds.SetNum(NumKeptOptions, EAllowShrinking::No);
+				
+			// If Remaining Options have changed
+			if (bAddToPropagationQueue)
+			{
+				if (!ObservationRemainingOptions.IsEmpty())
+				{
+					AddAdjacentIndicesToQueueKernel<bIs3D>(ObservationAdjacenctElement.Key, RemainingTiles, PropagationQueue);
+
+					// Update Tile with new options
+					float MinEntropy = Tiles[RemainingTiles[0]].ShannonEntropy;
+					float NewEntropy = Palette.CalculateShannonEntropy(ObservationOptionIds);
+					int32 CurrentRemainingTileIndex;
+						
+					// Only MinEntropy reads the order of Remaining Tiles
+					if (ObservationHeuristic == EWFCObservationHeuristic::MinEntropy)
+					{
+						// If NewEntropy is <= MinEntropy, add to front of Remaining Tiles
+						if (NewEntropy < MinEntropy)
+						{
+							MinEntropy = NewEntropy;
+							CurrentRemainingTileIndex = RemainingTiles.Find(ObservationAdjacenctElement.Key);
+							if (CurrentRemainingTileIndex != 0)
+							{
+								RemainingTiles.Swap(0, CurrentRemainingTileIndex);
+							}
+						}
+						else if (NewEntropy == MinEntropy)
+						{
+							CurrentRemainingTileIndex = RemainingTiles.Find(ObservationAdjacenctElement.Key);
+							for (int32 Index = 1; Index < RemainingTiles.Num(); Index++)
+							{
+								if (MinEntropy != Tiles[RemainingTiles[Index]].ShannonEntropy)
+								{
+									if (CurrentRemainingTileIndex != Index)
+									{
+										RemainingTiles.Swap(Index, CurrentRemainingTileIndex);
+									}
+									break;
+								}
+							}
+						}
+					}
+						
+					Tiles[ObservationAdjacenctElement.Key].ShannonEntropy = NewEntropy;
+				}
+				else
+				{
+					// Encountered Contradiction
+					UE_LOG(LogTemp, Error, TEXT("Encountered Contradiction on Index %d"), ObservationAdjacenctElement.Key);
+					return false;
+				}
+			}
+		}
+
+		if (!PropagationQueue.IsEmpty())
+		{
+			PropagationCount += 1;
+		}
+
+		// Swap rather than copy, so both queues keep their allocations
+		Swap(ObservationQueue, PropagationQueue);
+		PropagationQueue.Reset();
+	}
+
+	return true;
+}
+
+bool FWFCSolverContext::ObservationPropagation(TArray<FWaveFunctionCollapseTile>& Tiles, 
+	TArray<int32>& RemainingTiles,
+	TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue,
+	int32 RandomSeed)
+{
+	int32 PropagationCount = 1;
+	int32 MutatedRandomSeed = RandomSeed;
+	ScanlineCursor = 0;
+	
+	while (Observe(Tiles, RemainingTiles, ObservationQueue, MutatedRandomSeed))
+	{
+		if (IsSolveCancelled() || !Propagate(Tiles, RemainingTiles, ObservationQueue, PropagationCount))
+		{
+			return false;
+		}
+
+		// Mutate Seed
+		MutatedRandomSeed--;
+	}
+
+	// Check if all tiles in the solve are non-spawnable
+	return !AreAllTilesNonSpawnable(Tiles);
+}
+
+bool FWFCSolverContext::AreAllTilesNonSpawnable(const TArray<FWaveFunctionCollapseTile>& Tiles) const
+{
+	bool bAllTilesAreNonSpawnable = true;
+	for (int32 index = 0; index < Tiles.Num(); index++)
+	{
+		if (Tiles[index].RemainingOptions.Num() == 1)
+		{
+			if (CompiledModel->IsObjectSpawnable(Tiles[index].RemainingOptions[0].BaseObject))
+			{
+				bAllTilesAreNonSpawnable = false;
+				break;
+			}
+		}
+	}
+	return bAllTilesAreNonSpawnable;
+}
@@ -0,0 +1,484 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCSolverDifferential.h"
+#include "UObject/Package.h"
+#include "WaveFunctionCollapseBPLibrary.h"
+
+namespace
+{
+	struct FWFCFaceOffset
+	{
+		EWaveFunctionCollapseAdjacency Adjacency;
+		EWaveFunctionCollapseAdjacency Opposite;
+		FIntVector Offset;
+	};
+
+	static const FWFCFaceOffset FaceOffsets[] = {
+		{ EWaveFunctionCollapseAdjacency::Front, EWaveFunctionCollapseAdjacency::Back, FIntVector(1, 0, 0) },
+		{ EWaveFunctionCollapseAdjacency::Back, EWaveFunctionCollapseAdjacency::Front, FIntVector(-1, 0, 0) },
+		{ EWaveFunctionCollapseAdjacency::Right, EWaveFunctionCollapseAdjacency::Left, FIntVector(0, 1, 0) },
+		{ EWaveFunctionCollapseAdjacency::Left, EWaveFunctionCollapseAdjacency::Right, FIntVector(0, -1, 0) },
+		{ EWaveFunctionCollapseAdjacency::Up, EWaveFunctionCollapseAdjacency::Down, FIntVector(0, 0, 1) },
+		{ EWaveFunctionCollapseAdjacency::Down, EWaveFunctionCollapseAdjacency::Up, FIntVector(0, 0, -1) } };
+
+	/**
+	 * Reference solver of the differential, the observation and propagation of the original subsystem solver.
+	 * Every lookup goes through the constraints of the model, there is no compiled model, solve arena or solution cache.
+	 * Draws from the random stream exactly like the solver context, so both give the same tiles for the same seed.
+	 */
+	struct FWFCReferenceSolver
+	{
+		UWaveFunctionCollapseModel* Model = nullptr;
+		FIntVector Resolution = FIntVector::ZeroValue;
+		TMap<FIntVector, FWaveFunctionCollapseOption> StarterOptions;
+		bool bUseEmptyBorder = false;
+		EWFCObservationHeuristic ObservationHeuristic = EWFCObservationHeuristic::MinEntropy;
+		float ObservationNoise = 0.0f;
+
+		bool IsInside(const FIntVector& Position) const
+		{
+			return Position.X >= 0 && Position.Y >= 0 && Position.Z >= 0 && Position.X < Resolution.X && Position.Y < Resolution.Y && Position.Z < Resolution.Z;
+		}
+
+		// Options the outside of the window allows on a border cell, from the constraints of BorderOption, or EmptyOption for an empty border
+		const TArray<FWaveFunctionCollapseOption>* FindBorderOptions(int32 Face) const
+		{
+			const EWaveFunctionCollapseAdjacency Adjacency = static_cast<EWaveFunctionCollapseAdjacency>(Face);
+			const FWaveFunctionCollapseAdjacencyToOptionsMap* BorderConstraint = Model->Constraints.Find(FWaveFunctionCollapseOption::BorderOption);
+			if (const FWaveFunctionCollapseOptions* BorderOptions = BorderConstraint ? BorderConstraint->AdjacencyToOptionsMap.Find(Adjacency) : nullptr)
+			{
+				return &BorderOptions->Options;
+			}
+			const FWaveFunctionCollapseAdjacencyToOptionsMap* EmptyConstraint = bUseEmptyBorder ? Model->Constraints.Find(FWaveFunctionCollapseOption::EmptyOption) : nullptr;
+			if (const FWaveFunctionCollapseOptions* EmptyOptions = EmptyConstraint ? EmptyConstraint->AdjacencyToOptionsMap.Find(Adjacency) : nullptr)
+			{
+				return &EmptyOptions->Options;
+			}
+			return nullptr;
+		}
+
+		bool Initialize(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles) const
+		{
+			FWaveFunctionCollapseTile InitialTile;
+			for (const TPair<FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap>& Constraint : Model->Constraints)
+			{
+				if (Constraint.Key.BaseObject != FWaveFunctionCollapseOption::BorderOption.BaseObject)
+				{
+					InitialTile.RemainingOptions.Add(Constraint.Key);
+				}
+			}
+			if (InitialTile.RemainingOptions.IsEmpty())
+			{
+				return false;
+			}
+			InitialTile.ShannonEntropy = UWaveFunctionCollapseBPLibrary::CalculateShannonEntropy(InitialTile.RemainingOptions, Model);
+
+			float MinEntropy = InitialTile.ShannonEntropy;
+			int32 SwapIndex = 0;
+			for (int32 Z = 0; Z < Resolution.Z; Z++)
+			{
+				for (int32 Y = 0; Y < Resolution.Y; Y++)
+				{
+					for (int32 X = 0; X < Resolution.X; X++)
+					{
+						const FIntVector Position(X, Y, Z);
+						FWaveFunctionCollapseTile Tile = InitialTile;
+						bool bConstrained = false;
+						if (const FWaveFunctionCollapseOption* StarterOption = StarterOptions.Find(Position))
+						{
+							Tile.RemainingOptions = { *StarterOption };
+							bConstrained = true;
+						}
+						else
+						{
+							// A border cell keeps the options allowed by the outside on every face it touches, windows one cell thick have no border along that axis
+							for (int32 Face = 0; Face < UE_ARRAY_COUNT(FaceOffsets); Face++)
+							{
+								const FIntVector& Offset = FaceOffsets[Face].Offset;
+								const int32 AxisResolution = Offset.X != 0 ? Resolution.X : (Offset.Y != 0 ? Resolution.Y : Resolution.Z);
+								const TArray<FWaveFunctionCollapseOption>* BorderOptions = AxisResolution > 1 && !IsInside(Position - Offset) ? FindBorderOptions(static_cast<int32>(FaceOffsets[Face].Adjacency)) : nullptr;
+								if (BorderOptions)
+								{
+									Tile.RemainingOptions.RemoveAll([BorderOptions](const FWaveFunctionCollapseOption& Option) { return !BorderOptions->Contains(Option); });
+									bConstrained = true;
+								}
+							}
+
+							// A border no option can face is left unconstrained
+							if (Tile.RemainingOptions.IsEmpty())
+							{
+								Tile = InitialTile;
+							}
+						}
+
+						if (bConstrained)
+						{
+							Tile.ShannonEntropy = UWaveFunctionCollapseBPLibrary::CalculateShannonEntropy(Tile.RemainingOptions, Model);
+						}
+						Tiles.Add(Tile);
+						RemainingTiles.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position, Resolution));
+
+						// Constrained tiles of lower entropy go to the front of RemainingTiles
+						if (bConstrained && Tile.ShannonEntropy < MinEntropy)
+						{
+							RemainingTiles.Swap(0, RemainingTiles.Num() - 1);
+							MinEntropy = Tile.ShannonEntropy;
+							SwapIndex = 0;
+						}
+						else if (bConstrained && Tile.ShannonEntropy == MinEntropy && Tile.ShannonEntropy != InitialTile.ShannonEntropy)
+						{
+							SwapIndex += 1;
+							RemainingTiles.Swap(SwapIndex, RemainingTiles.Num() - 1);
+						}
+					}
+				}
+			}
+			return true;
+		}
+
+		void AddAdjacentIndicesToQueue(int32 CenterIndex, const TArray<int32>& RemainingTiles, TMap<int32, FWaveFunctionCollapseQueueElement>& OutQueue) const
+		{
+			const FIntVector Position = UWaveFunctionCollapseBPLibrary::IndexAsPosition(CenterIndex, Resolution);
+			for (const FWFCFaceOffset& FaceOffset : FaceOffsets)
+			{
+				const FIntVector AdjacentPosition = Position + FaceOffset.Offset;
+				const int32 AdjacentIndex = UWaveFunctionCollapseBPLibrary::PositionAsIndex(AdjacentPosition, Resolution);
+				if (IsInside(AdjacentPosition) && RemainingTiles.Contains(AdjacentIndex))
+				{
+					OutQueue.Add(AdjacentIndex, FWaveFunctionCollapseQueueElement(CenterIndex, FaceOffset.Adjacency));
+				}
+			}
+		}
+
+		int32 SelectObservedTile(const TArray<FWaveFunctionCollapseTile>& Tiles, const TArray<int32>& RemainingTiles, FRandomStream& RandomStream) const
+		{
+			int32 SelectedIndex = 0;
+			if (ObservationHeuristic == EWFCObservationHeuristic::MinRemainingValues)
+			{
+				int32 NumTies = 0;
+				for (int32 index = 0; index < RemainingTiles.Num(); index++)
+				{
+					const int32 NumOptions = Tiles[RemainingTiles[index]].RemainingOptions.Num();
+					const int32 MinNumOptions = Tiles[RemainingTiles[SelectedIndex]].RemainingOptions.Num();
+					if (index == 0 || NumOptions < MinNumOptions)
+					{
+						SelectedIndex = index;
+						NumTies = 1;
+					}
+					else if (NumOptions == MinNumOptions && RandomStream.RandHelper(++NumTies) == 0)
+					{
+						SelectedIndex = index;
+					}
+				}
+			}
+			else if (ObservationHeuristic == EWFCObservationHeuristic::WeightedEntropyNoise)
+			{
+				float MinNoisyEntropy = TNumericLimits<float>::Max();
+				for (int32 index = 0; index < RemainingTiles.Num(); index++)
+				{
+					const float NoisyEntropy = Tiles[RemainingTiles[index]].ShannonEntropy + RandomStream.FRand() * ObservationNoise;
+					if (NoisyEntropy < MinNoisyEntropy)
+					{
+						MinNoisyEntropy = NoisyEntropy;
+						SelectedIndex = index;
+					}
+				}
+			}
+			else
+			{
+				// Scanline observes the lowest remaining tile index
+				for (int32 index = 1; index < RemainingTiles.Num(); index++)
+				{
+					if (RemainingTiles[index] < RemainingTiles[SelectedIndex])
+					{
+						SelectedIndex = index;
+					}
+				}
+			}
+			return SelectedIndex;
+		}
+
+		bool Observe(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue, int32 RandomSeed) const
+		{
+			float MinEntropy = 0;
+			int32 LastSameMinEntropyIndex = 0;
+			int32 SelectedMinEntropyIndex = 0;
+			FRandomStream RandomStream(RandomSeed);
+			if (ObservationHeuristic != EWFCObservationHeuristic::MinEntropy)
+			{
+				SelectedMinEntropyIndex = SelectObservedTile(Tiles, RemainingTiles, RandomStream);
+				LastSameMinEntropyIndex = SelectedMinEntropyIndex;
+			}
+			else if (RemainingTiles.Num() > 1)
+			{
+				MinEntropy = Tiles[RemainingTiles[0]].ShannonEntropy;
+				while (LastSameMinEntropyIndex + 1 < RemainingTiles.Num() && Tiles[RemainingTiles[LastSameMinEntropyIndex + 1]].ShannonEntropy <= MinEntropy)
+				{
+					LastSameMinEntropyIndex++;
+				}
+				SelectedMinEntropyIndex = RandomStream.RandRange(0, LastSameMinEntropyIndex);
+			}
+			const int32 ObservedIndex = RemainingTiles[SelectedMinEntropyIndex];
+
+			// Weighted random option, from the weights of the constraints
+			TArray<float> CumulativeDensity;
+			float CumulativeWeight = 0;
+			for (const FWaveFunctionCollapseOption& Option : Tiles[ObservedIndex].RemainingOptions)
+			{
+				CumulativeWeight += Model->Constraints.FindChecked(Option).Weight;
+				CumulativeDensity.Add(CumulativeWeight);
+			}
+			const float RandomDensity = RandomStream.FRandRange(0.0f, CumulativeDensity.Last());
+			int32 SelectedOptionIndex = CumulativeDensity.IndexOfByPredicate([RandomDensity](float Density) { return Density > RandomDensity; });
+			SelectedOptionIndex = SelectedOptionIndex == INDEX_NONE ? 0 : SelectedOptionIndex;
+			Tiles[ObservedIndex] = FWaveFunctionCollapseTile(Tiles[ObservedIndex].RemainingOptions[SelectedOptionIndex], TNumericLimits<float>::Max());
+
+			RemainingTiles.Swap(SelectedMinEntropyIndex, LastSameMinEntropyIndex);
+			RemainingTiles.RemoveAtSwap(LastSameMinEntropyIndex);
+			if (RemainingTiles.IsEmpty())
+			{
+				return false;
+			}
+
+			// Gather the new minimum entropy tiles at the front of RemainingTiles
+			if (ObservationHeuristic == EWFCObservationHeuristic::MinEntropy && Tiles[RemainingTiles[0]].ShannonEntropy != MinEntropy)
+			{
+				int32 SwapToIndex = 0;
+				MinEntropy = Tiles[RemainingTiles[0]].ShannonEntropy;
+				for (int32 index = 1; index < RemainingTiles.Num(); index++)
+				{
+					const float Entropy = Tiles[RemainingTiles[index]].ShannonEntropy;
+					if (Entropy < MinEntropy)
+					{
+						SwapToIndex = 0;
+						MinEntropy = Entropy;
+						RemainingTiles.Swap(SwapToIndex, index);
+					}
+					else if (Entropy == MinEntropy)
+					{
+						RemainingTiles.Swap(++SwapToIndex, index);
+					}
+				}
+			}
+			AddAdjacentIndicesToQueue(ObservedIndex, RemainingTiles, ObservationQueue);
+			return true;
+		}
+
+		bool Propagate(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue) const
+		{
+			while (!ObservationQueue.IsEmpty())
+			{
+				TMap<int32, FWaveFunctionCollapseQueueElement> PropagationQueue;
+				for (const TPair<int32, FWaveFunctionCollapseQueueElement>& Element : ObservationQueue)
+				{
+					if (!RemainingTiles.Contains(Element.Key))
+					{
+						continue;
+					}
+
+					// Options allowed by any remaining option of the neighbor on this face
+					TSet<FWaveFunctionCollapseOption> AllowedOptions;
+					for (const FWaveFunctionCollapseOption& CenterOption : Tiles[Element.Value.CenterObjectIndex].RemainingOptions)
+					{
+						const FWaveFunctionCollapseAdjacencyToOptionsMap* CenterConstraint = Model->Constraints.Find(CenterOption);
+						if (const FWaveFunctionCollapseOptions* AdjacentOptions = CenterConstraint ? CenterConstraint->AdjacencyToOptionsMap.Find(Element.Value.Adjacency) : nullptr)
+						{
+							AllowedOptions.Append(AdjacentOptions->Options);
+						}
+					}
+
+					TArray<FWaveFunctionCollapseOption> NewRemainingOptions = Tiles[Element.Key].RemainingOptions.FilterByPredicate(
+						[&AllowedOptions](const FWaveFunctionCollapseOption& Option) { return AllowedOptions.Contains(Option); });
+					if (NewRemainingOptions.Num() == Tiles[Element.Key].RemainingOptions.Num())
+					{
+						continue;
+					}
+					if (NewRemainingOptions.IsEmpty())
+					{
+						return false;
+					}
+					AddAdjacentIndicesToQueue(Element.Key, RemainingTiles, PropagationQueue);
+
+					// Only MinEntropy reads the order of RemainingTiles
+					const float MinEntropy = Tiles[RemainingTiles[0]].ShannonEntropy;
+					const float NewEntropy = UWaveFunctionCollapseBPLibrary::CalculateShannonEntropy(NewRemainingOptions, Model);
+					if (ObservationHeuristic == EWFCObservationHeuristic::MinEntropy && NewEntropy < MinEntropy)
+					{
+						RemainingTiles.Swap(0, RemainingTiles.Find(Element.Key));
+					}
+					else if (ObservationHeuristic == EWFCObservationHeuristic::MinEntropy && NewEntropy == MinEntropy)
+					{
+						const int32 FirstLargerIndex = RemainingTiles.IndexOfByPredicate([&Tiles, MinEntropy](int32 TileIndex) { return Tiles[TileIndex].ShannonEntropy != MinEntropy; });
+						if (FirstLargerIndex > 0)
+						{
+							RemainingTiles.Swap(FirstLargerIndex, RemainingTiles.Find(Element.Key));
+						}
+					}
+					Tiles[Element.Key] = FWaveFunctionCollapseTile(NewRemainingOptions, NewEntropy);
+				}
+				ObservationQueue = MoveTemp(PropagationQueue);
+			}
+			return true;
+		}
+
+		bool IsSpawnable(const FWaveFunctionCollapseTile& Tile) const
+		{
+			if (Tile.RemainingOptions.Num() != 1)
+			{
+				return false;
+			}
+			const FSoftObjectPath& BaseObject = Tile.RemainingOptions[0].BaseObject;
+			return BaseObject != FWaveFunctionCollapseOption::EmptyOption.BaseObject && BaseObject != FWaveFunctionCollapseOption::VoidOption.BaseObject
+				&& !Model->SpawnExclusion.Contains(BaseObject);
+		}
+
+		bool Solve(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, int32 RandomSeed) const
+		{
+			TMap<int32, FWaveFunctionCollapseQueueElement> ObservationQueue;
+			for (int32 MutatedRandomSeed = RandomSeed; Observe(Tiles, RemainingTiles, ObservationQueue, MutatedRandomSeed); MutatedRandomSeed--)
+			{
+				if (!Propagate(Tiles, RemainingTiles, ObservationQueue))
+				{
+					return false;
+				}
+			}
+
+			// A solve without a single spawnable tile counts as failed
+			return Tiles.ContainsByPredicate([this](const FWaveFunctionCollapseTile& Tile) { return IsSpawnable(Tile); });
+		}
+	};
+}
+
+UWaveFunctionCollapseModel* FWFCSolverDifferential::MakeRandomModel(int32 ModelSeed)
+{
+	FRandomStream RandomStream(ModelSeed);
+	UWaveFunctionCollapseModel* Model = NewObject<UWaveFunctionCollapseModel>(GetTransientPackage(), NAME_None, RF_Transient);
+	Model->TileSize = 100.0f;
+
+	// Option counts of every mask width of the compiled model: one, two and four words, then the dynamic width
+	const int32 MinNumOptions[] = { 2, 65, 129, 257 };
+	const int32 MaxNumOptions[] = { 64, 128, 256, 320 };
+	const int32 MaskWidth = RandomStream.RandRange(0, 3);
+	const int32 NumOptions = RandomStream.RandRange(MinNumOptions[MaskWidth], MaxNumOptions[MaskWidth]);
+
+	// Pairs of options share a base object with different yaws, like the rotated variants of real models
+	TArray<FWaveFunctionCollapseOption> Options;
+	for (int32 OptionIndex = 0; OptionIndex < NumOptions; OptionIndex++)
+	{
+		FWaveFunctionCollapseOption& Option = Options.AddDefaulted_GetRef();
+		Option.BaseObject = FSoftObjectPath(FString::Printf(TEXT("/Game/WFCDifferential/Tile%d.Tile%d"), OptionIndex / 2, OptionIndex / 2));
+		Option.BaseRotator = FRotator(0.0, (OptionIndex % 2) * 90.0, 0.0);
+		Model->Constraints.Add(Option).Weight = RandomStream.FRandRange(0.25f, 2.0f);
+	}
+
+	// Allowing B on a face of A also allows A on the opposite face of B, as the solver expects
+	const float Density = RandomStream.FRandRange(0.3f, 0.8f);
+	for (const FWaveFunctionCollapseOption& Option : Options)
+	{
+		for (const FWaveFunctionCollapseOption& AdjacentOption : Options)
+		{
+			for (int32 Face = 0; Face < UE_ARRAY_COUNT(FaceOffsets); Face += 2)
+			{
+				if (RandomStream.FRand() < Density)
+				{
+					Model->Constraints[Option].AdjacencyToOptionsMap.FindOrAdd(FaceOffsets[Face].Adjacency).Options.AddUnique(AdjacentOption);
+					Model->Constraints[AdjacentOption].AdjacencyToOptionsMap.FindOrAdd(FaceOffsets[Face].Opposite).Options.AddUnique(Option);
+				}
+			}
+		}
+	}
+	return Model;
+}
+
+bool FWFCSolverDifferential::SolveReference(UWaveFunctionCollapseModel* Model, const FWFCSolverContext& Settings, int32 TryCount, int32& InOutRandomSeed, TArray<FWaveFunctionCollapseTile>& OutTiles)
+{
+	FWFCReferenceSolver ReferenceSolver;
+	ReferenceSolver.Model = Model;
+	ReferenceSolver.Resolution = Settings.Resolution;
+	ReferenceSolver.StarterOptions = Settings.StarterOptions;
+	ReferenceSolver.bUseEmptyBorder = Settings.bUseEmptyBorder;
+	ReferenceSolver.ObservationHeuristic = Settings.ObservationHeuristic;
+	ReferenceSolver.ObservationNoise = Settings.ObservationNoise;
+
+	TArray<FWaveFunctionCollapseTile> InitialTiles;
+	TArray<int32> InitialRemainingTiles;
+	if (!Model || !ReferenceSolver.Initialize(InitialTiles, InitialRemainingTiles))
+	{
+		return false;
+	}
+
+	// Retry seeds are drawn like SolveTiles does
+	FRandomStream RandomStream(InOutRandomSeed);
+	for (int32 CurrentTry = 1; CurrentTry <= TryCount; CurrentTry++)
+	{
+		if (CurrentTry > 1)
+		{
+			InOutRandomSeed = RandomStream.RandRange(1, TNumericLimits<int32>::Max());
+		}
+		OutTiles = InitialTiles;
+		TArray<int32> RemainingTiles = InitialRemainingTiles;
+		if (ReferenceSolver.Solve(OutTiles, RemainingTiles, InOutRandomSeed))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FWFCSolverDifferential::CheckTiling(const UWaveFunctionCollapseModel* Model, const TArray<FWaveFunctionCollapseTile>& Tiles, const FIntVector& Resolution,
+	const TMap<FIntVector, FWaveFunctionCollapseOption>& StarterOptions, FString& OutError)
+{
+	if (Tiles.Num() != Resolution.X * Resolution.Y * Resolution.Z)
+	{
+		OutError = FString::Printf(TEXT("%d tiles for resolution %s"), Tiles.Num(), *Resolution.ToString());
+		return false;
+	}
+
+	for (int32 TileIndex = 0; TileIndex < Tiles.Num(); TileIndex++)
+	{
+		const FIntVector Position = UWaveFunctionCollapseBPLibrary::IndexAsPosition(TileIndex, Resolution);
+		if (Tiles[TileIndex].RemainingOptions.Num() != 1)
+		{
+			OutError = FString::Printf(TEXT("cell %s has %d options"), *Position.ToString(), Tiles[TileIndex].RemainingOptions.Num());
+			return false;
+		}
+
+		const FWaveFunctionCollapseOption& Option = Tiles[TileIndex].RemainingOptions[0];
+		const FWaveFunctionCollapseOption* StarterOption = StarterOptions.Find(Position);
+		if (StarterOption && !(*StarterOption == Option))
+		{
+			OutError = FString::Printf(TEXT("starter cell %s lost its option"), *Position.ToString());
+			return false;
+		}
+		const FWaveFunctionCollapseAdjacencyToOptionsMap* Constraint = Model->Constraints.Find(Option);
+		if (!Constraint)
+		{
+			OutError = FString::Printf(TEXT("cell %s holds %s, which is not in the model"), *Position.ToString(), *Option.BaseObject.ToString());
+			return false;
+		}
+
+		for (const FWFCFaceOffset& FaceOffset : FaceOffsets)
+		{
+			const FIntVector AdjacentPosition = Position + FaceOffset.Offset;
+			if (AdjacentPosition.X < 0 || AdjacentPosition.Y < 0 || AdjacentPosition.Z < 0
+				|| AdjacentPosition.X >= Resolution.X || AdjacentPosition.Y >= Resolution.Y || AdjacentPosition.Z >= Resolution.Z)
+			{
+				continue;
+			}
+
+			// Cells with several options are reported at their own index
+			const FWaveFunctionCollapseTile& AdjacentTile = Tiles[UWaveFunctionCollapseBPLibrary::PositionAsIndex(AdjacentPosition, Resolution)];
+			if (AdjacentTile.RemainingOptions.Num() != 1)
+			{
+				continue;
+			}
+			const FWaveFunctionCollapseOptions* AllowedOptions = Constraint->AdjacencyToOptionsMap.Find(FaceOffset.Adjacency);
+			if (!AllowedOptions || !AllowedOptions->Options.Contains(AdjacentTile.RemainingOptions[0]))
+			{
+				OutError = FString::Printf(TEXT("cells %s and %s are not allowed next to each other"), *Position.ToString(), *AdjacentPosition.ToString());
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -1,12 +1,186 @@
 ﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "hackaton_city/Public/WFCSubsystem.h"
-#include "Engine/Blueprint.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/InheritableComponentHandler.h"
+#include "Engine/SCS_Node.h"
+#include "Engine/SimpleConstructionScript.h"
 #include "Engine/StaticMesh.h"
 #include "WaveFunctionCollapseBPLibrary.h"
 #include "Components/InstancedStaticMeshComponent.h"
-#include "Kismet2/ComponentEditorUtils.h"
-#include "Editor.h"
+#include "Materials/MaterialInterface.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "hackaton_city/Public/WFCChunkNavigationComponent.h"
+#include "hackaton_city/Public/WFCCitySnapshot.h"
+#include "hackaton_city/Public/WFCReplication.h"
+#include "hackaton_city/Public/WFCSolverDifferential.h"
+#if WITH_EDITOR
+#include "ActorEditorUtils.h"
+#endif
+#include <atomic>
+
+const FName UWFCSubsystem::SpawnAsActorTag(TEXT("WFCSpawnAsActor"));
+const FName UWFCSubsystem::CollisionComponentTag(TEXT("WFCCollision"));
+const FName UWFCSubsystem::ChunkProxyComponentTag(TEXT("WFCChunkProxy"));
+
+// Evicted chunks come back slightly inside the eviction radius, so chunks on the edge do not thrash
+static constexpr float ChunkRematerializeRadiusRatio = 0.9f;
+
+// Chunk collision is disabled slightly outside the collision radius, so chunks on the edge do not thrash
+static constexpr float CollisionDisableRadiusRatio = 1.25f;
+
+// Cells per side of the pages of ChunkCellPages, a chunk usually overlaps a few pages
+static constexpr int32 ChunkCellPageSize = 16;
+
+static FIntVector GetChunkCellPage(const FIntVector& AbsoluteCell)
+{
+	auto FloorDivide = [](int32 Value, int32 Divisor) { return Value >= 0 ? Value / Divisor : (Value - Divisor + 1) / Divisor; };
+	return FIntVector(FloorDivide(AbsoluteCell.X, ChunkCellPageSize), FloorDivide(AbsoluteCell.Y, ChunkCellPageSize), FloorDivide(AbsoluteCell.Z, ChunkCellPageSize));
+}
+
+static bool HasSimpleCollision(const UStaticMesh* StaticMesh)
+{
+	const UBodySetup* BodySetup = StaticMesh->GetBodySetup();
+	return BodySetup && BodySetup->AggGeom.GetElementCount() > 0;
+}
+
+static UWFCSubsystem* GetWFCSubsystem(UWorld* World)
+{
+	return World ? World->GetSubsystem<UWFCSubsystem>() : nullptr;
+}
+
+static FAutoConsoleCommandWithWorld GWFCChunkReportCommand(
+	TEXT("wfc.Chunks.Report"),
+	TEXT("Log the estimated memory of every generated WFC chunk"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->LogChunkMemoryReport();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWFCCachePrepopulateCommand(
+	TEXT("wfc.Cache.Prepopulate"),
+	TEXT("Solve boundary variants in bulk into the solution cache and save it: wfc.Cache.Prepopulate <NumVariants>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->PrepopulateSolutionCache(Args.IsEmpty() ? 1000 : FCString::Atoi(*Args[0]));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GWFCCacheStatsCommand(
+	TEXT("wfc.Cache.Stats"),
+	TEXT("Log the entries and hit rate of the solution cache"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->SolutionCache.LogStats();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWFCBenchmarkHeuristicsCommand(
+	TEXT("wfc.Benchmark.Heuristics"),
+	TEXT("Time every observation heuristic on an empty window and log their failure rate: wfc.Benchmark.Heuristics <NumSolves>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->BenchmarkObservationHeuristics(Args.IsEmpty() ? 100 : FCString::Atoi(*Args[0]));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWFCVerifySolverCommand(
+	TEXT("wfc.Verify.Solver"),
+	TEXT("Compare the solver paths against the reference solver on random models: wfc.Verify.Solver <NumModels> <NumSeeds> <HarnessSeed>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->RunSolverDifferential(
+				Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 20,
+				Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 50,
+				Args.IsValidIndex(2) ? FCString::Atoi(*Args[2]) : 1);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWFCCitySaveCommand(
+	TEXT("wfc.City.Save"),
+	TEXT("Save the generated city to a snapshot: wfc.City.Save <SlotName>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->SaveCity(Args.IsEmpty() ? TEXT("City") : Args[0]);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWFCCityLoadCommand(
+	TEXT("wfc.City.Load"),
+	TEXT("Replace the generated city with a snapshot: wfc.City.Load <SlotName>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->LoadCity(Args.IsEmpty() ? TEXT("City") : Args[0]);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GWFCJournalStartCommand(
+	TEXT("wfc.Journal.Start"),
+	TEXT("Start recording the generation requests into a session journal"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->StartJournal();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWFCJournalStopCommand(
+	TEXT("wfc.Journal.Stop"),
+	TEXT("Stop recording and save the session journal: wfc.Journal.Stop <SlotName>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->StopJournal(Args.IsEmpty() ? TEXT("Session") : Args[0]);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWFCJournalReplayCommand(
+	TEXT("wfc.Journal.Replay"),
+	TEXT("Replace the generated city by replaying a session journal and log the time of each request: wfc.Journal.Replay <SlotName>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWFCSubsystem* Subsystem = GetWFCSubsystem(World))
+		{
+			Subsystem->ReplayJournal(Args.IsEmpty() ? TEXT("Session") : Args[0]);
+		}
+	}));
+
+static int64 EstimateActorMemoryBytes(const AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return 0;
+	}
+
+	int64 MemoryBytes = Actor->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	for (const UActorComponent* Component : Actor->GetComponents())
+	{
+		MemoryBytes += Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+	return MemoryBytes;
+}
 
 FIntVector RelativeToAbsolute(FIntVector relativeGridPosition, FVector originLocation, float tileSize)
 {
@@ -33,75 +207,103 @@ FIntVector AbsoluteToRelative(FIntVector absoluteGridPosition, FVector originLoc
 
 AActor* UWFCSubsystem::Collapse(int32 TryCount /* = 1 */, int32 RandomSeed /* = 0 */)
 {
-	// Create new starting options from the placed tiles
-	// Convert from absolute to relative
-	StarterOptions.Empty();
-	for (const auto& [absoluteGridPosition, option] : PlacedTiles)
-	{
-		const FIntVector zeroCenteredTilePosition = AbsoluteToRelative(absoluteGridPosition, OriginLocation, WFCModel->TileSize);
-		const FIntVector zeroStartingTilePosition = zeroCenteredTilePosition + Resolution / 2;
-		StarterOptions.Add(zeroStartingTilePosition, option);
-	}
-	
 	if (!WFCModel)
 	{
 		UE_LOG(LogTemp, Error, TEXT("Invalid WFC Model"));
 		return nullptr;
 	}
-	
-	UE_LOG(LogTemp, Display, TEXT("Starting WFC - Model: %s, Resolution %dx%dx%d"), *WFCModel->GetFName().ToString(), Resolution.X, Resolution.Y, Resolution.Z);
-
-	// Determinism settings
-	int32 ChosenRandomSeed = (RandomSeed != 0 ? RandomSeed : FMath::RandRange(1, TNumericLimits<int32>::Max()));
+	if (!CompiledModel->IsValid())
+	{
+		CompileModel();
+	}
+	SyncSolutionCache();
 
-	int32 ArrayReserveValue = Resolution.X * Resolution.Y * Resolution.Z;
-	TArray<FWaveFunctionCollapseTile> Tiles;
-	TArray<int32> RemainingTiles;
-	TMap<int32, FWaveFunctionCollapseQueueElement> ObservationQueue;
-	Tiles.Reserve(ArrayReserveValue);
-	RemainingTiles.Reserve(ArrayReserveValue);
+	// Random seeds are written to the entry once drawn, so the replay makes the same attempts
+	FWFCJournalEntry* JournalEntry = nullptr;
+	if (bRecordingJournal)
+	{
+		JournalEntry = &Journal.Entries.AddDefaulted_GetRef();
+		JournalEntry->Time = FPlatformTime::Seconds() - JournalStartTime;
+		JournalEntry->OriginLocation = OriginLocation;
+		JournalEntry->Resolution = Solver.Resolution;
+		JournalEntry->TryCount = TryCount;
+		JournalEntry->Seed = RandomSeed;
+		JournalEntry->ModelHash = CompiledModel->ModelHash;
+		JournalEntry->bDeterministic = bDeterministicGeneration;
+	}
 
-	InitializeWFC(Tiles, RemainingTiles);
-	
-	bool bSuccessfulSolve = false;
+	// Deterministic chunks lie on a fixed lattice, the hit cell selects the chunk containing it
+	const FIntVector HitCell = RelativeToAbsolute(FIntVector::ZeroValue, OriginLocation, WFCModel->TileSize);
+	const FIntVector ChunkCoord = GetChunkCoord(HitCell);
+	const FIntVector OriginCell = bDeterministicGeneration ? GetChunkOriginCell(ChunkCoord) : HitCell;
 
-	if (TryCount > 1)
+	// A chunk already generated at this origin is re-materialized instead of solved again
+	if (Chunks.Contains(OriginCell))
 	{
-		//Copy Original Initialized tiles
-		TArray<FWaveFunctionCollapseTile> TilesCopy = Tiles;
-		TArray<int32> RemainingTilesCopy = RemainingTiles;
+		UE_LOG(LogTemp, Display, TEXT("Chunk already generated at %s"), *OriginCell.ToString());
+		return RematerializeChunk(OriginCell);
+	}
 
-		int32 CurrentTry = 1;
-		bSuccessfulSolve = ObservationPropagation(Tiles, RemainingTiles, ObservationQueue, ChosenRandomSeed);
-		FRandomStream RandomStream(ChosenRandomSeed);
-		while (!bSuccessfulSolve && CurrentTry<TryCount)
+	if (bDeterministicGeneration)
+	{
+		AActor* SpawnedActor = SpawnDeterministicChunk(ChunkCoord, DeterministicTryCount, GetChunkSeed(ChunkCoord));
+		if (const FWFCChunk* SpawnedChunk = SpawnedActor ? Chunks.Find(OriginCell) : nullptr)
 		{
-			CurrentTry += 1;
-			UE_LOG(LogTemp, Warning, TEXT("Failed with Seed Value: %d. Trying again.  Attempt number: %d"), ChosenRandomSeed, CurrentTry);
-			ChosenRandomSeed = RandomStream.RandRange(1, TNumericLimits<int32>::Max());
-			
-			// Start from Original Initialized tiles
-			Tiles = TilesCopy;
-			RemainingTiles = RemainingTilesCopy;
-			ObservationQueue.Empty();
-			bSuccessfulSolve = ObservationPropagation(Tiles, RemainingTiles, ObservationQueue, ChosenRandomSeed);
+			RecordGenerationEvent(*SpawnedChunk, TArray<uint32>());
 		}
+		return SpawnedActor;
 	}
-	else if (TryCount == 1)
+
+	// Create new starting options from the tiles placed inside the solve window, resident or evicted
+	TMap<FIntVector, FWaveFunctionCollapseOption> ProvisionalStarterOptions;
+	GatherWindowStarterOptions(OriginLocation, Solver.StarterOptions, ProvisionalStarterOptions);
+	
+	UE_LOG(LogTemp, Display, TEXT("Starting WFC - Model: %s, Resolution %dx%dx%d"), *WFCModel->GetFName().ToString(), Solver.Resolution.X, Solver.Resolution.Y, Solver.Resolution.Z);
+
+	TArray<FWaveFunctionCollapseTile>& Tiles = Solver.SolveArena.Tiles;
+	int32 ChosenRandomSeed = 0;
+	bool bSuccessfulSolve = false;
+
+	// The projectile that triggered this Collapse may have solved the window while in flight
+	int32 SpeculativeFirstRandomSeed = 0;
+	if (RandomSeed == 0 && CommitSpeculativeSolve(TryCount, ProvisionalStarterOptions, SpeculativeFirstRandomSeed, ChosenRandomSeed))
 	{
-		bSuccessfulSolve = ObservationPropagation(Tiles, RemainingTiles, ObservationQueue, ChosenRandomSeed);
+		UE_LOG(LogTemp, Display, TEXT("Committed the speculative solve of the window"));
+		if (JournalEntry)
+		{
+			JournalEntry->Seed = SpeculativeFirstRandomSeed;
+		}
+		bSuccessfulSolve = true;
 	}
 	else
 	{
-		UE_LOG(LogTemp, Error, TEXT("Invalid TryCount on Collapse: %d"), TryCount);
-		return nullptr;
+		// Determinism settings
+		ChosenRandomSeed = (RandomSeed != 0 ? RandomSeed : FMath::RandRange(1, RandomSeedPoolSize > 0 ? RandomSeedPoolSize : TNumericLimits<int32>::Max()));
+		if (JournalEntry)
+		{
+			JournalEntry->Seed = ChosenRandomSeed;
+		}
+
+		GatherWindowDistrictIds(RelativeToAbsolute(FIntVector::ZeroValue - Solver.Resolution / 2, OriginLocation, WFCModel->TileSize), Solver.WindowDistrictIds);
+		bSuccessfulSolve = Solver.SolveWindow(TryCount, ProvisionalStarterOptions, ChosenRandomSeed);
 	}
 
 	// if Successful, Spawn Actor
 	if (bSuccessfulSolve)
 	{
-		AActor* SpawnedActor = SpawnActorFromTiles(Tiles);
-		UE_LOG(LogTemp, Display, TEXT("Success! Seed Value: %d. Spawned Actor: %s"), ChosenRandomSeed, *SpawnedActor->GetActorLabel());
+		AActor* SpawnedActor = SpawnActorFromTiles(Tiles, ChosenRandomSeed);
+		TArray<uint32> BoundaryCells;
+		const FWFCChunk* SpawnedChunk = SpawnedActor ? Chunks.Find(OriginCell) : nullptr;
+		if (SpawnedChunk && Solver.GatherBoundaryCells(BoundaryCells))
+		{
+			RecordGenerationEvent(*SpawnedChunk, MoveTemp(BoundaryCells));
+		}
+		else if (SpawnedChunk && GetWorld()->GetNetMode() != NM_Standalone)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Chunk %s is not replicated, the starter options of its %dx%dx%d window cannot be encoded"),
+				*OriginCell.ToString(), Solver.Resolution.X, Solver.Resolution.Y, Solver.Resolution.Z);
+		}
+		UE_LOG(LogTemp, Display, TEXT("Success! Seed Value: %d. Spawned Actor: %s"), ChosenRandomSeed, SpawnedActor ? *SpawnedActor->GetActorNameOrLabel() : TEXT("None"));
 		return SpawnedActor;
 	}
 	else
@@ -111,610 +313,2321 @@ AActor* UWFCSubsystem::Collapse(int32 TryCount /* = 1 */, int32 RandomSeed /* =
 	}
 }
 
-void UWFCSubsystem::InitializeWFC(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles)
+void UWFCSubsystem::SpeculateCollapse(const FVector& Location, int32 TryCount /* = 1 */)
 {
-	FWaveFunctionCollapseTile InitialTile;
-	int32 SwapIndex = 0;
+	if (!bSpeculativeSolves || bDeterministicGeneration || !WFCModel || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
 
-	if (BuildInitialTile(InitialTile))
+	// The same window is already being solved
+	if (SpeculativeSolve && SpeculativeSolve->bPending && !SpeculativeSolve->bCancelled && SpeculativeSolve->OriginLocation == Location && SpeculativeSolve->TryCount == TryCount)
 	{
-		float MinEntropy = InitialTile.ShannonEntropy;
-		for (int32 Z = 0;Z < Resolution.Z; Z++)
-		{
-			for (int32 Y = 0;Y < Resolution.Y; Y++)
-			{
-				for (int32 X = 0;X < Resolution.X; X++)
-				{
-					// Pre-populate with starter tiles
-					if (FWaveFunctionCollapseOption* StarterOption = StarterOptions.Find(FIntVector(X, Y, Z)))
-					{
-						FWaveFunctionCollapseTile StarterTile;
-						StarterTile.RemainingOptions.Add(*StarterOption);
-						StarterTile.ShannonEntropy = UWaveFunctionCollapseBPLibrary::CalculateShannonEntropy(StarterTile.RemainingOptions, WFCModel);
-						Tiles.Add(StarterTile);
-						RemainingTiles.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(FIntVector(X, Y, Z), Resolution));
-						
-						// swap lower entropy tile to the beginning of RemainingTiles
-						if (StarterTile.ShannonEntropy < MinEntropy)
-						{
-							RemainingTiles.Swap(0, RemainingTiles.Num() - 1);
-							MinEntropy = StarterTile.ShannonEntropy;
-							SwapIndex = 0;
-						}
-						
-						// else, swap min entropy tile with the previous min entropy index+1
-						else if (StarterTile.ShannonEntropy == MinEntropy && StarterTile.ShannonEntropy != InitialTile.ShannonEntropy)
-						{
-							SwapIndex += 1;
-							RemainingTiles.Swap(SwapIndex, RemainingTiles.Num() - 1);
-						}
-					}
-					
-					//// Pre-populate with border tiles
-					//else if (IsPositionInnerBorder(FIntVector(X, Y, Z))
-					//	&& (bUseEmptyBorder || WFCModel->Constraints.Contains(FWaveFunctionCollapseOption::BorderOption)))
-					//{
-					//	FWaveFunctionCollapseTile BorderTile;
-					//	BorderTile.RemainingOptions = GetInnerBorderOptions(FIntVector(X, Y, Z), InitialTile.RemainingOptions);
-					//	BorderTile.ShannonEntropy = UWaveFunctionCollapseBPLibrary::CalculateShannonEntropy(BorderTile.RemainingOptions, WFCModel);
-					//	Tiles.Add(BorderTile);
-					//	RemainingTiles.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(FIntVector(X, Y, Z), Resolution));
-					//
-					//	// swap lower entropy tile to the beginning of RemainingTiles
-					//	if (BorderTile.ShannonEntropy < MinEntropy)
-					//	{
-					//		RemainingTiles.Swap(0, RemainingTiles.Num() - 1);
-					//		MinEntropy = BorderTile.ShannonEntropy;
-					//		SwapIndex = 0;
-					//	}
-					//	
-					//	// else, swap min entropy tile with the previous min entropy index+1
-					//	else if (BorderTile.ShannonEntropy ==  MinEntropy && BorderTile.ShannonEntropy != InitialTile.ShannonEntropy)
-					//	{
-					//		SwapIndex += 1;
-					//		RemainingTiles.Swap(SwapIndex, RemainingTiles.Num() - 1);
-					//	}
-					//}
-					
-					// Fill the rest with initial tiles
-					else
-					{
-						Tiles.Add(InitialTile);
-						RemainingTiles.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(FIntVector(X, Y, Z), Resolution));
-					}
-				}
-			}
-		}
-		// Keep the same starting options for the next run
-		// StarterOptions.Empty();
+		return;
 	}
-	else
+	if (!CompiledModel->IsValid())
+	{
+		CompileModel();
+	}
+	if (Chunks.Contains(RelativeToAbsolute(FIntVector::ZeroValue, Location, WFCModel->TileSize)))
+	{
+		return;
+	}
+
+	// The newer shot replaces the last speculation.  The solver context is busy until its solve stops, which happens at its next observation once cancelled.
+	if (SpeculativeSolve)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Could not create Initial Tile from Model"));
+		SpeculativeSolve->bCancelled = true;
+		SpeculativeSolve->Task.Wait();
 	}
 
+	// The solver context shares the immutable compiled models and the solve settings, everything depending on the placed tiles is gathered here on the game thread.
+	// The worker reads no UObject, so a model recompiled meanwhile cannot race with it.  It has no solution cache, the cache of the world is not thread-safe.
+	SpeculativeSolver.CopySettings(Solver);
+	SpeculativeSolver.SolutionCache = nullptr;
+
+	TUniquePtr<FWFCSpeculativeSolve> Speculation = MakeUnique<FWFCSpeculativeSolve>();
+	Speculation->OriginLocation = Location;
+	Speculation->Resolution = Solver.Resolution;
+	Speculation->TryCount = TryCount;
+	Speculation->ModelHash = CompiledModel->ModelHash;
+	Speculation->SolverSettingsHash = Solver.GetSolverSettingsHash();
+	Speculation->RandomSeed = FMath::RandRange(1, RandomSeedPoolSize > 0 ? RandomSeedPoolSize : TNumericLimits<int32>::Max());
+	GatherWindowStarterOptions(Location, Speculation->PlacedStarterOptions, Speculation->ProvisionalStarterOptions);
+	GatherWindowDistrictIds(RelativeToAbsolute(FIntVector::ZeroValue - Solver.Resolution / 2, Location, WFCModel->TileSize), SpeculativeSolver.WindowDistrictIds);
+	SpeculativeSolver.StarterOptions = Speculation->PlacedStarterOptions;
+	SpeculativeSolver.CancelSolve = &Speculation->bCancelled;
+
+	Speculation->Task = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[SpeculationSolver = &SpeculativeSolver, TryCount, ProvisionalStarterOptions = Speculation->ProvisionalStarterOptions, RandomSeed = Speculation->RandomSeed]() mutable -> TOptional<int32>
+	{
+		return SpeculationSolver->SolveWindow(TryCount, ProvisionalStarterOptions, RandomSeed) ? TOptional<int32>(RandomSeed) : TOptional<int32>();
+	});
+	SpeculativeSolve = MoveTemp(Speculation);
+}
+
+FVector UWFCSubsystem::GetCollapseLocation(const FVector& HitLocation) const
+{
+	const float TileSize = WFCModel ? WFCModel->TileSize : 1.0f;
+	return FVector(FMath::FloorToFloat(HitLocation.X / TileSize) * TileSize, FMath::FloorToFloat(HitLocation.Y / TileSize) * TileSize, 0.0);
 }
 
-bool UWFCSubsystem::BuildInitialTile(FWaveFunctionCollapseTile& InitialTile)
+bool UWFCSubsystem::CommitSpeculativeSolve(int32 TryCount, const TMap<FIntVector, FWaveFunctionCollapseOption>& ProvisionalStarterOptions, int32& OutFirstRandomSeed, int32& OutRandomSeed)
 {
-	TArray<FWaveFunctionCollapseOption> InitialOptions;
-	for (const TPair< FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap>& Constraint : WFCModel->Constraints)
+	if (!SpeculativeSolve || !SpeculativeSolve->bPending)
 	{
-		if (Constraint.Key.BaseObject != FWaveFunctionCollapseOption::BorderOption.BaseObject)
-		{
-			InitialOptions.Add(Constraint.Key);
-		}
+		return false;
 	}
+	FWFCSpeculativeSolve& Speculation = *SpeculativeSolve;
+	Speculation.bPending = false;
 
-	if (!InitialOptions.IsEmpty())
+	// Any tile placed or evicted around the window since the speculation started changes the solve Collapse would make
+	const bool bSameWindow = Speculation.OriginLocation == OriginLocation && Speculation.Resolution == Solver.Resolution && Speculation.TryCount == TryCount
+		&& Speculation.ModelHash == CompiledModel->ModelHash && Speculation.SolverSettingsHash == Solver.GetSolverSettingsHash()
+		&& Speculation.PlacedStarterOptions.OrderIndependentCompareEqual(Solver.StarterOptions)
+		&& Speculation.ProvisionalStarterOptions.OrderIndependentCompareEqual(ProvisionalStarterOptions);
+	if (!bSameWindow)
 	{
-		InitialTile.RemainingOptions = InitialOptions;
-		InitialTile.ShannonEntropy = UWaveFunctionCollapseBPLibrary::CalculateShannonEntropy(InitialOptions, WFCModel);
-		return true;
+		UE_LOG(LogTemp, Display, TEXT("Speculative solve at %s dropped, the window changed or another one is collapsed"), *Speculation.OriginLocation.ToString());
+		Speculation.bCancelled = true;
+		NumSpeculativeMisses++;
+		return false;
 	}
-	else
+
+	// Usually completed while the projectile was in flight, otherwise this still saves the time it already ran
+	const TOptional<int32>& SolvedRandomSeed = Speculation.Task.GetResult();
+	Solver.NumProvisionalAdoptions += SpeculativeSolver.NumProvisionalAdoptions;
+	Solver.NumProvisionalRejections += SpeculativeSolver.NumProvisionalRejections;
+	SpeculativeSolver.NumProvisionalAdoptions = 0;
+	SpeculativeSolver.NumProvisionalRejections = 0;
+	if (!SolvedRandomSeed.IsSet())
 	{
+		NumSpeculativeMisses++;
 		return false;
 	}
+
+	// The starter options of the solver context include the provisional tiles if it adopted them, like after SolveWindow
+	Swap(Solver.SolveArena.Tiles, SpeculativeSolver.SolveArena.Tiles);
+	Solver.StarterOptions = MoveTemp(SpeculativeSolver.StarterOptions);
+	OutFirstRandomSeed = Speculation.RandomSeed;
+	OutRandomSeed = SolvedRandomSeed.GetValue();
+	NumSpeculativeCommits++;
+	return true;
 }
 
-//TArray<FWaveFunctionCollapseOption> UWFCSubsystem::GetInnerBorderOptions(FIntVector Position, const TArray<FWaveFunctionCollapseOption>& InitialOptions)
-//{
-//	TArray<FWaveFunctionCollapseOption> InnerBorderOptions;
-//	TArray<FWaveFunctionCollapseOption> InnerBorderOptionsToRemove;
-//	InnerBorderOptions = InitialOptions;
-//	
-//	// gather options to remove
-//	if (Position.X == 0)
-//	{
-//		GatherInnerBorderOptionsToRemove(EWaveFunctionCollapseAdjacency::Front, InnerBorderOptions, InnerBorderOptionsToRemove);
-//	}
-//	if (Position.X == Resolution.X - 1)
-//	{
-//		GatherInnerBorderOptionsToRemove(EWaveFunctionCollapseAdjacency::Back, InnerBorderOptions, InnerBorderOptionsToRemove);
-//	}
-//	if (Position.Y == 0)
-//	{
-//		GatherInnerBorderOptionsToRemove(EWaveFunctionCollapseAdjacency::Right, InnerBorderOptions, InnerBorderOptionsToRemove);
-//	}
-//	if (Position.Y == Resolution.Y - 1)
-//	{
-//		GatherInnerBorderOptionsToRemove(EWaveFunctionCollapseAdjacency::Left, InnerBorderOptions, InnerBorderOptionsToRemove);
-//	}
-//	if (Position.Z == 0)
-//	{
-//		GatherInnerBorderOptionsToRemove(EWaveFunctionCollapseAdjacency::Up, InnerBorderOptions, InnerBorderOptionsToRemove);
-//	}
-//	if (Position.Z == Resolution.Z - 1)
-//	{
-//		GatherInnerBorderOptionsToRemove(EWaveFunctionCollapseAdjacency::Down, InnerBorderOptions, InnerBorderOptionsToRemove);
-//	}
-//	
-//	//remove options
-//	if (!InnerBorderOptionsToRemove.IsEmpty())
-//	{
-//		for (FWaveFunctionCollapseOption& RemoveThisOption : InnerBorderOptionsToRemove)
-//		{
-//			InnerBorderOptions.RemoveSingleSwap(RemoveThisOption, EAllowShrinking::No);
-//		}
-//		InnerBorderOptions.Shrink();
-//	}
-//	
-//	return InnerBorderOptions;
-//}
-
-//void UWFCSubsystem::GatherInnerBorderOptionsToRemove(EWaveFunctionCollapseAdjacency Adjacency, const TArray<FWaveFunctionCollapseOption>& InitialOptions, TArray<FWaveFunctionCollapseOption>& OutBorderOptionsToRemove)
-//{
-//	bool bFoundBorderOptions = false;
-//	for (const FWaveFunctionCollapseOption& InitialOption : InitialOptions)
-//	{
-//		// if border option exists in the model, use it
-//		if (FWaveFunctionCollapseAdjacencyToOptionsMap* FoundBorderAdjacencyToOptionsMap = WFCModel->Constraints.Find(FWaveFunctionCollapseOption::BorderOption))
-//		{
-//			if (FWaveFunctionCollapseOptions* FoundBorderOptions = FoundBorderAdjacencyToOptionsMap->AdjacencyToOptionsMap.Find(Adjacency))
-//			{
-//				if (!FoundBorderOptions->Options.Contains(InitialOption))
-//				{
-//					OutBorderOptionsToRemove.AddUnique(InitialOption);
-//					bFoundBorderOptions = true;
-//				}
-//			}
-//		}
-//		
-//		// else, if useEmptyBorder, use empty option
-//		if (bUseEmptyBorder && !bFoundBorderOptions)
-//		{
-//			if (FWaveFunctionCollapseAdjacencyToOptionsMap* FoundEmptyAdjacencyToOptionsMap = WFCModel->Constraints.Find(FWaveFunctionCollapseOption::EmptyOption))
-//			{
-//				if (FWaveFunctionCollapseOptions* FoundEmptyOptions = FoundEmptyAdjacencyToOptionsMap->AdjacencyToOptionsMap.Find(Adjacency))
-//				{
-//					if (!FoundEmptyOptions->Options.Contains(InitialOption))
-//					{
-//						OutBorderOptionsToRemove.AddUnique(InitialOption);
-//					}
-//				}
-//			}
-//		}
-//	}
-//}
-
-//bool UWFCSubsystem::IsPositionInnerBorder(FIntVector Position)
-//{
-//	return (Position.X == 0
-//		|| Position.Y == 0
-//		|| Position.Z == 0
-//		|| Position.X == Resolution.X - 1
-//		|| Position.Y == Resolution.Y - 1
-//		|| Position.Z == Resolution.Z - 1);
-//}
-
-bool UWFCSubsystem::Observe(TArray<FWaveFunctionCollapseTile>& Tiles, 
-	TArray<int32>& RemainingTiles, 
-	TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue,
-	int32 RandomSeed)
-{
-	float MinEntropy = 0;
-	int32 LastSameMinEntropyIndex = 0;
-	int32 SelectedMinEntropyIndex = 0;
-	int32 MinEntropyIndex = 0;
-	FRandomStream RandomStream(RandomSeed);
-
-	// Find MinEntropy Tile Indices
-	if (RemainingTiles.Num() > 1)
-	{
-		for (int32 index = 0; index<RemainingTiles.Num(); index++)
-		{
-			if (index == 0)
-			{
-				MinEntropy = Tiles[RemainingTiles[index]].ShannonEntropy;
-			}
-			else
+void UWFCSubsystem::GatherWindowStarterOptions(const FVector& WindowOrigin, TMap<FIntVector, FWaveFunctionCollapseOption>& OutPlacedStarterOptions, TMap<FIntVector, FWaveFunctionCollapseOption>& OutProvisionalStarterOptions)
+{
+	// Convert from relative to absolute
+	OutPlacedStarterOptions.Reset();
+	OutProvisionalStarterOptions.Reset();
+	for (int32 Z = 0; Z < Solver.Resolution.Z; Z++)
+	{
+		for (int32 Y = 0; Y < Solver.Resolution.Y; Y++)
+		{
+			for (int32 X = 0; X < Solver.Resolution.X; X++)
 			{
-				if (Tiles[RemainingTiles[index]].ShannonEntropy > MinEntropy)
+				const FIntVector zeroStartingTilePosition(X, Y, Z);
+				const FIntVector absoluteGridPosition = RelativeToAbsolute(zeroStartingTilePosition - Solver.Resolution / 2, WindowOrigin, WFCModel->TileSize);
+				FWaveFunctionCollapseOption PlacedOption;
+				if (FindPlacedOption(absoluteGridPosition, PlacedOption))
 				{
-					break;
+					OutPlacedStarterOptions.Add(zeroStartingTilePosition, PlacedOption);
 				}
-				else
+				else if (const FWaveFunctionCollapseOption* ProvisionalOption = bReuseProvisionalTiles ? CompiledModel->GetOption(ProvisionalTiles.Find(absoluteGridPosition)) : nullptr)
 				{
-					LastSameMinEntropyIndex += 1;
+					OutProvisionalStarterOptions.Add(zeroStartingTilePosition, *ProvisionalOption);
 				}
 			}
 		}
-		SelectedMinEntropyIndex = RandomStream.RandRange(0, LastSameMinEntropyIndex);
-		MinEntropyIndex = RemainingTiles[SelectedMinEntropyIndex];
 	}
-	else
+}
+
+void UWFCSubsystem::PrepopulateSolutionCache(int32 NumVariants /* = 1000 */, int32 TryCount /* = 10 */)
+{
+	if (!WFCModel)
 	{
-		MinEntropyIndex = RemainingTiles[0];
+		UE_LOG(LogTemp, Error, TEXT("Invalid WFC Model"));
+		return;
 	}
-
-	// Rand Selection of Weighted Options using Cumulative Density
-	TArray<float> CumulativeDensity;
-	CumulativeDensity.Reserve(Tiles[MinEntropyIndex].RemainingOptions.Num());
-	float CumulativeWeight = 0;
-	for (FWaveFunctionCollapseOption& Option : Tiles[MinEntropyIndex].RemainingOptions)
+	if (!CompiledModel->IsValid())
 	{
-		CumulativeWeight += WFCModel->Constraints.Find(Option)->Weight;
-		CumulativeDensity.Add(CumulativeWeight);
+		CompileModel();
 	}
-	
-	int32 SelectedOptionIndex = 0;
-	float RandomDensity = RandomStream.FRandRange(0.0f, CumulativeDensity.Last());
-	for (int32 Index = 0; Index < CumulativeDensity.Num(); Index++)
+	if (SolutionCacheCapacity <= 0 || RandomSeedPoolSize <= 0)
 	{
-		if (CumulativeDensity[Index] > RandomDensity)
-		{
-			SelectedOptionIndex = Index;
-			break;
-		}
+		UE_LOG(LogTemp, Error, TEXT("Solution cache pre-population needs SolutionCacheCapacity and RandomSeedPoolSize"));
+		return;
 	}
 
-	// Make Selection
-	Tiles[MinEntropyIndex] = FWaveFunctionCollapseTile(Tiles[MinEntropyIndex].RemainingOptions[SelectedOptionIndex], TNumericLimits<float>::Max());
+	// Boundaries are solved without districts, in a context of their own filling the solution cache of this world
+	SyncSolutionCache();
+	FWFCSolverContext CacheSolver;
+	CacheSolver.CopySettings(Solver);
+	CacheSolver.SolutionCache = &SolutionCache;
 
-	if (SelectedMinEntropyIndex != LastSameMinEntropyIndex)
-	{
-		RemainingTiles.Swap(SelectedMinEntropyIndex, LastSameMinEntropyIndex);
-	}
-	RemainingTiles.RemoveAtSwap(LastSameMinEntropyIndex);
+	const double StartTime = FPlatformTime::Seconds();
+	const FIntVector Stride = CacheSolver.GetChunkStride();
+	const FIntVector WindowOffset = CacheSolver.GetChunkWindowOffset();
+	const FIntVector& Resolution = CacheSolver.Resolution;
 
-	if (!RemainingTiles.IsEmpty())
+	TArray<TMap<FIntVector, FWaveFunctionCollapseOption>> Boundaries;
+	TSet<uint32> BoundaryHashes;
+	Boundaries.AddDefaulted();
+
+	int32 NumSolves = 0;
+	int32 NumFailures = 0;
+	for (int32 BoundaryIndex = 0; BoundaryIndex < Boundaries.Num() && NumSolves < NumVariants; BoundaryIndex++)
 	{
-		// if MinEntropy has changed after removal, find new MinEntropy and swap to front of array
-		if (Tiles[RemainingTiles[0]].ShannonEntropy != MinEntropy)
+		for (int32 PoolSeed = 1; PoolSeed <= RandomSeedPoolSize && NumSolves < NumVariants; PoolSeed++)
 		{
-			int32 SwapToIndex = 0;
-			for (int32 index = 0; index < RemainingTiles.Num(); index++)
+			CacheSolver.StarterOptions = Boundaries[BoundaryIndex];
+			int32 Seed = PoolSeed;
+			TArray<FWaveFunctionCollapseTile>& Tiles = CacheSolver.SolveArena.Tiles;
+			NumSolves++;
+			if (!CacheSolver.SolveTiles(TryCount, Seed, Tiles))
 			{
-				if (index == 0)
-				{
-					MinEntropy = Tiles[RemainingTiles[index]].ShannonEntropy;
-				}
-				else
+				NumFailures++;
+				continue;
+			}
+			if (Boundaries.Num() >= NumVariants)
+			{
+				continue;
+			}
+
+			// The windows one chunk stride away see the inner cells of this window as their boundary
+			const FIntVector Shifts[] = { FIntVector(Stride.X, 0, 0), FIntVector(-Stride.X, 0, 0), FIntVector(0, Stride.Y, 0), FIntVector(0, -Stride.Y, 0) };
+			for (const FIntVector& Shift : Shifts)
+			{
+				TMap<FIntVector, FWaveFunctionCollapseOption> Boundary;
+				for (int32 index = 0; index < Tiles.Num(); index++)
 				{
-					if (Tiles[RemainingTiles[index]].ShannonEntropy < MinEntropy)
-					{
-						SwapToIndex = 0;
-						MinEntropy = Tiles[RemainingTiles[index]].ShannonEntropy;
-						RemainingTiles.Swap(SwapToIndex, index);
-					}
-					else if (Tiles[RemainingTiles[index]].ShannonEntropy == MinEntropy)
+					const FIntVector SourcePosition = UWaveFunctionCollapseBPLibrary::IndexAsPosition(index, Resolution);
+					const FIntVector InnerPosition = SourcePosition - WindowOffset;
+					const FIntVector BoundaryPosition = SourcePosition - Shift;
+					if (InnerPosition.X < 0 || InnerPosition.Y < 0 || InnerPosition.X >= Stride.X || InnerPosition.Y >= Stride.Y
+						|| BoundaryPosition.X < 0 || BoundaryPosition.Y < 0 || BoundaryPosition.X >= Resolution.X || BoundaryPosition.Y >= Resolution.Y
+						|| Tiles[index].RemainingOptions.Num() != 1)
 					{
-						SwapToIndex += 1;
-						RemainingTiles.Swap(SwapToIndex, index);
+						continue;
 					}
+					Boundary.Add(BoundaryPosition, Tiles[index].RemainingOptions[0]);
+				}
+
+				CacheSolver.StarterOptions = Boundary;
+				FWFCBoundarySignature BoundarySignature;
+				if (CacheSolver.MakeBoundarySignature(0, 0, BoundarySignature) && !BoundaryHashes.Contains(BoundarySignature.Hash))
+				{
+					BoundaryHashes.Add(BoundarySignature.Hash);
+					Boundaries.Add(MoveTemp(Boundary));
 				}
 			}
 		}
-
-		// Add Adjacent Tile Indices to Queue
-		AddAdjacentIndicesToQueue(MinEntropyIndex, RemainingTiles, ObservationQueue);
-
-		// Continue To Propagation
-		return true;
-	}
-	else
-	{
-		// Do Not Continue to Propagation
-		return false;
 	}
+	UE_LOG(LogTemp, Display, TEXT("Pre-populated solution cache: %d solves of %d boundaries, %d failed, in %.2f s"),
+		NumSolves, Boundaries.Num(), NumFailures, FPlatformTime::Seconds() - StartTime);
+	SolutionCache.LogStats();
+	SaveSolutionCache();
 }
 
-void UWFCSubsystem::AddAdjacentIndicesToQueue(int32 CenterIndex, const TArray<int32>& RemainingTiles, TMap<int32,FWaveFunctionCollapseQueueElement>& OutQueue)
+void UWFCSubsystem::BenchmarkObservationHeuristics(int32 NumSolves /* = 100 */)
 {
-	FIntVector Position = UWaveFunctionCollapseBPLibrary::IndexAsPosition(CenterIndex, Resolution);
-	if (Position.X + 1 < Resolution.X && RemainingTiles.Contains(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(1, 0, 0), Resolution)))
-	{ 
-		OutQueue.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(1, 0, 0), Resolution),
-			FWaveFunctionCollapseQueueElement(CenterIndex, EWaveFunctionCollapseAdjacency::Front));
-	}
-	if (Position.X - 1 >= 0 && RemainingTiles.Contains(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(-1, 0, 0), Resolution)))
-	{ 
-		OutQueue.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(-1, 0, 0), Resolution),
-			FWaveFunctionCollapseQueueElement(CenterIndex, EWaveFunctionCollapseAdjacency::Back));
-	}
-	if (Position.Y + 1 < Resolution.Y && RemainingTiles.Contains(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(0, 1, 0), Resolution)))
-	{ 
-		OutQueue.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(0, 1, 0), Resolution),
-			FWaveFunctionCollapseQueueElement(CenterIndex, EWaveFunctionCollapseAdjacency::Right));
+	if (!WFCModel)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid WFC Model"));
+		return;
 	}
-	if (Position.Y - 1 >= 0 && RemainingTiles.Contains(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(0, -1, 0), Resolution)))
-	{ 
-		OutQueue.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(0, -1, 0), Resolution),
-			FWaveFunctionCollapseQueueElement(CenterIndex, EWaveFunctionCollapseAdjacency::Left));
+	if (!CompiledModel->IsValid())
+	{
+		CompileModel();
 	}
-	if (Position.Z + 1 < Resolution.Z && RemainingTiles.Contains(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(0, 0, 1), Resolution)))
-	{ 
-		OutQueue.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(0, 0, 1), Resolution),
-			FWaveFunctionCollapseQueueElement(CenterIndex, EWaveFunctionCollapseAdjacency::Up));
+
+	// Every heuristic solves the same empty window, without starter tiles or districts, in a context of its own
+	FWFCSolverContext BenchmarkSolver;
+	BenchmarkSolver.CopySettings(Solver);
+	FWFCSolveArena& SolveArena = BenchmarkSolver.SolveArena;
+
+	TArray<FWaveFunctionCollapseTile> InitialTiles;
+	TArray<int32> InitialRemainingTiles;
+	BenchmarkSolver.InitializeWFC(InitialTiles, InitialRemainingTiles);
+	if (InitialTiles.IsEmpty())
+	{
+		return;
 	}
-	if (Position.Z - 1 >= 0 && RemainingTiles.Contains(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(0, 0, -1), Resolution)))
-	{ 
-		OutQueue.Add(UWaveFunctionCollapseBPLibrary::PositionAsIndex(Position + FIntVector(0, 0, -1), Resolution),
-			FWaveFunctionCollapseQueueElement(CenterIndex, EWaveFunctionCollapseAdjacency::Down));
+	const TArray<TArray<uint16>> InitialTileOptionIds = SolveArena.TileOptionIds;
+
+	UE_LOG(LogTemp, Display, TEXT("Benchmarking observation heuristics - Model: %s, Resolution %dx%dx%d, %d solves each"),
+		*WFCModel->GetFName().ToString(), BenchmarkSolver.Resolution.X, BenchmarkSolver.Resolution.Y, BenchmarkSolver.Resolution.Z, NumSolves);
+	const EWFCObservationHeuristic Heuristics[] = {
+		EWFCObservationHeuristic::MinEntropy,
+		EWFCObservationHeuristic::MinRemainingValues,
+		EWFCObservationHeuristic::WeightedEntropyNoise,
+		EWFCObservationHeuristic::Scanline };
+	for (const EWFCObservationHeuristic Heuristic : Heuristics)
+	{
+		BenchmarkSolver.ObservationHeuristic = Heuristic;
+		int32 NumFailures = 0;
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Seed = 1; Seed <= NumSolves; Seed++)
+		{
+			FWFCSolveArena::CopyTiles(InitialTiles, SolveArena.Tiles);
+			FWFCSolveArena::CopyTileOptionIds(InitialTileOptionIds, SolveArena.TileOptionIds);
+			SolveArena.RemainingTiles = InitialRemainingTiles;
+			SolveArena.ObservationQueue.Reset();
+			if (!BenchmarkSolver.ObservationPropagation(SolveArena.Tiles, SolveArena.RemainingTiles, SolveArena.ObservationQueue, Seed))
+			{
+				NumFailures++;
+			}
+		}
+		const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		UE_LOG(LogTemp, Display, TEXT("  %-20s %10.2f ms total, %8.3f ms per solve, %5.1f%% failed"),
+			*StaticEnum<EWFCObservationHeuristic>()->GetNameStringByValue(static_cast<int64>(Heuristic)),
+			ElapsedMs, ElapsedMs / FMath::Max(NumSolves, 1), 100.0 * NumFailures / FMath::Max(NumSolves, 1));
 	}
 }
 
-bool UWFCSubsystem::Propagate(TArray<FWaveFunctionCollapseTile>& Tiles, 
-	TArray<int32>& RemainingTiles, 
-	TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue, 
-	int32& PropagationCount)
+bool UWFCSubsystem::RunSolverDifferential(int32 NumModels /* = 20 */, int32 NumSeeds /* = 50 */, int32 HarnessSeed /* = 1 */)
 {
-	TMap<int32, FWaveFunctionCollapseQueueElement> PropagationQueue;
+	// Solves use the random models and windows in a context of their own, without the starter tiles, districts and solution cache of the city
+	FWFCSolverContext PathSolver;
+	PathSolver.bUseEmptyBorder = Solver.bUseEmptyBorder;
+	PathSolver.ObservationNoise = Solver.ObservationNoise;
+
+	// Only the solve of the arena path is looked up again, the dynamic kernel path solves without the cache
+	FWFCSolutionCache PathSolutionCache;
+	PathSolutionCache.SetCapacity(1);
+
+	UE_LOG(LogTemp, Display, TEXT("Solver differential - %d models, %d seeds per configuration, harness seed %d"), NumModels, NumSeeds, HarnessSeed);
+	const EWFCObservationHeuristic Heuristics[] = {
+		EWFCObservationHeuristic::MinEntropy,
+		EWFCObservationHeuristic::MinRemainingValues,
+		EWFCObservationHeuristic::WeightedEntropyNoise,
+		EWFCObservationHeuristic::Scanline };
+
+	// Solver paths compared with the reference: a solve through the solve arena, then the same solve served by the solution cache,
+	// then solved again with the dynamic width kernel, which must match the fixed-width kernel of the arena solve cell for cell
+	const TCHAR* PathNames[] = { TEXT("arena"), TEXT("solution cache"), TEXT("dynamic kernel") };
+	const int32 NumPaths = UE_ARRAY_COUNT(PathNames);
 
-	while (!ObservationQueue.IsEmpty())
+	const double StartTime = FPlatformTime::Seconds();
+	FRandomStream HarnessStream(HarnessSeed);
+	int32 NumConfigurations = 0;
+	int32 NumFailingConfigurations = 0;
+	int32 NumComparedSolves = 0;
+	for (int32 ModelIndex = 0; ModelIndex < NumModels; ModelIndex++)
 	{
-		for (TPair<int32, FWaveFunctionCollapseQueueElement>& ObservationAdjacenctElement : ObservationQueue)
+		// Everything about a configuration derives from its model seed, so the seed alone reproduces it
+		const int32 ModelSeed = HarnessStream.RandRange(1, TNumericLimits<int32>::Max());
+		FRandomStream ConfigurationStream(ModelSeed);
+		UWaveFunctionCollapseModel* RandomModel = FWFCSolverDifferential::MakeRandomModel(ModelSeed);
+		PathSolver.CompiledModel = FWFCCompiledModel::CompileShared(RandomModel);
+		const FWFCCompiledModel& RandomCompiledModel = *PathSolver.CompiledModel;
+		if (!RandomCompiledModel.IsValid())
 		{
-			// Make sure the tile to check is still a valid remaining tile
-			if (!RemainingTiles.Contains(ObservationAdjacenctElement.Key))
-			{
-				continue;
-			}
-			
-			TArray<FWaveFunctionCollapseOption>& ObservationRemainingOptions = Tiles[ObservationAdjacenctElement.Key].RemainingOptions;
+			UE_LOG(LogTemp, Error, TEXT("  Could not compile the random model of seed %d"), ModelSeed);
+			NumFailingConfigurations++;
+			continue;
+		}
+		// Windows of wide models stay small, the reference propagation is quadratic in the options
+		const int32 MaxResolution = RandomCompiledModel.NumMaskWords > 1 ? 5 : 10;
+		const FIntVector Resolution(ConfigurationStream.RandRange(2, MaxResolution), ConfigurationStream.RandRange(2, MaxResolution), ConfigurationStream.RandRange(0, 3) == 0 ? 2 : 1);
+		PathSolver.Resolution = Resolution;
+		const int32 TryCount = ConfigurationStream.RandRange(1, 3);
+		TMap<FIntVector, FWaveFunctionCollapseOption>& StarterOptions = PathSolver.StarterOptions;
+		StarterOptions.Reset();
+		const int32 NumStarters = ConfigurationStream.RandRange(0, 2);
+		for (int32 StarterIndex = 0; StarterIndex < NumStarters; StarterIndex++)
+		{
+			const FIntVector StarterCell(ConfigurationStream.RandRange(0, Resolution.X - 1), ConfigurationStream.RandRange(0, Resolution.Y - 1), ConfigurationStream.RandRange(0, Resolution.Z - 1));
+			StarterOptions.Add(StarterCell, *RandomCompiledModel.GetOption(ConfigurationStream.RandRange(0, RandomCompiledModel.NumOptions() - 1)));
+		}
 
-			// Get check against options
-			TArray<FWaveFunctionCollapseOption> OptionsToCheckAgainst;
-			OptionsToCheckAgainst.Reserve(WFCModel->Constraints.Num());
-			for (FWaveFunctionCollapseOption& CenterOption : Tiles[ObservationAdjacenctElement.Value.CenterObjectIndex].RemainingOptions)
-			{
-				for (FWaveFunctionCollapseOption& Option : WFCModel->Constraints.FindRef(CenterOption).AdjacencyToOptionsMap.FindRef(ObservationAdjacenctElement.Value.Adjacency).Options)
-				{
-					OptionsToCheckAgainst.AddUnique(Option);
-				}
-			}
-				
-			// Accumulate New Remaining Options
-			bool bAddToPropagationQueue = false;
-			TArray<FWaveFunctionCollapseOption> TmpRemainingOptionsAccumulation;
-			TmpRemainingOptionsAccumulation.Reserve(ObservationRemainingOptions.Num());
-			for (FWaveFunctionCollapseOption& ObservationRemainingOption : ObservationRemainingOptions)
+		for (const EWFCObservationHeuristic Heuristic : Heuristics)
+		{
+			PathSolver.ObservationHeuristic = Heuristic;
+			NumConfigurations++;
+
+			// Seeds run in increasing order, so the first failure is the minimal failing seed of the configuration
+			for (int32 Seed = 1; Seed <= NumSeeds; Seed++)
 			{
-				if (OptionsToCheckAgainst.Contains(ObservationRemainingOption))
-				{
-					TmpRemainingOptionsAccumulation.AddUnique(ObservationRemainingOption);
-				}
-				else
+				FString Failure;
+				int32 ReferenceSeed = Seed;
+				TArray<FWaveFunctionCollapseTile> ReferenceTiles;
+				const bool bReferenceSolved = FWFCSolverDifferential::SolveReference(RandomModel, PathSolver, TryCount, ReferenceSeed, ReferenceTiles);
+				if (bReferenceSolved && !FWFCSolverDifferential::CheckTiling(RandomModel, ReferenceTiles, Resolution, StarterOptions, Failure))
 				{
-					bAddToPropagationQueue = true;
+					Failure = TEXT("reference: ") + Failure;
 				}
-			}
-				
-			// If Remaining Options have changed
-			if (bAddToPropagationQueue)
-			{
-				if (!TmpRemainingOptionsAccumulation.IsEmpty())
+
+				TArray<FWaveFunctionCollapseTile> KernelTiles;
+				for (int32 PathIndex = 0; PathIndex < NumPaths && Failure.IsEmpty(); PathIndex++)
 				{
-					AddAdjacentIndicesToQueue(ObservationAdjacenctElement.Key, RemainingTiles, PropagationQueue);
-
-					// Update Tile with new options
-					float MinEntropy = Tiles[RemainingTiles[0]].ShannonEntropy;
-					float NewEntropy = UWaveFunctionCollapseBPLibrary::CalculateShannonEntropy(TmpRemainingOptionsAccumulation, WFCModel);
-					int32 CurrentRemainingTileIndex;
-						
-					// If NewEntropy is <= MinEntropy, add to front of Remaining Tiles
-					if (NewEntropy < MinEntropy)
+					const bool bDynamicKernelPath = PathIndex == 2;
+					PathSolver.bForceDynamicKernel = bDynamicKernelPath;
+					PathSolver.SolutionCache = bDynamicKernelPath ? nullptr : &PathSolutionCache;
+
+					int32 PathSeed = Seed;
+					TArray<FWaveFunctionCollapseTile>& Tiles = PathSolver.SolveArena.Tiles;
+					const bool bSolved = PathSolver.SolveTiles(TryCount, PathSeed, Tiles);
+					FString TilingError;
+					if (bSolved != bReferenceSolved || PathSeed != ReferenceSeed)
 					{
-						MinEntropy = NewEntropy;
-						CurrentRemainingTileIndex = RemainingTiles.Find(ObservationAdjacenctElement.Key);
-						if (CurrentRemainingTileIndex != 0)
-						{
-							RemainingTiles.Swap(0, CurrentRemainingTileIndex);
-						}
+						Failure = FString::Printf(TEXT("%s: %s with seed %d, reference %s with seed %d"), PathNames[PathIndex],
+							bSolved ? TEXT("solved") : TEXT("failed"), PathSeed, bReferenceSolved ? TEXT("solved") : TEXT("failed"), ReferenceSeed);
+					}
+					else if (bSolved && !FWFCSolverDifferential::CheckTiling(RandomModel, Tiles, Resolution, StarterOptions, TilingError))
+					{
+						Failure = FString::Printf(TEXT("%s: %s"), PathNames[PathIndex], *TilingError);
 					}
-					else if (NewEntropy == MinEntropy)
+					else if (bSolved)
 					{
-						CurrentRemainingTileIndex = RemainingTiles.Find(ObservationAdjacenctElement.Key);
-						for (int32 Index = 1; Index < RemainingTiles.Num(); Index++)
+						// The dynamic kernel is held to the specialized kernel, which is held to the reference
+						const TArray<FWaveFunctionCollapseTile>& ExpectedTiles = bDynamicKernelPath ? KernelTiles : ReferenceTiles;
+						for (int32 index = 0; index < Tiles.Num(); index++)
 						{
-							if (MinEntropy != Tiles[RemainingTiles[Index]].ShannonEntropy)
+							if (Tiles[index].RemainingOptions != ExpectedTiles[index].RemainingOptions)
 							{
-								if (CurrentRemainingTileIndex != Index)
-								{
-									RemainingTiles.Swap(Index, CurrentRemainingTileIndex);
-								}
+								Failure = FString::Printf(TEXT("%s: cell %s differs from %s"), PathNames[PathIndex],
+									*UWaveFunctionCollapseBPLibrary::IndexAsPosition(index, Resolution).ToString(),
+									bDynamicKernelPath ? *FString::Printf(TEXT("the %d-word kernel"), RandomCompiledModel.NumMaskWords) : TEXT("the reference"));
 								break;
 							}
 						}
+						if (PathIndex == 0)
+						{
+							KernelTiles = Tiles;
+						}
 					}
-						
-					Tiles[ObservationAdjacenctElement.Key] = FWaveFunctionCollapseTile(TmpRemainingOptionsAccumulation, NewEntropy);
 				}
-				else
+				NumComparedSolves++;
+
+				if (!Failure.IsEmpty())
 				{
-					// Encountered Contradiction
-					UE_LOG(LogTemp, Error, TEXT("Encountered Contradiction on Index %d"), ObservationAdjacenctElement.Key);
-					return false;
+					UE_LOG(LogTemp, Error, TEXT("  Minimal failing seed %d - model seed %d, resolution %dx%dx%d, %d options, %d starters, try count %d, %s - %s"),
+						Seed, ModelSeed, Resolution.X, Resolution.Y, Resolution.Z, RandomCompiledModel.NumOptions(), StarterOptions.Num(), TryCount,
+						*StaticEnum<EWFCObservationHeuristic>()->GetNameStringByValue(static_cast<int64>(Heuristic)), *Failure);
+					NumFailingConfigurations++;
+					break;
 				}
 			}
 		}
-
-		ObservationQueue = PropagationQueue;
-		if (!PropagationQueue.IsEmpty())
-		{
-			PropagationCount += 1;
-			PropagationQueue.Reset();
-		}
 	}
 
-	return true;
+	UE_LOG(LogTemp, Display, TEXT("Solver differential: %d of %d configurations failed, %d seeds compared over %d paths, in %.2f s"),
+		NumFailingConfigurations, NumConfigurations, NumComparedSolves, NumPaths, FPlatformTime::Seconds() - StartTime);
+	return NumFailingConfigurations == 0;
 }
 
-bool UWFCSubsystem::ObservationPropagation(TArray<FWaveFunctionCollapseTile>& Tiles, 
-	TArray<int32>& RemainingTiles,
-	TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue,
-	int32 RandomSeed)
+void UWFCSubsystem::CompileDistrictModel()
 {
-	int32 PropagationCount = 1;
-	int32 MutatedRandomSeed = RandomSeed;
-	
-	while (Observe(Tiles, RemainingTiles, ObservationQueue, MutatedRandomSeed))
+	Solver.SolveArena.ResetCachedTiles();
+	Solver.DistrictMasks = MakeShared<TArray<FWFCDistrictMask>>();
+	DistrictChunks.Empty();
+	DistrictCompiledModel = FWFCCompiledModel::CompileShared(DistrictModel);
+
+	// District chunks are solved by their own context, never constrained by districts and kept out of the solution cache of the city
+	DistrictSolver.CopySettings(Solver);
+	DistrictSolver.CompiledModel = DistrictCompiledModel;
+	DistrictSolver.Resolution = DistrictResolution;
+	DistrictSolver.SolveArena.ResetCachedTiles();
+	if (!DistrictModel)
+	{
+		return;
+	}
+
+	FWaveFunctionCollapseTile InitialTile;
+	if (!DistrictCompiledModel->IsValid() || !Solver.BuildInitialTile(InitialTile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not compile District Model %s"), *DistrictModel->GetName());
+		return;
+	}
+
+	TArray<FWFCDistrictMask> DistrictMasks;
+	DistrictMasks.SetNum(DistrictCompiledModel->NumOptions());
+	for (int32 DistrictOptionId = 0; DistrictOptionId < DistrictMasks.Num(); DistrictOptionId++)
 	{
-		if (!Propagate(Tiles, RemainingTiles, ObservationQueue, PropagationCount))
+		FWFCDistrictMask& DistrictMask = DistrictMasks[DistrictOptionId];
+		const FWFCDistrictTileSet* TileSet = DistrictTileSets.Find(DistrictCompiledModel->Options[DistrictOptionId].BaseObject);
+		DistrictMask.AllowedOptions.Init(false, CompiledModel->NumOptions());
+		for (const FWaveFunctionCollapseOption& Option : InitialTile.RemainingOptions)
 		{
-			return false;
+			if (!TileSet || TileSet->AllowedObjects.Contains(Option.BaseObject))
+			{
+				const uint16 OptionId = CompiledModel->FindOptionId(Option);
+				DistrictMask.AllowedOptions[OptionId] = true;
+				DistrictMask.InitialTile.RemainingOptions.Add(Option);
+				DistrictMask.InitialOptionIds.Add(OptionId);
+			}
 		}
 
-		// Mutate Seed
-		MutatedRandomSeed--;
+		if (DistrictMask.InitialTile.RemainingOptions.IsEmpty())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("District option allows no tile and is ignored: %s"), *DistrictCompiledModel->Options[DistrictOptionId].BaseObject.ToString());
+			continue;
+		}
+		DistrictMask.InitialTile.ShannonEntropy = CompiledModel->CalculateShannonEntropy(DistrictMask.InitialOptionIds);
 	}
+	UE_LOG(LogTemp, Display, TEXT("Compiled District Model %s: %d district options"), *DistrictModel->GetName(), DistrictMasks.Num());
+	Solver.DistrictMasks = MakeShared<TArray<FWFCDistrictMask>>(MoveTemp(DistrictMasks));
+}
 
-	// Check if all tiles in the solve are non-spawnable
-	return !AreAllTilesNonSpawnable(Tiles);
+FIntVector UWFCSubsystem::GetDistrictCell(FIntVector AbsoluteCell) const
+{
+	auto FloorDivide = [](int32 Value, int32 Divisor) { return Value >= 0 ? Value / Divisor : (Value - Divisor + 1) / Divisor; };
+	return FIntVector(
+		FloorDivide(AbsoluteCell.X, FMath::Max(DistrictCellSize.X, 1)),
+		FloorDivide(AbsoluteCell.Y, FMath::Max(DistrictCellSize.Y, 1)),
+		FloorDivide(AbsoluteCell.Z, FMath::Max(DistrictCellSize.Z, 1)));
 }
 
-UActorComponent* UWFCSubsystem::AddNamedInstanceComponent(AActor* Actor, TSubclassOf<UActorComponent> ComponentClass, FName ComponentName)
+int32 UWFCSubsystem::GetDistrictOptionId(FIntVector DistrictCell)
 {
-	Actor->Modify();
-	// Assign Unique Name
-	int32 Counter = 1;
-	FName ComponentInstanceName = ComponentName;
-	while (!FComponentEditorUtils::IsComponentNameAvailable(ComponentInstanceName.ToString(), Actor))
+	if (!DistrictModel || Solver.DistrictMasks->IsEmpty())
 	{
-		ComponentInstanceName = FName(*FString::Printf(TEXT("%s_%d"), *ComponentName.ToString(), Counter++));
+		return FWFCCompiledModel::InvalidOptionId;
 	}
-	UActorComponent* InstanceComponent = NewObject<UActorComponent>(Actor, ComponentClass, ComponentInstanceName, RF_Transactional);
-	if (InstanceComponent)
+
+	// The district grid is a lattice of deterministic chunks of the district model, solved by DistrictSolver
+	const FIntVector ChunkCoord = GetLatticeChunkCoord(DistrictCell, DistrictSolver.Resolution);
+	const FIntVector OriginCell = GetLatticeOriginCell(ChunkCoord, DistrictSolver.Resolution);
+	FWFCChunk* DistrictChunk = DistrictChunks.Find(OriginCell);
+	if (!DistrictChunk)
 	{
-		Actor->AddInstanceComponent(InstanceComponent);
-		Actor->FinishAddComponent(InstanceComponent, false, FTransform::Identity);
-		Actor->RerunConstructionScripts();
+		FWFCChunk Chunk = MakeDeterministicChunk(DistrictSolver, ChunkCoord, GetLatticeChunkSeed(ChunkCoord, WorldSeed));
+
+		// A failed district chunk leaves its fine cells unconstrained
+		if (!SolveDeterministicChunk(GetDistrictLattice(), ChunkCoord, DeterministicTryCount, Chunk.Seed, Chunk.OptionIds))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not solve district chunk %s, its districts are unconstrained"), *ChunkCoord.ToString());
+			Chunk.OptionIds.Init(FWFCCompiledModel::InvalidOptionId, Chunk.Size.X * Chunk.Size.Y * Chunk.Size.Z);
+		}
+		DistrictChunk = &DistrictChunks.Add(OriginCell, MoveTemp(Chunk));
 	}
-	return InstanceComponent;
+	return DistrictChunk->GetOptionId(DistrictCell);
 }
 
-AActor* UWFCSubsystem::SpawnActorFromTiles(const TArray<FWaveFunctionCollapseTile>& Tiles)
+int32 UWFCSubsystem::GenerateDistrict(FIntVector DistrictCell)
 {
-	// Spawn Actor
-	AActor* SpawnedActor = GetWorld()->SpawnActor<AActor>(OriginLocation, Orientation, FActorSpawnParameters{});
-	FActorLabelUtilities::SetActorLabelUnique(SpawnedActor, WFCModel->GetFName().ToString());
+	if (!bDeterministicGeneration)
+	{
+		UE_LOG(LogTemp, Error, TEXT("GenerateDistrict requires bDeterministicGeneration"));
+		return 0;
+	}
+	if (!WFCModel)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid WFC Model"));
+		return 0;
+	}
+	if (!CompiledModel->IsValid())
+	{
+		CompileModel();
+	}
+	SyncSolutionCache();
 
-	// Create Components
-	TMap<FSoftObjectPath, UInstancedStaticMeshComponent*> BaseObjectToISM;
-	for (int32 index = 0; index < Tiles.Num(); index++)
+	// Chunks of the district not generated yet, primaries and secondaries
+	const FIntVector MinCell(DistrictCell.X * DistrictCellSize.X, DistrictCell.Y * DistrictCellSize.Y, DistrictCell.Z * DistrictCellSize.Z);
+	const FIntVector MinChunkCoord = GetChunkCoord(MinCell);
+	const FIntVector MaxChunkCoord = GetChunkCoord(MinCell + DistrictCellSize - FIntVector(1));
+	TArray<FIntVector> PrimaryCoords;
+	TArray<FIntVector> SecondaryCoords;
+	for (int32 Z = MinChunkCoord.Z; Z <= MaxChunkCoord.Z; Z++)
 	{
-		if (Tiles[index].RemainingOptions.Num() != 1)
+		for (int32 Y = MinChunkCoord.Y; Y <= MaxChunkCoord.Y; Y++)
 		{
-			continue;
-		}
+			for (int32 X = MinChunkCoord.X; X <= MaxChunkCoord.X; X++)
+			{
+				const FIntVector ChunkCoord(X, Y, Z);
+				if (!Chunks.Contains(GetChunkOriginCell(ChunkCoord)))
+				{
+					(IsPrimaryChunk(ChunkCoord) ? PrimaryCoords : SecondaryCoords).Add(ChunkCoord);
+				}
+			}
+		}
+	}
+	const int32 NumDistrictPrimaries = PrimaryCoords.Num();
 
-		// check for empty or void options
-		FSoftObjectPath BaseObject = Tiles[index].RemainingOptions[0].BaseObject;
-		if (BaseObject == FWaveFunctionCollapseOption::EmptyOption.BaseObject
-			|| BaseObject == FWaveFunctionCollapseOption::VoidOption.BaseObject)
+	// The primary neighbors of the secondaries come from their records, the others are solved along with the primaries of the district
+	TMap<FIntVector, FWFCChunk> PrimaryChunks;
+	static const FIntVector NeighborOffsets[] = { FIntVector(-1, 0, 0), FIntVector(1, 0, 0), FIntVector(0, -1, 0), FIntVector(0, 1, 0) };
+	for (const FIntVector& SecondaryCoord : SecondaryCoords)
+	{
+		for (const FIntVector& NeighborOffset : NeighborOffsets)
 		{
-			continue;
+			const FIntVector NeighborCoord = SecondaryCoord + NeighborOffset;
+			if (PrimaryChunks.Contains(NeighborCoord) || PrimaryCoords.Contains(NeighborCoord))
+			{
+				continue;
+			}
+			const FWFCChunk* RecordedChunk = Chunks.Find(GetChunkOriginCell(NeighborCoord));
+			if (!RecordedChunk || !RecordedChunk->bDeterministic)
+			{
+				PrimaryCoords.Add(NeighborCoord);
+				continue;
+			}
+			FWFCChunk PrimaryNeighbor;
+			if (GetPrimaryChunkTiles(GetCityLattice(), NeighborCoord, PrimaryNeighbor))
+			{
+				PrimaryChunks.Add(NeighborCoord, MoveTemp(PrimaryNeighbor));
+			}
 		}
+	}
+
+	// One solver context per task, with the settings of Solver
+	TArray<FWFCSolverContext> ChunkSolvers;
+	ChunkSolvers.SetNum(FMath::Clamp(FMath::Max(PrimaryCoords.Num(), SecondaryCoords.Num()), 1, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1));
+	for (FWFCSolverContext& ChunkSolver : ChunkSolvers)
+	{
+		ChunkSolver.CopySettings(Solver);
+	}
+
+	TArray<FWFCChunk> SolvedPrimaries;
+	SolveChunks(PrimaryCoords, ChunkSolvers, PrimaryChunks, SolvedPrimaries);
+	for (int32 ChunkIndex = 0; ChunkIndex < PrimaryCoords.Num(); ChunkIndex++)
+	{
+		if (!SolvedPrimaries[ChunkIndex].OptionIds.IsEmpty())
+		{
+			PrimaryChunks.Add(PrimaryCoords[ChunkIndex], SolvedPrimaries[ChunkIndex]);
+		}
+	}
+	TArray<FWFCChunk> SolvedSecondaries;
+	SolveChunks(SecondaryCoords, ChunkSolvers, PrimaryChunks, SolvedSecondaries);
 
-		// Check the SpawnExclusion array
-		if (WFCModel->SpawnExclusion.Contains(BaseObject))
+	// Only the chunks of the district are spawned, primaries first
+	SolvedPrimaries.SetNum(NumDistrictPrimaries);
+	SolvedPrimaries.Append(MoveTemp(SolvedSecondaries));
+	int32 NumGeneratedChunks = 0;
+	for (FWFCChunk& Chunk : SolvedPrimaries)
+	{
+		if (Chunk.OptionIds.IsEmpty())
 		{
+			UE_LOG(LogTemp, Error, TEXT("Could not solve chunk %s of district %s after %d tries"), *GetChunkCoord(Chunk.MinCell).ToString(), *DistrictCell.ToString(), DeterministicTryCount);
 			continue;
 		}
+		const FIntVector OriginCell = Chunk.OriginCell;
+		if (SpawnChunkRecord(MoveTemp(Chunk)))
+		{
+			RecordGenerationEvent(*Chunks.Find(OriginCell), TArray<uint32>());
+			NumGeneratedChunks++;
+		}
+	}
+	return NumGeneratedChunks;
+}
+
+void UWFCSubsystem::GatherWindowDistrictIds(const FIntVector& WindowMinCell, TArray<uint16>& OutWindowDistrictIds)
+{
+	// District chunks are solved by DistrictSolver, so gathering never touches the solve in preparation
+	OutWindowDistrictIds.Reset();
+	if (DistrictModel && !Solver.DistrictMasks->IsEmpty())
+	{
+		OutWindowDistrictIds.SetNumUninitialized(Solver.Resolution.X * Solver.Resolution.Y * Solver.Resolution.Z);
+		for (int32 index = 0; index < OutWindowDistrictIds.Num(); index++)
+		{
+			const FIntVector absoluteGridPosition = WindowMinCell + UWaveFunctionCollapseBPLibrary::IndexAsPosition(index, Solver.Resolution);
+			OutWindowDistrictIds[index] = static_cast<uint16>(GetDistrictOptionId(GetDistrictCell(absoluteGridPosition)));
+		}
+	}
+}
+
+bool UWFCSubsystem::LoadSolutionCache()
+{
+	if (SolutionCacheCapacity <= 0 || !CompiledModel->IsValid())
+	{
+		return false;
+	}
+	SyncSolutionCache();
+	return SolutionCache.Load(FWFCSolutionCache::GetCacheFilename(CompiledModel->ModelHash), CompiledModel->ModelHash);
+}
+
+void UWFCSubsystem::SyncSolutionCache()
+{
+	SolutionCache.SetCapacity(SolutionCacheCapacity);
+	Solver.SolutionCache = &SolutionCache;
+}
+
+bool UWFCSubsystem::SaveSolutionCache() const
+{
+	if (!CompiledModel->IsValid())
+	{
+		return false;
+	}
+	return SolutionCache.Save(FWFCSolutionCache::GetCacheFilename(CompiledModel->ModelHash));
+}
+
+FIntVector UWFCSubsystem::GetChunkCoord(FIntVector AbsoluteCell) const
+{
+	return GetLatticeChunkCoord(AbsoluteCell, Solver.Resolution);
+}
+
+FIntVector UWFCSubsystem::GetChunkOriginCell(const FIntVector& ChunkCoord) const
+{
+	return GetLatticeOriginCell(ChunkCoord, Solver.Resolution);
+}
+
+int32 UWFCSubsystem::GetChunkSeed(FIntVector ChunkCoord) const
+{
+	return GetLatticeChunkSeed(ChunkCoord, WorldSeed);
+}
+
+FIntVector UWFCSubsystem::GetLatticeChunkCoord(const FIntVector& AbsoluteCell, const FIntVector& WindowResolution)
+{
+	const FIntVector Stride = FWFCSolverContext::GetChunkStride(WindowResolution);
+	auto FloorDivide = [](int32 Value, int32 Divisor) { return Value >= 0 ? Value / Divisor : (Value - Divisor + 1) / Divisor; };
+	return FIntVector(FloorDivide(AbsoluteCell.X, Stride.X), FloorDivide(AbsoluteCell.Y, Stride.Y), FloorDivide(AbsoluteCell.Z, Stride.Z));
+}
 
-		UObject* LoadedObject = BaseObject.TryLoad();
-		if (LoadedObject)
+FIntVector UWFCSubsystem::GetLatticeOriginCell(const FIntVector& ChunkCoord, const FIntVector& WindowResolution)
+{
+	const FIntVector Stride = FWFCSolverContext::GetChunkStride(WindowResolution);
+	return FIntVector(
+		ChunkCoord.X * Stride.X + Stride.X / 2,
+		ChunkCoord.Y * Stride.Y + Stride.Y / 2,
+		ChunkCoord.Z * Stride.Z + WindowResolution.Z / 2);
+}
+
+int32 UWFCSubsystem::GetLatticeChunkSeed(const FIntVector& ChunkCoord, int32 LatticeSeed)
+{
+	const int32 SeedData[] = { LatticeSeed, ChunkCoord.X, ChunkCoord.Y, ChunkCoord.Z };
+	const int32 Seed = static_cast<int32>(FCrc::MemCrc32(SeedData, sizeof(SeedData)) & MAX_int32);
+
+	// 0 would ask for a random seed
+	return Seed != 0 ? Seed : 1;
+}
+
+bool UWFCSubsystem::SolveDeterministicChunk(const FWFCChunkLattice& Lattice, const FIntVector& ChunkCoord, int32 TryCount, int32& InOutRandomSeed, TArray<uint16>& OutOptionIds)
+{
+	// Primary chunks never depend on another chunk.  The others are only constrained by their four primary neighbors,
+	// gathered in a fixed order, so a chunk gets the same constraints whatever order chunks were generated in.
+	TArray<FWFCChunk, TInlineAllocator<4>> PrimaryNeighbors;
+	if (!IsPrimaryChunk(ChunkCoord))
+	{
+		static const FIntVector NeighborOffsets[] = { FIntVector(-1, 0, 0), FIntVector(1, 0, 0), FIntVector(0, -1, 0), FIntVector(0, 1, 0) };
+		for (const FIntVector& NeighborOffset : NeighborOffsets)
 		{
-			const FRotator BaseRotator = Tiles[index].RemainingOptions[0].BaseRotator;
-			const FVector BaseScale3D = Tiles[index].RemainingOptions[0].BaseScale3D;
-			const FVector PositionOffset = FVector(WFCModel->TileSize * 0.5f);
-			const auto zeroStartTilePosition = UWaveFunctionCollapseBPLibrary::IndexAsPosition(index, Resolution);
-			const auto zeroCenteredTilePosition = zeroStartTilePosition - Resolution / 2;
-			if (!(zeroCenteredTilePosition.X > -Resolution.X / 2 && zeroCenteredTilePosition.X < Resolution.X / 2 &&
-			zeroCenteredTilePosition.Y > -Resolution.Y / 2 && zeroCenteredTilePosition.Y < Resolution.Y / 2))
+			FWFCChunk PrimaryNeighbor;
+			if (GetPrimaryChunkTiles(Lattice, ChunkCoord + NeighborOffset, PrimaryNeighbor))
 			{
-				continue;
+				PrimaryNeighbors.Add(MoveTemp(PrimaryNeighbor));
 			}
-			const FIntVector absoluteGridPosition = RelativeToAbsolute(zeroCenteredTilePosition, OriginLocation, WFCModel->TileSize);
-			PlacedTiles.Add(absoluteGridPosition, Tiles[index].RemainingOptions[0]);
-			FVector TilePosition = (FVector(zeroCenteredTilePosition) * WFCModel->TileSize) + PositionOffset;
-			TilePosition.Z = 0;
+		}
+	}
+
+	TArray<const FWFCChunk*, TInlineAllocator<4>> PrimaryNeighborPtrs;
+	for (const FWFCChunk& PrimaryNeighbor : PrimaryNeighbors)
+	{
+		PrimaryNeighborPtrs.Add(&PrimaryNeighbor);
+	}
+	PrepareChunkSolve(Lattice.Solver, ChunkCoord, PrimaryNeighborPtrs, Lattice.Solver.StarterOptions, Lattice.Solver.WindowDistrictIds);
+	return Lattice.Solver.SolveChunk(TryCount, InOutRandomSeed, OutOptionIds);
+}
+
+bool UWFCSubsystem::GetPrimaryChunkTiles(const FWFCChunkLattice& Lattice, const FIntVector& ChunkCoord, FWFCChunk& OutChunk)
+{
+	const FIntVector Stride = Lattice.Solver.GetChunkStride();
+	OutChunk.MinCell = FIntVector(ChunkCoord.X * Stride.X, ChunkCoord.Y * Stride.Y, ChunkCoord.Z * Stride.Z);
+	OutChunk.Size = Stride;
+
+	const FWFCChunk* RecordedChunk = Lattice.Chunks.Find(GetLatticeOriginCell(ChunkCoord, Lattice.Solver.Resolution));
+	if (RecordedChunk && RecordedChunk->bDeterministic)
+	{
+		if (!RecordedChunk->OptionIds.IsEmpty())
+		{
+			OutChunk.OptionIds = RecordedChunk->OptionIds;
+			return true;
+		}
+
+		// The record keeps the seed of the successful attempt
+		int32 RecordedSeed = RecordedChunk->Seed;
+		return SolveDeterministicChunk(Lattice, ChunkCoord, 1, RecordedSeed, OutChunk.OptionIds);
+	}
+
+	int32 ChunkSeed = GetLatticeChunkSeed(ChunkCoord, Lattice.Seed);
+	return SolveDeterministicChunk(Lattice, ChunkCoord, DeterministicTryCount, ChunkSeed, OutChunk.OptionIds);
+}
+
+AActor* UWFCSubsystem::SpawnDeterministicChunk(const FIntVector& ChunkCoord, int32 TryCount, int32 RandomSeed)
+{
+	FWFCChunk Chunk = MakeDeterministicChunk(Solver, ChunkCoord, RandomSeed);
+	UE_LOG(LogTemp, Display, TEXT("Starting deterministic WFC - Chunk: %s, Seed: %d"), *ChunkCoord.ToString(), Chunk.Seed);
+	if (!SolveDeterministicChunk(GetCityLattice(), ChunkCoord, TryCount, Chunk.Seed, Chunk.OptionIds))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed after %d tries."), TryCount);
+		return nullptr;
+	}
 
-			// Static meshes are handled with ISM Components
-			if (UStaticMesh* LoadedStaticMesh = Cast<UStaticMesh>(LoadedObject))
+	return SpawnChunkRecord(MoveTemp(Chunk));
+}
+
+FWFCChunk UWFCSubsystem::MakeDeterministicChunk(const FWFCSolverContext& ChunkSolver, const FIntVector& ChunkCoord, int32 RandomSeed)
+{
+	const FIntVector Stride = ChunkSolver.GetChunkStride();
+	FWFCChunk Chunk;
+	Chunk.OriginCell = GetLatticeOriginCell(ChunkCoord, ChunkSolver.Resolution);
+	Chunk.Seed = RandomSeed;
+	Chunk.MinCell = FIntVector(ChunkCoord.X * Stride.X, ChunkCoord.Y * Stride.Y, ChunkCoord.Z * Stride.Z);
+	Chunk.Size = Stride;
+	Chunk.bDeterministic = true;
+	return Chunk;
+}
+
+void UWFCSubsystem::PrepareChunkSolve(const FWFCSolverContext& ChunkSolver, const FIntVector& ChunkCoord, TConstArrayView<const FWFCChunk*> PrimaryNeighbors,
+	TMap<FIntVector, FWaveFunctionCollapseOption>& OutStarterOptions, TArray<uint16>& OutWindowDistrictIds)
+{
+	const FIntVector& WindowResolution = ChunkSolver.Resolution;
+	const FIntVector Stride = ChunkSolver.GetChunkStride();
+	const FIntVector MinCell(ChunkCoord.X * Stride.X, ChunkCoord.Y * Stride.Y, ChunkCoord.Z * Stride.Z);
+	const FIntVector WindowMinCell = MinCell - ChunkSolver.GetChunkWindowOffset();
+
+	// The margin ring of the solve window overlaps the border cells of the neighbors
+	OutStarterOptions.Empty();
+	for (const FWFCChunk* PrimaryNeighbor : PrimaryNeighbors)
+	{
+		if (!PrimaryNeighbor)
+		{
+			continue;
+		}
+		for (int32 Z = 0; Z < WindowResolution.Z; Z++)
+		{
+			for (int32 Y = 0; Y < WindowResolution.Y; Y++)
 			{
-				UInstancedStaticMeshComponent* ISMComponent;
-				if (UInstancedStaticMeshComponent** FoundISMComponentPtr = BaseObjectToISM.Find(BaseObject))
+				for (int32 X = 0; X < WindowResolution.X; X++)
 				{
-					ISMComponent = *FoundISMComponentPtr;
-				}
-				else
-				{
-					ISMComponent = Cast<UInstancedStaticMeshComponent>(UWFCSubsystem::AddNamedInstanceComponent(SpawnedActor, UInstancedStaticMeshComponent::StaticClass(), LoadedObject->GetFName()));
-					BaseObjectToISM.Add(BaseObject, ISMComponent);
+					if (const FWaveFunctionCollapseOption* NeighborOption = ChunkSolver.CompiledModel->GetOption(PrimaryNeighbor->GetOptionId(WindowMinCell + FIntVector(X, Y, Z))))
+					{
+						OutStarterOptions.Add(FIntVector(X, Y, Z), *NeighborOption);
+					}
 				}
-				ISMComponent->SetStaticMesh(LoadedStaticMesh);
-				ISMComponent->SetMobility(EComponentMobility::Static);
-				ISMComponent->AddInstance(FTransform(BaseRotator, OriginLocation + TilePosition, BaseScale3D));
-
-				// Save the tile in the output map
 			}
-			// Blueprints are handled with ChildActorComponents
-			else if (UBlueprint* LoadedBlueprint = Cast<UBlueprint>(LoadedObject))
+		}
+	}
+
+	// The district lattice itself is never constrained by districts
+	if (ChunkSolver.DistrictMasks->IsEmpty())
+	{
+		OutWindowDistrictIds.Reset();
+		return;
+	}
+	GatherWindowDistrictIds(WindowMinCell, OutWindowDistrictIds);
+}
+
+void UWFCSubsystem::SolveChunks(const TArray<FIntVector>& ChunkCoords, TArray<FWFCSolverContext>& Solvers, const TMap<FIntVector, FWFCChunk>& PrimaryChunks, TArray<FWFCChunk>& OutChunks)
+{
+	OutChunks.Reset();
+	OutChunks.SetNum(ChunkCoords.Num());
+
+	// Starter options and districts are gathered on the game thread, districts may be solved by DistrictSolver on first use
+	TArray<TMap<FIntVector, FWaveFunctionCollapseOption>> ChunkStarterOptions;
+	TArray<TArray<uint16>> ChunkDistrictIds;
+	ChunkStarterOptions.SetNum(ChunkCoords.Num());
+	ChunkDistrictIds.SetNum(ChunkCoords.Num());
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkCoords.Num(); ChunkIndex++)
+	{
+		const FIntVector& ChunkCoord = ChunkCoords[ChunkIndex];
+		TArray<const FWFCChunk*, TInlineAllocator<4>> PrimaryNeighbors;
+		if (!IsPrimaryChunk(ChunkCoord))
+		{
+			static const FIntVector NeighborOffsets[] = { FIntVector(-1, 0, 0), FIntVector(1, 0, 0), FIntVector(0, -1, 0), FIntVector(0, 1, 0) };
+			for (const FIntVector& NeighborOffset : NeighborOffsets)
 			{
-				UClass* generatedClass = LoadedBlueprint->GeneratedClass.Get();
-				if (generatedClass->IsChildOf(AActor::StaticClass()))
+				// Failed primaries do not constrain their neighbors, as in SolveDeterministicChunk
+				const FWFCChunk* PrimaryChunk = PrimaryChunks.Find(ChunkCoord + NeighborOffset);
+				if (PrimaryChunk && !PrimaryChunk->OptionIds.IsEmpty())
 				{
-					AActor* tileActor = GetWorld()->SpawnActor<AActor>(generatedClass, OriginLocation + TilePosition, BaseRotator, FActorSpawnParameters{});
-					FActorLabelUtilities::SetActorLabelUnique(tileActor, WFCModel->GetFName().ToString());
-					//UChildActorComponent* ChildActorComponent = Cast<UChildActorComponent>(UWFCSubsystem::AddNamedInstanceComponent(SpawnedActor, UChildActorComponent::StaticClass(), LoadedObject->GetFName()));
-					//ChildActorComponent->SetChildActorClass(generatedClass);
-					//ChildActorComponent->SetRelativeLocation(OriginLocation + TilePosition);
-					//ChildActorComponent->SetRelativeRotation(BaseRotator);
-					//ChildActorComponent->SetRelativeScale3D(BaseScale3D);
+					PrimaryNeighbors.Add(PrimaryChunk);
 				}
 			}
-			else
+		}
+		OutChunks[ChunkIndex] = MakeDeterministicChunk(Solver, ChunkCoord, GetChunkSeed(ChunkCoord));
+		PrepareChunkSolve(Solver, ChunkCoord, PrimaryNeighbors, ChunkStarterOptions[ChunkIndex], ChunkDistrictIds[ChunkIndex]);
+	}
+
+	// Each task owns one solver context and pulls chunks until none are left
+	const int32 TryCount = DeterministicTryCount;
+	std::atomic<int32> NextChunkIndex(0);
+	ParallelFor(Solvers.Num(), [&](int32 SolverIndex)
+	{
+		FWFCSolverContext& ChunkSolver = Solvers[SolverIndex];
+		for (int32 ChunkIndex = NextChunkIndex++; ChunkIndex < ChunkCoords.Num(); ChunkIndex = NextChunkIndex++)
+		{
+			FWFCChunk& Chunk = OutChunks[ChunkIndex];
+			ChunkSolver.StarterOptions = MoveTemp(ChunkStarterOptions[ChunkIndex]);
+			ChunkSolver.WindowDistrictIds = MoveTemp(ChunkDistrictIds[ChunkIndex]);
+			if (!ChunkSolver.SolveChunk(TryCount, Chunk.Seed, Chunk.OptionIds))
+			{
+				Chunk.OptionIds.Empty();
+			}
+		}
+	});
+}
+
+AActor* UWFCSubsystem::SpawnChunkRecord(FWFCChunk&& Chunk)
+{
+	FWFCChunk& AddedChunk = Chunks.Add(Chunk.OriginCell, MoveTemp(Chunk));
+	IndexChunkCells(AddedChunk);
+	return SpawnChunk(AddedChunk);
+}
+
+void UWFCSubsystem::IndexChunkCells(const FWFCChunk& Chunk)
+{
+	if (Chunk.Size.X <= 0 || Chunk.Size.Y <= 0 || Chunk.Size.Z <= 0)
+	{
+		return;
+	}
+	const FIntVector MinPage = GetChunkCellPage(Chunk.MinCell);
+	const FIntVector MaxPage = GetChunkCellPage(Chunk.MinCell + Chunk.Size - FIntVector(1));
+	for (int32 Z = MinPage.Z; Z <= MaxPage.Z; Z++)
+	{
+		for (int32 Y = MinPage.Y; Y <= MaxPage.Y; Y++)
+		{
+			for (int32 X = MinPage.X; X <= MaxPage.X; X++)
 			{
-				UE_LOG(LogTemp, Warning, TEXT("Invalid Type, skipping: %s"), *BaseObject.ToString());
+				ChunkCellPages.FindOrAdd(FIntVector(X, Y, Z)).AddUnique(Chunk.OriginCell);
 			}
 		}
-		else
+	}
+}
+
+void UWFCSubsystem::InitializeWFC(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles)
+{
+	Solver.InitializeWFC(Tiles, RemainingTiles);
+}
+
+bool UWFCSubsystem::Observe(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue, int32 RandomSeed)
+{
+	Solver.SyncTileOptionIds(Tiles);
+	return Solver.Observe(Tiles, RemainingTiles, ObservationQueue, RandomSeed);
+}
+
+bool UWFCSubsystem::Propagate(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue, int32& PropagationCount)
+{
+	Solver.SyncTileOptionIds(Tiles);
+	return Solver.Propagate(Tiles, RemainingTiles, ObservationQueue, PropagationCount);
+}
+
+bool UWFCSubsystem::ObservationPropagation(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue, int32 RandomSeed)
+{
+	Solver.SyncTileOptionIds(Tiles);
+	return Solver.ObservationPropagation(Tiles, RemainingTiles, ObservationQueue, RandomSeed);
+}
+
+UActorComponent* UWFCSubsystem::AddNamedInstanceComponent(AActor* Actor, TSubclassOf<UActorComponent> ComponentClass, FName ComponentName, const FTransform& RelativeTransform /* = FTransform::Identity */)
+{
+	// Game worlds record no undo history.  Editor worlds, e.g. the bake commandlet, keep the components undoable like the editor does.
+	EObjectFlags ComponentFlags = RF_NoFlags;
+#if WITH_EDITOR
+	const bool bEditorWorld = !Actor->GetWorld()->IsGameWorld();
+	if (bEditorWorld)
+	{
+		Actor->Modify();
+		ComponentFlags |= RF_Transactional;
+	}
+#endif
+
+	// Numbered after the requested name, only objects within the actor are checked
+	const FName ComponentInstanceName = MakeUniqueObjectName(Actor, ComponentClass, ComponentName);
+	UActorComponent* InstanceComponent = NewObject<UActorComponent>(Actor, ComponentClass, ComponentInstanceName, ComponentFlags);
+	if (InstanceComponent)
+	{
+		// Set before registration, otherwise the component already entered the navigation octree
+		if (bBatchNavigationUpdates && !ComponentClass->IsChildOf<UWFCChunkNavigationComponent>())
+		{
+			InstanceComponent->SetCanEverAffectNavigation(false);
+		}
+		Actor->AddInstanceComponent(InstanceComponent);
+		Actor->FinishAddComponent(InstanceComponent, false, RelativeTransform);
+#if WITH_EDITOR
+		if (bEditorWorld)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("Unable to load object, skipping: %s"), *BaseObject.ToString());
+			Actor->RerunConstructionScripts();
 		}
+#endif
 	}
+	return InstanceComponent;
+}
 
-	return SpawnedActor;
+void UWFCSubsystem::LabelSpawnedActor(AActor* Actor) const
+{
+#if WITH_EDITOR
+	// Labels only show in the outliner of editor worlds, probing every actor of a game world for a unique label is wasted
+	if (Actor && !Actor->GetWorld()->IsGameWorld())
+	{
+		FActorLabelUtilities::SetActorLabelUnique(Actor, WFCModel->GetFName().ToString());
+	}
+#endif
 }
 
-bool UWFCSubsystem::AreAllTilesNonSpawnable(const TArray<FWaveFunctionCollapseTile>& Tiles)
+UInstancedStaticMeshComponent* UWFCSubsystem::FindOrAddISMComponent(AActor* Actor, UStaticMesh* StaticMesh, TMap<FSoftObjectPath, UInstancedStaticMeshComponent*>& MeshToISM)
 {
-	bool bAllTilesAreNonSpawnable = true;
-	for (int32 index = 0; index < Tiles.Num(); index++)
+	const FSoftObjectPath MeshPath(StaticMesh);
+	if (UInstancedStaticMeshComponent** FoundISMComponentPtr = MeshToISM.Find(MeshPath))
+	{
+		return *FoundISMComponentPtr;
+	}
+
+	UInstancedStaticMeshComponent* ISMComponent = Cast<UInstancedStaticMeshComponent>(AddNamedInstanceComponent(Actor, UInstancedStaticMeshComponent::StaticClass(), StaticMesh->GetFName()));
+	ISMComponent->SetStaticMesh(StaticMesh);
+	ISMComponent->SetMobility(EComponentMobility::Static);
+	// Instance bodies are only created once the chunk collision gets enabled
+	ISMComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	MeshToISM.Add(MeshPath, ISMComponent);
+	return ISMComponent;
+}
+
+void UWFCSubsystem::FlattenBlueprintTiles()
+{
+	// Flattened tiles only depend on the Blueprint, so they are kept across model compiles
+	ResolvedOptions.Reset();
+	if (!WFCModel)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid WFC Model"));
+		return;
+	}
+
+	for (const TPair<FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap>& Constraint : WFCModel->Constraints)
+	{
+		const FSoftObjectPath& BaseObject = Constraint.Key.BaseObject;
+		if (FlattenedTiles.Contains(BaseObject))
+		{
+			continue;
+		}
+
+		// UBlueprint is editor-only, so the generated class is loaded directly
+		UClass* ActorClass = FSoftClassPath(BaseObject.ToString() + TEXT("_C")).TryLoadClass<AActor>();
+		if (!ActorClass)
+		{
+			continue;
+		}
+
+		FWFCFlattenedTile& FlattenedTile = FlattenedTiles.Add(BaseObject);
+		FlattenActorClass(ActorClass, FlattenedTile);
+		if (FlattenedTile.bSpawnActor)
+		{
+			UE_LOG(LogTemp, Display, TEXT("Tile Blueprint kept as actor: %s"), *BaseObject.ToString());
+		}
+		else
+		{
+			UE_LOG(LogTemp, Display, TEXT("Tile Blueprint flattened into %d meshes: %s"), FlattenedTile.Meshes.Num(), *BaseObject.ToString());
+		}
+	}
+}
+
+void UWFCSubsystem::FlattenActorClass(UClass* ActorClass, FWFCFlattenedTile& OutFlattenedTile)
+{
+	// Event graph logic or an explicit opt-in require a real actor
+	const AActor* DefaultActor = ActorClass->GetDefaultObject<AActor>();
+	const UBlueprintGeneratedClass* BlueprintClass = Cast<UBlueprintGeneratedClass>(ActorClass);
+	if (DefaultActor->Tags.Contains(SpawnAsActorTag) || (BlueprintClass && BlueprintClass->UberGraphFunction))
 	{
-		if (Tiles[index].RemainingOptions.Num() == 1)
+		OutFlattenedTile.bSpawnActor = true;
+		return;
+	}
+
+	// Returns false if the component carries more than meshes and transforms
+	auto FlattenComponent = [&OutFlattenedTile](const UActorComponent* Component, const FTransform& ComponentToRoot)
+	{
+		if (const UInstancedStaticMeshComponent* InstancedComponent = Cast<UInstancedStaticMeshComponent>(Component))
 		{
-			FSoftObjectPath BaseObject = Tiles[index].RemainingOptions[0].BaseObject;
-			if (!(BaseObject == FWaveFunctionCollapseOption::EmptyOption.BaseObject
-				|| BaseObject == FWaveFunctionCollapseOption::VoidOption.BaseObject
-				|| WFCModel->SpawnExclusion.Contains(BaseObject)))
+			if (InstancedComponent->GetStaticMesh() && !InstancedComponent->bHiddenInGame)
 			{
-				bAllTilesAreNonSpawnable = false;
-				break;
+				for (int32 InstanceIndex = 0; InstanceIndex < InstancedComponent->GetInstanceCount(); InstanceIndex++)
+				{
+					FTransform InstanceTransform;
+					InstancedComponent->GetInstanceTransform(InstanceIndex, InstanceTransform, false);
+					FWFCFlattenedMesh& FlattenedMesh = OutFlattenedTile.Meshes.AddDefaulted_GetRef();
+					FlattenedMesh.StaticMesh = InstancedComponent->GetStaticMesh();
+					FlattenedMesh.RelativeTransform = InstanceTransform * ComponentToRoot;
+				}
+			}
+			return true;
+		}
+		if (const UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Component))
+		{
+			if (MeshComponent->GetStaticMesh() && !MeshComponent->bHiddenInGame)
+			{
+				FWFCFlattenedMesh& FlattenedMesh = OutFlattenedTile.Meshes.AddDefaulted_GetRef();
+				FlattenedMesh.StaticMesh = MeshComponent->GetStaticMesh();
+				FlattenedMesh.RelativeTransform = ComponentToRoot;
+			}
+			return true;
+		}
+		// Plain scene components only carry transforms, editor-only components are never cooked
+		return Component->GetClass() == USceneComponent::StaticClass() || Component->IsEditorOnly();
+	};
+
+	// The layout is read from the class defaults without spawning anything.  The user construction script does not run,
+	// tiles relying on it opt in with SpawnAsActorTag.
+	TMap<FName, FTransform> ComponentToRootByName;
+	const USceneComponent* DefaultRoot = DefaultActor->GetRootComponent();
+
+	// Native components are default subobjects of the CDO
+	TArray<UObject*> DefaultSubobjects;
+	GetObjectsWithOuter(DefaultActor, DefaultSubobjects, false);
+	for (const UObject* Subobject : DefaultSubobjects)
+	{
+		const UActorComponent* Component = Cast<UActorComponent>(Subobject);
+		if (!Component)
+		{
+			continue;
+		}
+
+		FTransform ComponentToRoot = FTransform::Identity;
+		if (const USceneComponent* SceneComponent = Cast<USceneComponent>(Component))
+		{
+			for (const USceneComponent* Parent = SceneComponent; Parent && Parent != DefaultRoot; Parent = Parent->GetAttachParent())
+			{
+				ComponentToRoot = ComponentToRoot * Parent->GetRelativeTransform();
 			}
 		}
+		ComponentToRootByName.Add(Component->GetFName(), ComponentToRoot);
+
+		if (!FlattenComponent(Component, ComponentToRoot))
+		{
+			OutFlattenedTile.bSpawnActor = true;
+			break;
+		}
 	}
-	return bAllTilesAreNonSpawnable;
-}
+
+	// Blueprint components are node templates of the construction scripts, parent classes first
+	TArray<UBlueprintGeneratedClass*> BlueprintClasses;
+	for (UClass* Class = ActorClass; Class; Class = Class->GetSuperClass())
+	{
+		if (UBlueprintGeneratedClass* GeneratedClass = Cast<UBlueprintGeneratedClass>(Class))
+		{
+			BlueprintClasses.Insert(GeneratedClass, 0);
+		}
+	}
+
+	bool bHasRoot = DefaultRoot != nullptr;
+	for (int32 ClassIndex = 0; ClassIndex < BlueprintClasses.Num() && !OutFlattenedTile.bSpawnActor; ClassIndex++)
+	{
+		const USimpleConstructionScript* ConstructionScript = BlueprintClasses[ClassIndex]->SimpleConstructionScript;
+		if (!ConstructionScript)
+		{
+			continue;
+		}
+
+		// GetAllNodes lists parents before their children
+		for (USCS_Node* Node : ConstructionScript->GetAllNodes())
+		{
+			// Child classes may override the templates of inherited nodes
+			const UActorComponent* Template = Node->ComponentTemplate;
+			for (int32 ChildIndex = BlueprintClasses.Num() - 1; ChildIndex > ClassIndex; ChildIndex--)
+			{
+				const UInheritableComponentHandler* ComponentHandler = BlueprintClasses[ChildIndex]->GetInheritableComponentHandler();
+				if (const UActorComponent* OverriddenTemplate = ComponentHandler ? ComponentHandler->GetOverridenComponentTemplate(FComponentKey(Node)) : nullptr)
+				{
+					Template = OverriddenTemplate;
+					break;
+				}
+			}
+			if (!Template)
+			{
+				continue;
+			}
+
+			FTransform ComponentToRoot = FTransform::Identity;
+			if (const USceneComponent* SceneTemplate = Cast<USceneComponent>(Template))
+			{
+				const USCS_Node* ParentNode = ConstructionScript->FindParentNode(Node);
+				const FName ParentName = ParentNode ? ParentNode->GetVariableName() : Node->ParentComponentOrVariableName;
+				if (const FTransform* ParentToRoot = ComponentToRootByName.Find(ParentName))
+				{
+					ComponentToRoot = SceneTemplate->GetRelativeTransform() * *ParentToRoot;
+				}
+				else if (bHasRoot)
+				{
+					ComponentToRoot = SceneTemplate->GetRelativeTransform();
+				}
+				// The first unparented scene node becomes the actor root
+				bHasRoot = true;
+			}
+			ComponentToRootByName.Add(Node->GetVariableName(), ComponentToRoot);
+
+			if (!FlattenComponent(Template, ComponentToRoot))
+			{
+				OutFlattenedTile.bSpawnActor = true;
+				break;
+			}
+		}
+	}
+
+	if (OutFlattenedTile.bSpawnActor)
+	{
+		OutFlattenedTile.Meshes.Empty();
+	}
+}
+
+AActor* UWFCSubsystem::SpawnActorFromTiles(const TArray<FWaveFunctionCollapseTile>& Tiles, int32 RandomSeed)
+{
+	// Record the inner tiles of the solve as a new chunk
+	FWFCChunk Chunk;
+	Chunk.OriginCell = RelativeToAbsolute(FIntVector::ZeroValue, OriginLocation, WFCModel->TileSize);
+	Chunk.Seed = RandomSeed;
+	Chunk.MinCell = Chunk.OriginCell - FIntVector(Solver.Resolution.X / 2 - 1, Solver.Resolution.Y / 2 - 1, Solver.Resolution.Z / 2);
+	Chunk.Size = FIntVector(FMath::Max(2 * (Solver.Resolution.X / 2) - 1, 0), FMath::Max(2 * (Solver.Resolution.Y / 2) - 1, 0), Solver.Resolution.Z);
+	Chunk.OptionIds.Init(FWFCCompiledModel::InvalidOptionId, Chunk.Size.X * Chunk.Size.Y * Chunk.Size.Z);
+
+	int32 NumOwnedTiles = 0;
+	for (int32 index = 0; index < Tiles.Num(); index++)
+	{
+		if (Tiles[index].RemainingOptions.Num() != 1)
+		{
+			continue;
+		}
+
+		// Tiles already owned by another chunk keep their geometry
+		const auto zeroStartTilePosition = UWaveFunctionCollapseBPLibrary::IndexAsPosition(index, Solver.Resolution);
+		const auto zeroCenteredTilePosition = zeroStartTilePosition - Solver.Resolution / 2;
+		const FIntVector absoluteGridPosition = RelativeToAbsolute(zeroCenteredTilePosition, OriginLocation, WFCModel->TileSize);
+		if (FindPlacedOptionId(absoluteGridPosition) != FWFCCompiledModel::InvalidOptionId)
+		{
+			continue;
+		}
+		const uint16 OptionId = CompiledModel->FindOptionId(Tiles[index].RemainingOptions[0]);
+
+		// The margin ring and empty, void or excluded options are not placed, they are kept as provisional tiles for the next solves
+		const bool bInnerTile = zeroCenteredTilePosition.X > -Solver.Resolution.X / 2 && zeroCenteredTilePosition.X < Solver.Resolution.X / 2 &&
+			zeroCenteredTilePosition.Y > -Solver.Resolution.Y / 2 && zeroCenteredTilePosition.Y < Solver.Resolution.Y / 2;
+		if (!bInnerTile || !CompiledModel->IsObjectSpawnable(Tiles[index].RemainingOptions[0].BaseObject))
+		{
+			if (OptionId != FWFCCompiledModel::InvalidOptionId)
+			{
+				ProvisionalTiles.Add(absoluteGridPosition, OptionId);
+			}
+			continue;
+		}
+
+		Chunk.OptionIds[Chunk.GetCellIndex(absoluteGridPosition)] = OptionId;
+		NumOwnedTiles++;
+	}
+
+	if (NumOwnedTiles == 0)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Solve at %s placed no new tiles"), *Chunk.OriginCell.ToString());
+		return nullptr;
+	}
+
+	return SpawnChunkRecord(MoveTemp(Chunk));
+}
+
+AActor* UWFCSubsystem::SpawnChunk(FWFCChunk& Chunk)
+{
+	// Spawn Actor
+	const FVector ChunkLocation = FVector(Chunk.OriginCell) * WFCModel->TileSize;
+	AActor* SpawnedActor = GetWorld()->SpawnActor<AActor>(ChunkLocation, Orientation, FActorSpawnParameters{});
+	LabelSpawnedActor(SpawnedActor);
+
+	// Gather instance transforms per mesh, so each ISM Component receives all its instances in one upload
+	TMap<UStaticMesh*, TArray<FTransform>> MeshToInstanceTransforms;
+	const FVector PositionOffset = FVector(WFCModel->TileSize * 0.5f);
+	for (int32 CellIndex = 0; CellIndex < Chunk.OptionIds.Num(); CellIndex++)
+	{
+		const uint16 OptionId = Chunk.OptionIds[CellIndex];
+		const FWaveFunctionCollapseOption* Option = CompiledModel->GetOption(OptionId);
+		if (!Option)
+		{
+			continue;
+		}
+
+		// Save the tile in the output map
+		const FIntVector absoluteGridPosition = Chunk.GetCellPosition(CellIndex);
+		PlacedTiles.Add(absoluteGridPosition, OptionId);
+		ProvisionalTiles.Remove(absoluteGridPosition);
+
+		const FIntVector zeroCenteredTilePosition = absoluteGridPosition - Chunk.OriginCell;
+		FVector TilePosition = (FVector(zeroCenteredTilePosition) * WFCModel->TileSize) + PositionOffset;
+		TilePosition.Z = 0;
+		const FTransform TileTransform(Option->BaseRotator, ChunkLocation + TilePosition, Option->BaseScale3D);
+
+		// Static meshes and flattened Blueprints are handled with ISM Components
+		const FWFCResolvedOption& ResolvedOption = ResolveOption(OptionId);
+		for (const FWFCFlattenedMesh& Mesh : ResolvedOption.Meshes)
+		{
+			MeshToInstanceTransforms.FindOrAdd(Mesh.StaticMesh).Add(Mesh.RelativeTransform * TileTransform);
+		}
+
+		// Remaining Blueprints are spawned as actors
+		if (ResolvedOption.ActorClass)
+		{
+			AActor* tileActor = GetWorld()->SpawnActor<AActor>(ResolvedOption.ActorClass, ChunkLocation + TilePosition, Option->BaseRotator, FActorSpawnParameters{});
+			LabelSpawnedActor(tileActor);
+			Chunk.TileActors.Add(tileActor);
+		}
+	}
+
+	// Create Components
+	TMap<FSoftObjectPath, UInstancedStaticMeshComponent*> MeshToISM;
+	TArray<FTransform> ProxyTransforms;
+	for (const TPair<UStaticMesh*, TArray<FTransform>>& MeshInstances : MeshToInstanceTransforms)
+	{
+		UInstancedStaticMeshComponent* ISMComponent = FindOrAddISMComponent(SpawnedActor, MeshInstances.Key, MeshToISM);
+		ISMComponent->AddInstances(MeshInstances.Value, false);
+
+		// Meshes without simple collision are replaced by a box around their bounds, the engine cube being 100 units wide
+		if (bUseCollisionProxies && !HasSimpleCollision(MeshInstances.Key))
+		{
+			const FBoxSphereBounds MeshBounds = MeshInstances.Key->GetBounds();
+			const FTransform ProxyTransform(FQuat::Identity, MeshBounds.Origin, MeshBounds.BoxExtent / 50.0);
+			for (const FTransform& InstanceTransform : MeshInstances.Value)
+			{
+				ProxyTransforms.Add(ProxyTransform * InstanceTransform);
+			}
+			continue;
+		}
+		ISMComponent->ComponentTags.Add(CollisionComponentTag);
+	}
+
+	UStaticMesh* ProxyMesh = ProxyTransforms.IsEmpty() ? nullptr : CollisionProxyMesh.LoadSynchronous();
+	if (ProxyMesh)
+	{
+		UInstancedStaticMeshComponent* ProxyComponent = Cast<UInstancedStaticMeshComponent>(AddNamedInstanceComponent(SpawnedActor, UInstancedStaticMeshComponent::StaticClass(), TEXT("CollisionProxies")));
+		ProxyComponent->SetStaticMesh(ProxyMesh);
+		ProxyComponent->SetMobility(EComponentMobility::Static);
+		ProxyComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		ProxyComponent->SetVisibility(false);
+		ProxyComponent->SetCastShadow(false);
+		ProxyComponent->ComponentTags.Add(CollisionComponentTag);
+		ProxyComponent->AddInstances(ProxyTransforms, false);
+	}
+	else if (!ProxyTransforms.IsEmpty())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Unable to load collision proxy mesh: %s"), *CollisionProxyMesh.ToString());
+	}
+
+	// Registered last, its bounds and geometry cover every component of the chunk
+	if (bBatchNavigationUpdates && !MeshToInstanceTransforms.IsEmpty())
+	{
+		AddNamedInstanceComponent(SpawnedActor, UWFCChunkNavigationComponent::StaticClass(), TEXT("Navigation"));
+	}
+
+	Chunk.Actor = SpawnedActor;
+	Chunk.bResident = true;
+	Chunk.bCollisionEnabled = false;
+	if (CollisionRadius <= 0.0f)
+	{
+		SetChunkCollisionEnabled(Chunk, true);
+	}
+	Chunk.ProxyLayoutHash = 0;
+	if (ChunkProxySwapDistance > 0.0f && !MeshToInstanceTransforms.IsEmpty())
+	{
+		RequestChunkProxy(Chunk, MeshToInstanceTransforms);
+	}
+	Chunk.ResidentMemoryBytes = EstimateActorMemoryBytes(SpawnedActor) + Chunk.OptionIds.Num() * sizeof(uint16);
+	for (const TWeakObjectPtr<AActor>& TileActor : Chunk.TileActors)
+	{
+		Chunk.ResidentMemoryBytes += EstimateActorMemoryBytes(TileActor.Get());
+	}
+	SpawnedActors.Add(ChunkLocation, SpawnedActor);
+	if (bPublishPlacedTiles)
+	{
+		PlacedTilesPublisher.Publish(PlacedTiles, CompiledModel, Chunk.MinCell, Chunk.MinCell + Chunk.Size - FIntVector(1));
+	}
+
+	return SpawnedActor;
+}
+
+void UWFCSubsystem::RequestChunkProxy(FWFCChunk& Chunk, const TMap<UStaticMesh*, TArray<FTransform>>& MeshToInstanceTransforms)
+{
+	Chunk.ProxyLayoutHash = FWFCChunkProxy::GetLayoutHash(Chunk, CompiledModel->ModelHash, WFCModel->TileSize);
+	ChunkProxyUsers.FindOrAdd(Chunk.ProxyLayoutHash)++;
+	if (const TObjectPtr<UStaticMesh>* ProxyMesh = ChunkProxyMeshes.Find(Chunk.ProxyLayoutHash))
+	{
+		AttachChunkProxy(Chunk, *ProxyMesh);
+		return;
+	}
+	if (PendingChunkProxies.Contains(Chunk.ProxyLayoutHash))
+	{
+		return;
+	}
+
+	// Mesh render data is read here on the game thread, the task only merges the gathered triangles
+	const FVector ChunkLocation = FVector(Chunk.OriginCell) * WFCModel->TileSize;
+	TArray<FWFCProxyInstances> Instances;
+	for (const TPair<UStaticMesh*, TArray<FTransform>>& MeshInstances : MeshToInstanceTransforms)
+	{
+		TSharedPtr<const FWFCProxyGeometry>& Geometry = ProxyGeometries.FindOrAdd(FSoftObjectPath(MeshInstances.Key));
+		if (!Geometry)
+		{
+			TSharedRef<FWFCProxyGeometry> GatheredGeometry = MakeShared<FWFCProxyGeometry>();
+			FWFCChunkProxy::GatherMeshGeometry(MeshInstances.Key, ChunkProxyMaxTrianglesPerMesh, *GatheredGeometry);
+			Geometry = GatheredGeometry;
+		}
+		if (Geometry->Indices.IsEmpty())
+		{
+			continue;
+		}
+
+		FWFCProxyInstances& ProxyInstances = Instances.AddDefaulted_GetRef();
+		ProxyInstances.Geometry = Geometry;
+		ProxyInstances.Transforms.Reserve(MeshInstances.Value.Num());
+		for (const FTransform& InstanceTransform : MeshInstances.Value)
+		{
+			ProxyInstances.Transforms.Add_GetRef(InstanceTransform).AddToTranslation(-ChunkLocation);
+		}
+	}
+
+	PendingChunkProxies.Add(Chunk.ProxyLayoutHash, UE::Tasks::Launch(UE_SOURCE_LOCATION, [Instances = MoveTemp(Instances)]()
+	{
+		TSharedPtr<FWFCProxyMesh> ProxyMesh = MakeShared<FWFCProxyMesh>();
+		FWFCChunkProxy::BuildMeshDescription(Instances, *ProxyMesh);
+		return ProxyMesh;
+	}));
+}
+
+void UWFCSubsystem::FinishChunkProxies()
+{
+	UMaterialInterface* FallbackMaterial = nullptr;
+	for (auto It = PendingChunkProxies.CreateIterator(); It; ++It)
+	{
+		if (!It->Value.IsCompleted())
+		{
+			continue;
+		}
+		const uint32 LayoutHash = It->Key;
+		const TSharedPtr<FWFCProxyMesh> MergedMesh = It->Value.GetResult();
+		It.RemoveCurrent();
+
+		// Every chunk with this layout was evicted while it was merging
+		if (!ChunkProxyUsers.Contains(LayoutHash) || MergedMesh->MeshDescription.Triangles().Num() == 0)
+		{
+			continue;
+		}
+
+		// Static meshes can only be built on the game thread.  Slots are matched to polygon groups by name.
+		UStaticMesh* ProxyMesh = NewObject<UStaticMesh>(this, NAME_None, RF_Transient);
+		for (int32 MaterialIndex = 0; MaterialIndex < MergedMesh->Materials.Num(); MaterialIndex++)
+		{
+			UMaterialInterface* Material = Cast<UMaterialInterface>(MergedMesh->Materials[MaterialIndex].TryLoad());
+			if (!Material)
+			{
+				FallbackMaterial = FallbackMaterial ? FallbackMaterial : ChunkProxyMaterial.LoadSynchronous();
+				Material = FallbackMaterial;
+			}
+			ProxyMesh->GetStaticMaterials().Add(FStaticMaterial(Material, FWFCChunkProxy::GetMaterialSlotName(MaterialIndex)));
+		}
+		UStaticMesh::FBuildMeshDescriptionsParams BuildParams;
+		BuildParams.bFastBuild = true;
+		BuildParams.bBuildSimpleCollision = false;
+		BuildParams.bCommitMeshDescription = false;
+		BuildParams.bMarkPackageDirty = false;
+		const TArray<const FMeshDescription*> MeshDescriptions = { &MergedMesh->MeshDescription };
+		if (!ProxyMesh->BuildFromMeshDescriptions(MeshDescriptions, BuildParams))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Unable to build chunk proxy %08x"), LayoutHash);
+			continue;
+		}
+		ChunkProxyMeshes.Add(LayoutHash, ProxyMesh);
+
+		// Every resident chunk spawned with this layout while it was merging
+		for (TPair<FIntVector, FWFCChunk>& ChunkPair : Chunks)
+		{
+			if (ChunkPair.Value.bResident && ChunkPair.Value.ProxyLayoutHash == LayoutHash)
+			{
+				AttachChunkProxy(ChunkPair.Value, ProxyMesh);
+			}
+		}
+	}
+}
+
+void UWFCSubsystem::AttachChunkProxy(FWFCChunk& Chunk, UStaticMesh* ProxyMesh)
+{
+	AActor* ChunkActor = Chunk.Actor.Get();
+	if (!ChunkActor || ChunkActor->FindComponentByTag<UStaticMeshComponent>(ChunkProxyComponentTag))
+	{
+		return;
+	}
+
+	// Full detail near the players, the proxy beyond.  Meshes left out of the proxy keep drawing at any distance.
+	for (UActorComponent* Component : ChunkActor->GetComponents())
+	{
+		UInstancedStaticMeshComponent* ISMComponent = Cast<UInstancedStaticMeshComponent>(Component);
+		const TSharedPtr<const FWFCProxyGeometry>* Geometry = ISMComponent ? ProxyGeometries.Find(FSoftObjectPath(ISMComponent->GetStaticMesh().Get())) : nullptr;
+		if (Geometry && Geometry->IsValid() && !(*Geometry)->Indices.IsEmpty())
+		{
+			ISMComponent->LDMaxDrawDistance = ChunkProxySwapDistance;
+			ISMComponent->SetCachedMaxDrawDistance(ChunkProxySwapDistance);
+		}
+	}
+
+	// The root ISM Component sits at the world origin, proxies are built relative to the chunk location
+	const FTransform ProxyTransform(FVector(Chunk.OriginCell) * WFCModel->TileSize);
+	UStaticMeshComponent* ProxyComponent = Cast<UStaticMeshComponent>(AddNamedInstanceComponent(ChunkActor, UStaticMeshComponent::StaticClass(), TEXT("ChunkProxy"), ProxyTransform));
+	ProxyComponent->SetStaticMesh(ProxyMesh);
+	ProxyComponent->SetMobility(EComponentMobility::Static);
+	ProxyComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProxyComponent->MinDrawDistance = ChunkProxySwapDistance;
+	ProxyComponent->ComponentTags.Add(ChunkProxyComponentTag);
+	ProxyComponent->MarkRenderStateDirty();
+}
+
+void UWFCSubsystem::ReleaseChunkProxy(FWFCChunk& Chunk)
+{
+	const uint32 LayoutHash = Chunk.ProxyLayoutHash;
+	Chunk.ProxyLayoutHash = 0;
+	int32* NumUsers = LayoutHash != 0 ? ChunkProxyUsers.Find(LayoutHash) : nullptr;
+	if (!NumUsers || --(*NumUsers) > 0)
+	{
+		return;
+	}
+
+	// The transient mesh is collected once the evicted chunk actors are gone
+	ChunkProxyMeshes.Remove(LayoutHash);
+	ChunkProxyUsers.Remove(LayoutHash);
+	if (ChunkProxyUsers.IsEmpty())
+	{
+		ProxyGeometries.Empty();
+	}
+}
+
+const FWFCResolvedOption& UWFCSubsystem::ResolveOption(uint16 OptionId)
+{
+	if (ResolvedOptions.Num() != CompiledModel->NumOptions())
+	{
+		ResolvedOptions.SetNum(CompiledModel->NumOptions());
+	}
+
+	FWFCResolvedOption& ResolvedOption = ResolvedOptions[OptionId];
+	if (ResolvedOption.bResolved)
+	{
+		return ResolvedOption;
+	}
+	ResolvedOption.bResolved = true;
+
+	// Empty, void and excluded options are placed without geometry
+	const FSoftObjectPath& BaseObject = CompiledModel->Options[OptionId].BaseObject;
+	if (!CompiledModel->IsObjectSpawnable(BaseObject))
+	{
+		return ResolvedOption;
+	}
+
+	UObject* LoadedObject = BaseObject.TryLoad();
+	if (UStaticMesh* LoadedStaticMesh = Cast<UStaticMesh>(LoadedObject))
+	{
+		ResolvedOption.Meshes.AddDefaulted_GetRef().StaticMesh = LoadedStaticMesh;
+	}
+	else if (const FWFCFlattenedTile* FlattenedTile = FlattenedTiles.Find(BaseObject); FlattenedTile && !FlattenedTile->bSpawnActor)
+	{
+		ResolvedOption.Meshes = FlattenedTile->Meshes;
+	}
+	else if (UClass* ActorClass = FSoftClassPath(BaseObject.ToString() + TEXT("_C")).TryLoadClass<AActor>())
+	{
+		// Blueprint tiles resolve to their generated class, UBlueprint itself is not cooked
+		ResolvedOption.ActorClass = ActorClass;
+	}
+	else if (LoadedObject)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Invalid Type, skipping: %s"), *BaseObject.ToString());
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Unable to load object, skipping: %s"), *BaseObject.ToString());
+	}
+	return ResolvedOption;
+}
+
+void UWFCSubsystem::CompileModel()
+{
+	CompiledModel = FWFCCompiledModel::CompileShared(WFCModel);
+	Solver.CompiledModel = CompiledModel;
+	if (!CompiledModel->IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not compile WFC Model"));
+		return;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Compiled WFC Model %s: %d options, hash %08x"), *WFCModel->GetName(), CompiledModel->NumOptions(), CompiledModel->ModelHash);
+
+	// Provisional option IDs refer to the previous model
+	ProvisionalTiles.Empty();
+
+	FlattenBlueprintTiles();
+	CompileDistrictModel();
+
+	// Events replicated before the model was ready
+	ApplyGenerationEvents();
+}
+
+void UWFCSubsystem::SetGenerationReplicator(AWFCGenerationReplicator* Replicator)
+{
+	GenerationReplicator = Replicator;
+	ApplyGenerationEvents();
+}
+
+void UWFCSubsystem::RecordGenerationEvent(const FWFCChunk& Chunk, TArray<uint32>&& BoundaryCells)
+{
+	const ENetMode NetMode = GetWorld()->GetNetMode();
+	if (NetMode != NM_ListenServer && NetMode != NM_DedicatedServer)
+	{
+		return;
+	}
+
+	if (!GenerationReplicator.IsValid())
+	{
+		GenerationReplicator = GetWorld()->SpawnActor<AWFCGenerationReplicator>();
+	}
+
+	FWFCGenerationEvent Event;
+	Event.Sequence = NextGenerationEventSequence++;
+	Event.Cell = Chunk.bDeterministic ? GetChunkCoord(Chunk.MinCell) : Chunk.OriginCell;
+	Event.Seed = Chunk.Seed;
+	Event.ModelHash = CompiledModel->ModelHash;
+	Event.BoundaryCells = MoveTemp(BoundaryCells);
+	Event.Checksum = FWFCGenerationEvent::GetChunkChecksum(Chunk);
+	Event.bDeterministic = Chunk.bDeterministic;
+	GenerationReplicator->AddEvent(MoveTemp(Event));
+}
+
+void UWFCSubsystem::ApplyGenerationEvents()
+{
+	const AWFCGenerationReplicator* Replicator = GenerationReplicator.Get();
+	if (!Replicator || GetWorld()->GetNetMode() != NM_Client || !WFCModel || !CompiledModel->IsValid())
+	{
+		return;
+	}
+
+	SyncSolutionCache();
+
+	// Events can be received out of order, a missing sequence holds back the events after it
+	TArray<const FWFCGenerationEvent*> PendingEvents;
+	for (const FWFCGenerationEvent& Event : Replicator->GetEvents())
+	{
+		if (Event.Sequence >= NextGenerationEventSequence)
+		{
+			PendingEvents.Add(&Event);
+		}
+	}
+	PendingEvents.Sort([](const FWFCGenerationEvent& A, const FWFCGenerationEvent& B)
+	{
+		return A.Sequence < B.Sequence;
+	});
+
+	for (const FWFCGenerationEvent* Event : PendingEvents)
+	{
+		if (Event->Sequence != NextGenerationEventSequence)
+		{
+			break;
+		}
+		ApplyGenerationEvent(*Event);
+		NextGenerationEventSequence++;
+	}
+}
+
+void UWFCSubsystem::ApplyGenerationEvent(const FWFCGenerationEvent& Event)
+{
+	if (Event.ModelHash != CompiledModel->ModelHash)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Generation event %d was solved with model %08x, the local model is %08x"), Event.Sequence, Event.ModelHash, CompiledModel->ModelHash);
+		NumDivergedChunks++;
+		return;
+	}
+
+	const FIntVector OriginCell = Event.bDeterministic ? GetChunkOriginCell(Event.Cell) : Event.Cell;
+	if (Chunks.Contains(OriginCell))
+	{
+		return;
+	}
+
+	// The recorded seed is the one of the successful attempt, a single try reproduces the server solve
+	if (Event.bDeterministic)
+	{
+		SpawnDeterministicChunk(Event.Cell, 1, Event.Seed);
+	}
+	else
+	{
+		OriginLocation = FVector(Event.Cell) * WFCModel->TileSize;
+		Solver.StarterOptions.Empty();
+		for (uint32 BoundaryCell : Event.BoundaryCells)
+		{
+			if (const FWaveFunctionCollapseOption* BoundaryOption = CompiledModel->GetOption(static_cast<uint16>(BoundaryCell & 0xFFFF)))
+			{
+				Solver.StarterOptions.Add(UWaveFunctionCollapseBPLibrary::IndexAsPosition(BoundaryCell >> 16, Solver.Resolution), *BoundaryOption);
+			}
+		}
+		GatherWindowDistrictIds(RelativeToAbsolute(FIntVector::ZeroValue - Solver.Resolution / 2, OriginLocation, WFCModel->TileSize), Solver.WindowDistrictIds);
+
+		int32 Seed = Event.Seed;
+		TArray<FWaveFunctionCollapseTile>& Tiles = Solver.SolveArena.Tiles;
+		if (Solver.SolveTiles(1, Seed, Tiles))
+		{
+			SpawnActorFromTiles(Tiles, Seed);
+		}
+	}
+
+	const FWFCChunk* Chunk = Chunks.Find(OriginCell);
+	if (!Chunk || FWFCGenerationEvent::GetChunkChecksum(*Chunk) != Event.Checksum)
+	{
+		NumDivergedChunks++;
+		UE_LOG(LogTemp, Error, TEXT("Replicated chunk %s diverged from the server solve (%d diverged chunks)"), *OriginCell.ToString(), NumDivergedChunks);
+	}
+}
+
+bool UWFCSubsystem::FindPlacedOption(const FIntVector& AbsoluteCell, FWaveFunctionCollapseOption& OutOption)
+{
+	if (const FWaveFunctionCollapseOption* PlacedOption = CompiledModel->GetOption(FindPlacedOptionId(AbsoluteCell)))
+	{
+		OutOption = *PlacedOption;
+		return true;
+	}
+	return false;
+}
+
+uint16 UWFCSubsystem::FindPlacedOptionId(const FIntVector& AbsoluteCell)
+{
+	const uint16 PlacedOptionId = PlacedTiles.Find(AbsoluteCell);
+	return PlacedOptionId != FWFCCompiledModel::InvalidOptionId ? PlacedOptionId : FindEvictedOptionId(AbsoluteCell);
+}
+
+uint16 UWFCSubsystem::FindEvictedOptionId(const FIntVector& AbsoluteCell)
+{
+	const TArray<FIntVector, TInlineAllocator<2>>* PageChunks = NumEvictedChunks > 0 ? ChunkCellPages.Find(GetChunkCellPage(AbsoluteCell)) : nullptr;
+	if (!PageChunks)
+	{
+		return FWFCCompiledModel::InvalidOptionId;
+	}
+
+	for (const FIntVector& OriginCell : *PageChunks)
+	{
+		FWFCChunk* Chunk = Chunks.Find(OriginCell);
+		if (!Chunk || Chunk->bResident || Chunk->GetCellIndex(AbsoluteCell) == INDEX_NONE)
+		{
+			continue;
+		}
+
+		// Evicted deterministic chunks only keep their seed, their tiles are derived again from the successful attempt
+		if (Chunk->bDeterministic && Chunk->OptionIds.IsEmpty())
+		{
+			EvictedChunkSolver.CopySettings(Solver);
+			int32 RecordedSeed = Chunk->Seed;
+			if (!SolveDeterministicChunk(FWFCChunkLattice{ EvictedChunkSolver, Chunks, WorldSeed }, GetChunkCoord(Chunk->MinCell), 1, RecordedSeed, Chunk->OptionIds))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not derive the tiles of evicted chunk %s with Seed Value: %d"), *OriginCell.ToString(), Chunk->Seed);
+				Chunk->OptionIds.Empty();
+				continue;
+			}
+		}
+
+		const uint16 OptionId = Chunk->GetOptionId(AbsoluteCell);
+		if (OptionId != FWFCCompiledModel::InvalidOptionId)
+		{
+			return OptionId;
+		}
+	}
+	return FWFCCompiledModel::InvalidOptionId;
+}
+
+void UWFCSubsystem::UpdateChunkResidency(const TArray<FVector>& ViewerLocations)
+{
+	if (!WFCModel || ViewerLocations.IsEmpty())
+	{
+		return;
+	}
+
+	const bool bUseRadius = ChunkEvictionRadius > 0.0f;
+	const double EvictionRadiusSquared = FMath::Square(ChunkEvictionRadius);
+	const double RematerializeRadiusSquared = FMath::Square(ChunkEvictionRadius * ChunkRematerializeRadiusRatio);
+	const int64 MemoryBudgetBytes = static_cast<int64>(ChunkMemoryBudgetMB * 1024.0 * 1024.0);
+
+	// Evict resident chunks out of range.  The kept chunks and the evicted chunks in range are only heapified, never sorted.
+	int64 ResidentBytes = 0;
+	TArray<TPair<double, FIntVector>> KeptChunks;
+	TArray<FIntVector> OutOfRangeChunks;
+	RematerializationQueue.Reset();
+	for (const TPair<FIntVector, FWFCChunk>& ChunkPair : Chunks)
+	{
+		const FVector ChunkCenter = (FVector(ChunkPair.Key) + FVector(0.5)) * WFCModel->TileSize;
+		double MinDistanceSquared = TNumericLimits<double>::Max();
+		for (const FVector& ViewerLocation : ViewerLocations)
+		{
+			MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared2D(ChunkCenter, ViewerLocation));
+		}
+
+		if (!ChunkPair.Value.bResident)
+		{
+			if (!bUseRadius || MinDistanceSquared <= RematerializeRadiusSquared)
+			{
+				RematerializationQueue.Emplace(MinDistanceSquared, ChunkPair.Key);
+			}
+		}
+		else if (bUseRadius && MinDistanceSquared > EvictionRadiusSquared)
+		{
+			OutOfRangeChunks.Add(ChunkPair.Key);
+		}
+		else
+		{
+			ResidentBytes += ChunkPair.Value.ResidentMemoryBytes;
+			KeptChunks.Emplace(MinDistanceSquared, ChunkPair.Key);
+		}
+	}
+	for (const FIntVector& OriginCell : OutOfRangeChunks)
+	{
+		EvictChunk(OriginCell);
+	}
+
+	// Evict the farthest resident chunks while above the memory budget
+	if (MemoryBudgetBytes > 0 && ResidentBytes > MemoryBudgetBytes)
+	{
+		auto FartherFirst = [](const TPair<double, FIntVector>& A, const TPair<double, FIntVector>& B) { return A.Key > B.Key; };
+		KeptChunks.Heapify(FartherFirst);
+		while (ResidentBytes > MemoryBudgetBytes && !KeptChunks.IsEmpty())
+		{
+			TPair<double, FIntVector> FarthestChunk;
+			KeptChunks.HeapPop(FarthestChunk, FartherFirst);
+			ResidentBytes -= Chunks[FarthestChunk.Value].ResidentMemoryBytes;
+			EvictChunk(FarthestChunk.Value);
+		}
+	}
+
+	// Evicted chunks back in range are re-materialized nearest first by the next ticks
+	RematerializationQueue.Heapify([](const TPair<double, FIntVector>& A, const TPair<double, FIntVector>& B) { return A.Key < B.Key; });
+	QueuedResidentBytes = ResidentBytes;
+}
+
+void UWFCSubsystem::RematerializeQueuedChunks(int32 MaxChunks)
+{
+	const int64 MemoryBudgetBytes = static_cast<int64>(ChunkMemoryBudgetMB * 1024.0 * 1024.0);
+	auto NearerFirst = [](const TPair<double, FIntVector>& A, const TPair<double, FIntVector>& B) { return A.Key < B.Key; };
+	int32 NumRematerialized = 0;
+	while (NumRematerialized < MaxChunks && !RematerializationQueue.IsEmpty())
+	{
+		// Chunks evicted or re-materialized since the update are skipped, the queue stops at the first chunk over the budget
+		const FWFCChunk* Chunk = Chunks.Find(RematerializationQueue.HeapTop().Value);
+		if (Chunk && !Chunk->bResident && MemoryBudgetBytes > 0 && QueuedResidentBytes + Chunk->ResidentMemoryBytes > MemoryBudgetBytes)
+		{
+			RematerializationQueue.Reset();
+			break;
+		}
+
+		TPair<double, FIntVector> NearestChunk;
+		RematerializationQueue.HeapPop(NearestChunk, NearerFirst);
+		if (!Chunk || Chunk->bResident)
+		{
+			continue;
+		}
+		RematerializeChunk(NearestChunk.Value);
+		QueuedResidentBytes += Chunks[NearestChunk.Value].ResidentMemoryBytes;
+		NumRematerialized++;
+	}
+}
+
+bool UWFCSubsystem::EvictChunk(FIntVector OriginCell)
+{
+	FWFCChunk* Chunk = Chunks.Find(OriginCell);
+	if (!Chunk || !Chunk->bResident)
+	{
+		return false;
+	}
+
+	for (const TWeakObjectPtr<AActor>& TileActor : Chunk->TileActors)
+	{
+		if (TileActor.IsValid())
+		{
+			TileActor->Destroy();
+		}
+	}
+	Chunk->TileActors.Empty();
+	if (Chunk->Actor.IsValid())
+	{
+		Chunk->Actor->Destroy();
+	}
+	Chunk->Actor.Reset();
+	SpawnedActors.Remove(FVector(OriginCell) * WFCModel->TileSize);
+	ReleaseChunkProxy(*Chunk);
+
+	// Keep the option IDs in the record only
+	for (int32 CellIndex = 0; CellIndex < Chunk->OptionIds.Num(); CellIndex++)
+	{
+		if (Chunk->OptionIds[CellIndex] != FWFCCompiledModel::InvalidOptionId)
+		{
+			PlacedTiles.Remove(Chunk->GetCellPosition(CellIndex));
+		}
+	}
+	if (bPublishPlacedTiles)
+	{
+		PlacedTilesPublisher.Publish(PlacedTiles, CompiledModel, Chunk->MinCell, Chunk->MinCell + Chunk->Size - FIntVector(1));
+	}
+
+	// Deterministic chunks only keep their seed, their tiles are solved again when re-materialized
+	if (Chunk->bDeterministic)
+	{
+		Chunk->OptionIds.Empty();
+	}
+
+	Chunk->bResident = false;
+	Chunk->bCollisionEnabled = false;
+	NumEvictedChunks++;
+	return true;
+}
+
+AActor* UWFCSubsystem::RematerializeChunk(FIntVector OriginCell)
+{
+	FWFCChunk* Chunk = Chunks.Find(OriginCell);
+	if (!Chunk)
+	{
+		return nullptr;
+	}
+	if (Chunk->bResident)
+	{
+		return Chunk->Actor.Get();
+	}
+
+	if (Chunk->bDeterministic && Chunk->OptionIds.IsEmpty())
+	{
+		// The record keeps the seed of the successful attempt
+		int32 RecordedSeed = Chunk->Seed;
+		if (!SolveDeterministicChunk(GetCityLattice(), GetChunkCoord(Chunk->MinCell), 1, RecordedSeed, Chunk->OptionIds))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not regenerate chunk %s with Seed Value: %d"), *OriginCell.ToString(), Chunk->Seed);
+			return nullptr;
+		}
+	}
+
+	NumEvictedChunks--;
+	return SpawnChunk(*Chunk);
+}
+
+int64 UWFCSubsystem::GetResidentChunkMemoryBytes() const
+{
+	int64 ResidentBytes = 0;
+	for (const TPair<FIntVector, FWFCChunk>& ChunkPair : Chunks)
+	{
+		if (ChunkPair.Value.bResident)
+		{
+			ResidentBytes += ChunkPair.Value.ResidentMemoryBytes;
+		}
+	}
+	return ResidentBytes;
+}
+
+void UWFCSubsystem::LogChunkMemoryReport() const
+{
+	int64 ResidentBytes = 0;
+	int64 RecordBytes = 0;
+	int32 NumResidentChunks = 0;
+	for (const TPair<FIntVector, FWFCChunk>& ChunkPair : Chunks)
+	{
+		const FWFCChunk& Chunk = ChunkPair.Value;
+		int32 NumTiles = 0;
+		for (uint16 OptionId : Chunk.OptionIds)
+		{
+			NumTiles += OptionId != FWFCCompiledModel::InvalidOptionId ? 1 : 0;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Chunk %s: %s, %d tiles, seed %d, resident %.1f KB, record %.1f KB"),
+			*Chunk.OriginCell.ToString(),
+			Chunk.bResident ? TEXT("resident") : TEXT("evicted"),
+			NumTiles,
+			Chunk.Seed,
+			Chunk.bResident ? Chunk.ResidentMemoryBytes / 1024.0 : 0.0,
+			Chunk.GetRecordMemoryBytes() / 1024.0);
+
+		if (Chunk.bResident)
+		{
+			ResidentBytes += Chunk.ResidentMemoryBytes;
+			NumResidentChunks++;
+		}
+		RecordBytes += Chunk.GetRecordMemoryBytes();
+	}
+	UE_LOG(LogTemp, Display, TEXT("%d chunks, %d resident: resident %.2f MB, records %.2f MB, budget %.2f MB"),
+		Chunks.Num(), NumResidentChunks, ResidentBytes / (1024.0 * 1024.0), RecordBytes / (1024.0 * 1024.0), ChunkMemoryBudgetMB);
+	UE_LOG(LogTemp, Display, TEXT("%d placed tiles: %.2f MB"), PlacedTiles.Num(), PlacedTiles.GetAllocatedSize() / (1024.0 * 1024.0));
+	UE_LOG(LogTemp, Display, TEXT("%d provisional tiles: %.2f MB, adopted by %d solves, rejected by %d"),
+		ProvisionalTiles.Num(), ProvisionalTiles.GetAllocatedSize() / (1024.0 * 1024.0), Solver.NumProvisionalAdoptions, Solver.NumProvisionalRejections);
+	UE_LOG(LogTemp, Display, TEXT("Solve arena: %.2f MB"), Solver.SolveArena.GetAllocatedSize() / (1024.0 * 1024.0));
+	UE_LOG(LogTemp, Display, TEXT("Speculative solves: %d committed, %d dropped"), NumSpeculativeCommits, NumSpeculativeMisses);
+}
+
+void UWFCSubsystem::UpdateChunkCollision(const TArray<FVector>& InterestLocations)
+{
+	if (!WFCModel || CollisionRadius <= 0.0f)
+	{
+		return;
+	}
+
+	// Gather the chunks whose collision state has to change
+	TArray<TPair<double, FIntVector>> PendingChunks;
+	for (const TPair<FIntVector, FWFCChunk>& ChunkPair : Chunks)
+	{
+		const FWFCChunk& Chunk = ChunkPair.Value;
+		if (!Chunk.bResident)
+		{
+			continue;
+		}
+
+		const FBox ChunkBounds(FVector(Chunk.MinCell) * WFCModel->TileSize, FVector(Chunk.MinCell + Chunk.Size) * WFCModel->TileSize);
+		double MinDistanceSquared = TNumericLimits<double>::Max();
+		for (const FVector& InterestLocation : InterestLocations)
+		{
+			MinDistanceSquared = FMath::Min(MinDistanceSquared, ChunkBounds.ComputeSquaredDistanceToPoint(InterestLocation));
+		}
+
+		const float Radius = Chunk.bCollisionEnabled ? CollisionRadius * CollisionDisableRadiusRatio : CollisionRadius;
+		const bool bWantsCollision = MinDistanceSquared <= FMath::Square(Radius);
+		if (bWantsCollision != Chunk.bCollisionEnabled)
+		{
+			PendingChunks.Emplace(MinDistanceSquared, ChunkPair.Key);
+		}
+	}
+	if (PendingChunks.IsEmpty())
+	{
+		return;
+	}
+
+	// Nearest chunks first, so the budget goes to the collision most likely to be hit
+	PendingChunks.Sort([](const TPair<double, FIntVector>& A, const TPair<double, FIntVector>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (const TPair<double, FIntVector>& PendingChunk : PendingChunks)
+	{
+		FWFCChunk& Chunk = Chunks.FindChecked(PendingChunk.Value);
+		SetChunkCollisionEnabled(Chunk, !Chunk.bCollisionEnabled);
+		if ((FPlatformTime::Seconds() - StartTime) * 1000.0 >= CollisionBudgetMs)
+		{
+			break;
+		}
+	}
+}
+
+void UWFCSubsystem::SetChunkCollisionEnabled(FWFCChunk& Chunk, bool bEnabled)
+{
+	if (AActor* ChunkActor = Chunk.Actor.Get())
+	{
+		for (UActorComponent* Component : ChunkActor->GetComponents())
+		{
+			UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(Component);
+			if (PrimitiveComponent && PrimitiveComponent->ComponentHasTag(CollisionComponentTag))
+			{
+				PrimitiveComponent->SetCollisionEnabled(bEnabled ? ECollisionEnabled::QueryAndPhysics : ECollisionEnabled::NoCollision);
+			}
+		}
+	}
+	Chunk.bCollisionEnabled = bEnabled;
+}
+
+void UWFCSubsystem::RegisterCollisionInterest(AActor* Actor)
+{
+	if (Actor)
+	{
+		CollisionInterestActors.AddUnique(Actor);
+	}
+}
+
+void UWFCSubsystem::UnregisterCollisionInterest(AActor* Actor)
+{
+	CollisionInterestActors.RemoveAllSwap([Actor](const TWeakObjectPtr<AActor>& InterestActor)
+	{
+		return !InterestActor.IsValid() || InterestActor.Get() == Actor;
+	});
+}
+
+void UWFCSubsystem::Tick(float DeltaTime)
+{
+	PlacedTilesPublisher.FlushPending();
+
+	if (!PendingChunkProxies.IsEmpty())
+	{
+		FinishChunkProxies();
+	}
+
+	if (CollisionRadius > 0.0f)
+	{
+		UpdateChunkCollision(GetCollisionInterestLocations());
+	}
+
+	if (!RematerializationQueue.IsEmpty())
+	{
+		RematerializeQueuedChunks(MaxRematerializationsPerTick);
+	}
+
+	if (ChunkEvictionRadius <= 0.0f && ChunkMemoryBudgetMB <= 0.0f)
+	{
+		return;
+	}
+	ChunkResidencyTimer += DeltaTime;
+	if (ChunkResidencyTimer < ChunkResidencyUpdateInterval)
+	{
+		return;
+	}
+	ChunkResidencyTimer = 0.0f;
+
+	UpdateChunkResidency(GetViewerLocations());
+}
+
+TArray<FVector> UWFCSubsystem::GetViewerLocations() const
+{
+	TArray<FVector> ViewerLocations;
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr)
+		{
+			ViewerLocations.Add(Pawn->GetActorLocation());
+		}
+	}
+	return ViewerLocations;
+}
+
+TArray<FVector> UWFCSubsystem::GetCollisionInterestLocations() const
+{
+	TArray<FVector> InterestLocations = GetViewerLocations();
+	for (const TWeakObjectPtr<AActor>& InterestActor : CollisionInterestActors)
+	{
+		if (const AActor* Actor = InterestActor.Get())
+		{
+			InterestLocations.Add(Actor->GetActorLocation());
+			InterestLocations.Add(Actor->GetActorLocation() + Actor->GetVelocity() * CollisionLookaheadTime);
+		}
+	}
+	return InterestLocations;
+}
+
+bool UWFCSubsystem::SaveCity(const FString& SlotName)
+{
+	if (!CompiledModel->IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid WFC Model"));
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FString Filename = FWFCCitySnapshot::GetSlotFilename(SlotName);
+	if (!FWFCCitySnapshot::Save(Filename, *CompiledModel, Solver.Resolution, Chunks, WorldSeed))
+	{
+		return false;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Saved %d chunks to %s in %.2f ms"), Chunks.Num(), *Filename, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	return true;
+}
+
+bool UWFCSubsystem::LoadCity(const FString& SlotName)
+{
+	if (!WFCModel)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid WFC Model"));
+		return false;
+	}
+	if (!CompiledModel->IsValid())
+	{
+		CompileModel();
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FString Filename = FWFCCitySnapshot::GetSlotFilename(SlotName);
+	TArray<FWFCChunk> LoadedChunks;
+	if (!FWFCCitySnapshot::Load(Filename, *CompiledModel, Solver.Resolution, LoadedChunks, WorldSeed))
+	{
+		return false;
+	}
+	const double ParseTime = FPlatformTime::Seconds();
+
+	// Every loaded chunk starts as an evicted record
+	ClearCity();
+	Chunks.Reserve(LoadedChunks.Num());
+	for (FWFCChunk& LoadedChunk : LoadedChunks)
+	{
+		LoadedChunk.bResident = false;
+		IndexChunkCells(Chunks.Add(LoadedChunk.OriginCell, MoveTemp(LoadedChunk)));
+	}
+	NumEvictedChunks = Chunks.Num();
+
+	// Spawn the chunks in range right away, or all of them when eviction is disabled
+	if (ChunkEvictionRadius > 0.0f || ChunkMemoryBudgetMB > 0.0f)
+	{
+		UpdateChunkResidency(GetViewerLocations());
+		RematerializeQueuedChunks(MAX_int32);
+	}
+	else
+	{
+		TArray<FIntVector> OriginCells;
+		Chunks.GetKeys(OriginCells);
+		for (const FIntVector& OriginCell : OriginCells)
+		{
+			RematerializeChunk(OriginCell);
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Loaded %d chunks from %s: parse %.2f ms, spawn %.2f ms"), Chunks.Num(), *Filename,
+		(ParseTime - StartTime) * 1000.0, (FPlatformTime::Seconds() - ParseTime) * 1000.0);
+	return true;
+}
+
+void UWFCSubsystem::StartJournal()
+{
+	Journal = FWFCSessionJournal();
+	Journal.WorldSeed = WorldSeed;
+	Journal.SolverSettingsHash = Solver.GetSolverSettingsHash();
+	Journal.NumChunksAtStart = Chunks.Num();
+	JournalStartTime = FPlatformTime::Seconds();
+	bRecordingJournal = true;
+	UE_LOG(LogTemp, Display, TEXT("Recording session journal, %d chunks already generated"), Journal.NumChunksAtStart);
+}
+
+bool UWFCSubsystem::StopJournal(const FString& SlotName)
+{
+	if (!bRecordingJournal)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No session journal is being recorded"));
+		return false;
+	}
+	bRecordingJournal = false;
+
+	const FString Filename = FWFCSessionJournal::GetSlotFilename(SlotName);
+	if (!Journal.Save(Filename))
+	{
+		return false;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Saved %d generation requests to %s"), Journal.Entries.Num(), *Filename);
+	Journal.Entries.Empty();
+	return true;
+}
+
+bool UWFCSubsystem::ReplayJournal(const FString& SlotName)
+{
+	if (!WFCModel)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid WFC Model"));
+		return false;
+	}
+	if (!CompiledModel->IsValid())
+	{
+		CompileModel();
+	}
+	if (bRecordingJournal)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Stop recording the session journal before replaying one"));
+		return false;
+	}
+
+	FWFCSessionJournal ReplayedJournal;
+	const FString Filename = FWFCSessionJournal::GetSlotFilename(SlotName);
+	if (!ReplayedJournal.Load(Filename))
+	{
+		return false;
+	}
+	if (ReplayedJournal.NumChunksAtStart > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Journal was recorded on a city of %d chunks, the replay starts from an empty city and may solve other windows"), ReplayedJournal.NumChunksAtStart);
+	}
+	if (ReplayedJournal.SolverSettingsHash != Solver.GetSolverSettingsHash())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Journal was recorded with other solver settings, solves may differ"));
+	}
+
+	// Every request runs with its recorded window and seed on a city built by the requests before it
+	ClearCity();
+	TGuardValue<int32> WorldSeedGuard(WorldSeed, ReplayedJournal.WorldSeed);
+	TGuardValue<FVector> OriginLocationGuard(OriginLocation, OriginLocation);
+	TGuardValue<FIntVector> ResolutionGuard(Solver.Resolution, Solver.Resolution);
+	TGuardValue<bool> DeterministicGenerationGuard(bDeterministicGeneration, bDeterministicGeneration);
+
+	UE_LOG(LogTemp, Display, TEXT("Replaying %d generation requests from %s"), ReplayedJournal.Entries.Num(), *Filename);
+	TArray<double> RequestMs;
+	RequestMs.Reserve(ReplayedJournal.Entries.Num());
+	int32 NumSkippedRequests = 0;
+	int32 NumEmptyRequests = 0;
+	for (int32 EntryIndex = 0; EntryIndex < ReplayedJournal.Entries.Num(); EntryIndex++)
+	{
+		const FWFCJournalEntry& Entry = ReplayedJournal.Entries[EntryIndex];
+		if (Entry.ModelHash != CompiledModel->ModelHash)
+		{
+			NumSkippedRequests++;
+			continue;
+		}
+
+		OriginLocation = Entry.OriginLocation;
+		Solver.Resolution = Entry.Resolution;
+		bDeterministicGeneration = Entry.bDeterministic;
+		const double RequestStartTime = FPlatformTime::Seconds();
+		const AActor* SpawnedActor = Collapse(Entry.TryCount, Entry.Seed);
+		RequestMs.Add((FPlatformTime::Seconds() - RequestStartTime) * 1000.0);
+		NumEmptyRequests += SpawnedActor ? 0 : 1;
+		UE_LOG(LogTemp, Display, TEXT("  #%d at %.2f s, %s: %.3f ms%s"), EntryIndex, Entry.Time, *Entry.OriginLocation.ToString(), RequestMs.Last(), SpawnedActor ? TEXT("") : TEXT(", nothing spawned"));
+	}
+	if (NumSkippedRequests > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Skipped %d requests recorded with another model"), NumSkippedRequests);
+	}
+	if (RequestMs.IsEmpty())
+	{
+		return false;
+	}
+
+	double TotalMs = 0.0;
+	for (const double Ms : RequestMs)
+	{
+		TotalMs += Ms;
+	}
+	RequestMs.Sort();
+	auto Percentile = [&RequestMs](double Fraction) { return RequestMs[FMath::Min(FMath::FloorToInt32(Fraction * RequestMs.Num()), RequestMs.Num() - 1)]; };
+	UE_LOG(LogTemp, Display, TEXT("Replayed %d requests in %.2f ms, %d spawned nothing - mean %.3f ms, p50 %.3f ms, p95 %.3f ms, max %.3f ms"),
+		RequestMs.Num(), TotalMs, NumEmptyRequests, TotalMs / RequestMs.Num(), Percentile(0.5), Percentile(0.95), RequestMs.Last());
+	return true;
+}
+
+void UWFCSubsystem::ClearCity()
+{
+	{
+		TGuardValue<bool> PublishPlacedTilesGuard(bPublishPlacedTiles, false);
+		for (const TPair<FIntVector, FWFCChunk>& ChunkPair : Chunks)
+		{
+			EvictChunk(ChunkPair.Key);
+		}
+	}
+	Chunks.Empty();
+	PlacedTiles.Empty();
+	ProvisionalTiles.Empty();
+	SpawnedActors.Empty();
+	ChunkProxyMeshes.Empty();
+	ChunkProxyUsers.Empty();
+	ProxyGeometries.Empty();
+	ChunkCellPages.Empty();
+	RematerializationQueue.Empty();
+	QueuedResidentBytes = 0;
+	NumEvictedChunks = 0;
+	PlacedTilesPublisher.PublishEmpty(CompiledModel);
+}
+
+void UWFCSubsystem::Deinitialize()
+{
+	// A session recorded until the end of its world is saved under the time it ended
+	if (bRecordingJournal)
+	{
+		StopJournal(FString::Printf(TEXT("Session-%s"), *FDateTime::Now().ToString()));
+	}
+
+	// The speculative solve runs on the solver context of the subsystem, its last solve must not outlive it
+	if (SpeculativeSolve)
+	{
+		SpeculativeSolve->bCancelled = true;
+		SpeculativeSolve->Task.Wait();
+		SpeculativeSolve.Reset();
+		SpeculativeSolver.CancelSolve = nullptr;
+	}
+	Super::Deinitialize();
+}
+
+bool UWFCSubsystem::IsTickable() const
+{
+	return GetWorld() && (PlacedTilesPublisher.HasPending() || !RematerializationQueue.IsEmpty()
+		|| (!Chunks.IsEmpty() && (ChunkEvictionRadius > 0.0f || ChunkMemoryBudgetMB > 0.0f || CollisionRadius > 0.0f || !PendingChunkProxies.IsEmpty())));
+}
+
+TStatId UWFCSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UWFCSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UWFCSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UWFCSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+bool UWFCSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
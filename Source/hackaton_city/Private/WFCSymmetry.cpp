@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "hackaton_city/Public/WFCSymmetry.h"
+
+namespace
+{
+	int32 GetQuarterTurns(const FRotator& Rotator)
+	{
+		return ((FMath::RoundToInt32(Rotator.Yaw / 90.0) % 4) + 4) % 4;
+	}
+
+	// 0, 90, 180 and -90, the yaws the model data uses
+	double QuarterTurnsToYaw(int32 QuarterTurns)
+	{
+		return FRotator::NormalizeAxis(QuarterTurns * 90.0);
+	}
+
+	FWaveFunctionCollapseOption RotateOption(const FWaveFunctionCollapseOption& Option, int32 QuarterTurns, const TMap<FSoftObjectPath, EWFCTileSymmetry>& Symmetries)
+	{
+		const EWFCTileSymmetry* Symmetry = Symmetries.Find(Option.BaseObject);
+		if (!Symmetry)
+		{
+			return Option;
+		}
+
+		FWaveFunctionCollapseOption RotatedOption = Option;
+		RotatedOption.BaseRotator.Yaw = QuarterTurnsToYaw((GetQuarterTurns(Option.BaseRotator) + QuarterTurns) % FWFCSymmetry::GetNumVariants(*Symmetry));
+		return RotatedOption;
+	}
+}
+
+int32 FWFCSymmetry::GetNumVariants(EWFCTileSymmetry Symmetry)
+{
+	switch (Symmetry)
+	{
+	case EWFCTileSymmetry::X:
+		return 1;
+	case EWFCTileSymmetry::I:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+EWaveFunctionCollapseAdjacency FWFCSymmetry::RotateAdjacency(EWaveFunctionCollapseAdjacency Adjacency, int32 QuarterTurns)
+{
+	// +90 yaw turns +X (Front) towards +Y (Right)
+	static const EWaveFunctionCollapseAdjacency QuarterTurnCycle[] = {
+		EWaveFunctionCollapseAdjacency::Front,
+		EWaveFunctionCollapseAdjacency::Right,
+		EWaveFunctionCollapseAdjacency::Back,
+		EWaveFunctionCollapseAdjacency::Left
+	};
+
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(QuarterTurnCycle); Index++)
+	{
+		if (QuarterTurnCycle[Index] == Adjacency)
+		{
+			return QuarterTurnCycle[(Index + (QuarterTurns % 4 + 4)) % 4];
+		}
+	}
+	return Adjacency;
+}
+
+void FWFCSymmetry::ExpandTiles(const TArray<FWFCSymmetricTile>& Tiles, TMap<FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap>& OutConstraints)
+{
+	TMap<FSoftObjectPath, EWFCTileSymmetry> Symmetries;
+	for (const FWFCSymmetricTile& Tile : Tiles)
+	{
+		Symmetries.Add(Tile.BaseObject, Tile.Symmetry);
+	}
+
+	OutConstraints.Reserve(OutConstraints.Num() + Tiles.Num() * 4);
+	for (const FWFCSymmetricTile& Tile : Tiles)
+	{
+		for (int32 QuarterTurns = 0; QuarterTurns < GetNumVariants(Tile.Symmetry); QuarterTurns++)
+		{
+			FWaveFunctionCollapseOption Variant;
+			Variant.BaseObject = Tile.BaseObject;
+			Variant.BaseRotator.Yaw = QuarterTurnsToYaw(QuarterTurns);
+
+			FWaveFunctionCollapseAdjacencyToOptionsMap& VariantConstraint = OutConstraints.FindOrAdd(Variant);
+			VariantConstraint.Weight = Tile.Weight;
+			for (const TPair<EWaveFunctionCollapseAdjacency, FWaveFunctionCollapseOptions>& Adjacency : Tile.AdjacencyToOptionsMap)
+			{
+				FWaveFunctionCollapseOptions& RotatedOptions = VariantConstraint.AdjacencyToOptionsMap.FindOrAdd(RotateAdjacency(Adjacency.Key, QuarterTurns));
+				RotatedOptions.Options.Reserve(RotatedOptions.Options.Num() + Adjacency.Value.Options.Num());
+				for (const FWaveFunctionCollapseOption& AdjacentOption : Adjacency.Value.Options)
+				{
+					RotatedOptions.Options.AddUnique(RotateOption(AdjacentOption, QuarterTurns, Symmetries));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "WFCChunk.h"
+#include "WFCSolverContext.h"
+
+#include "WFCBakeCityCommandlet.generated.h"
+
+class UWaveFunctionCollapseModel;
+class UWFCSubsystem;
+
+/**
+ * Headless bake of a deterministic city into a World Partition map, each chunk saved as external actor packages
+ * that World Partition streams by cell.  Chunks are solved across all cores with one solver context per worker,
+ * in bands of lattice rows that are spawned, saved and unloaded before the next band, so memory stays bounded by the band.
+ *
+ * UnrealEditor-Cmd hackaton_city -run=WFCBakeCity -Map=/Game/Maps/City -Seed=1234 -Extent=64,64
+ *   -Map        World Partition map receiving the chunk actors
+ *   -Seed       WorldSeed of the lattice, the same city is generated at runtime with bDeterministicGeneration
+ *   -Extent     Amount of chunks along X and Y
+ *   -Origin     Lattice coordinates of the first chunk, 0,0 by default
+ *   -Model      WaveFunctionCollapse model, BaseModel of the developer settings by default
+ *   -DataLayer  Data layer asset the chunk actors are added to
+ *   -BandRows   Lattice rows per band, 4 by default
+ */
+UCLASS()
+class HACKATON_CITY_API UWFCBakeCityCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UWFCBakeCityCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/**
+	* Create the subsystem writing the chunks, configured from the developer settings, outside of the subsystem collection of the world
+	* @param World
+	* @param Model
+	* @param WorldSeed
+	*/
+	UWFCSubsystem* CreateWriter(UWorld* World, UWaveFunctionCollapseModel* Model, int32 WorldSeed) const;
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WFCCompiledModel.h"
+
+#include "WFCChunk.generated.h"
+
+/**
+ * Tiles placed by one successful solve, together with the actors spawned for them.
+ * An evicted chunk only keeps its compact record (seed and option IDs) and can be re-materialized from it.
+ */
+USTRUCT(BlueprintType)
+struct HACKATON_CITY_API FWFCChunk
+{
+	GENERATED_BODY()
+
+	// Absolute grid cell of the solve origin, also the key of the chunk
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCChunk")
+	FIntVector OriginCell = FIntVector::ZeroValue;
+
+	// Seed of the successful solve
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCChunk")
+	int32 Seed = 0;
+
+	// Absolute grid cell of the first cell covered by OptionIds
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCChunk")
+	FIntVector MinCell = FIntVector::ZeroValue;
+
+	// Amount of cells covered by OptionIds along each axis
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCChunk")
+	FIntVector Size = FIntVector::ZeroValue;
+
+	// Placed option ID per covered cell, InvalidOptionId for cells not owned by this chunk.
+	// Empty for an evicted deterministic chunk.
+	UPROPERTY()
+	TArray<uint16> OptionIds;
+
+	// Chunk lies on the deterministic lattice, its option IDs can be dropped and solved again from Seed
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCChunk")
+	bool bDeterministic = false;
+
+	// Geometry and actors are currently spawned
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCChunk")
+	bool bResident = false;
+
+	// Collision of the chunk components is enabled
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCChunk")
+	bool bCollisionEnabled = false;
+
+	// Actor holding the ISM Components of the chunk
+	UPROPERTY(VisibleAnywhere, Category = "WFCChunk")
+	TWeakObjectPtr<AActor> Actor;
+
+	// Tiles spawned as standalone actors
+	UPROPERTY(VisibleAnywhere, Category = "WFCChunk")
+	TArray<TWeakObjectPtr<AActor>> TileActors;
+
+	// Hash of the option layout, key of the proxy mesh of the chunk.  0 without a proxy.
+	uint32 ProxyLayoutHash = 0;
+
+	// Estimated memory of the spawned actors and their components, measured when the chunk was last materialized
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCChunk")
+	int64 ResidentMemoryBytes = 0;
+
+	/**
+	* Returns the index in OptionIds of an absolute grid cell, or INDEX_NONE if the cell is outside the chunk
+	* @param AbsoluteCell
+	*/
+	int32 GetCellIndex(const FIntVector& AbsoluteCell) const
+	{
+		const FIntVector Local = AbsoluteCell - MinCell;
+		if (Local.X < 0 || Local.Y < 0 || Local.Z < 0 || Local.X >= Size.X || Local.Y >= Size.Y || Local.Z >= Size.Z)
+		{
+			return INDEX_NONE;
+		}
+		return Local.X + Local.Y * Size.X + Local.Z * Size.X * Size.Y;
+	}
+
+	/**
+	* Returns the absolute grid cell of an index in OptionIds
+	* @param CellIndex
+	*/
+	FIntVector GetCellPosition(int32 CellIndex) const
+	{
+		return MinCell + FIntVector(CellIndex % Size.X, (CellIndex / Size.X) % Size.Y, CellIndex / (Size.X * Size.Y));
+	}
+
+	/**
+	* Returns the option ID placed by this chunk on an absolute grid cell, or InvalidOptionId
+	* @param AbsoluteCell
+	*/
+	uint16 GetOptionId(const FIntVector& AbsoluteCell) const
+	{
+		const int32 CellIndex = GetCellIndex(AbsoluteCell);
+		return OptionIds.IsValidIndex(CellIndex) ? OptionIds[CellIndex] : FWFCCompiledModel::InvalidOptionId;
+	}
+
+	// Memory kept by the compact record while the chunk is evicted
+	int64 GetRecordMemoryBytes() const
+	{
+		return sizeof(FWFCChunk) + OptionIds.GetAllocatedSize() + TileActors.GetAllocatedSize();
+	}
+};
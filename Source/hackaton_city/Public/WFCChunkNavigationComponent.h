@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+
+#include "WFCChunkNavigationComponent.generated.h"
+
+/**
+ * Single navigation element of a chunk.  The ISM Components of the chunk never affect navigation themselves,
+ * this component exports their colliding instances once the chunk is complete, so the navigation system gets one dirty area
+ * per spawned or evicted chunk instead of one per component, collision change or added instance.
+ * Independent of the chunk collision state, navigation is built as if the whole chunk collided.
+ */
+UCLASS(ClassGroup = (Custom))
+class HACKATON_CITY_API UWFCChunkNavigationComponent : public UPrimitiveComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWFCChunkNavigationComponent();
+
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+
+	virtual bool DoCustomNavigableGeometryExport(FNavigableGeometryExport& GeomExport) const override;
+};
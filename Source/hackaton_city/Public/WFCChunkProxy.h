@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MeshDescription.h"
+#include "WFCChunk.h"
+
+class UStaticMesh;
+
+/**
+ * Range of the indices of a proxy geometry drawn with one material of its mesh
+ */
+struct HACKATON_CITY_API FWFCProxySection
+{
+	int32 FirstIndex = 0;
+	int32 NumIndices = 0;
+
+	// Material of the source mesh slot, resolved on the game thread
+	FSoftObjectPath Material;
+};
+
+/**
+ * Triangles of one mesh as merged into chunk proxies, in mesh space.  Empty if the mesh cannot be merged.
+ */
+struct HACKATON_CITY_API FWFCProxyGeometry
+{
+	TArray<FVector3f> Positions;
+	TArray<uint32> Indices;
+	TArray<FWFCProxySection> Sections;
+};
+
+/**
+ * One mesh of a chunk with the transforms of all its instances, relative to the chunk location
+ */
+struct HACKATON_CITY_API FWFCProxyInstances
+{
+	TSharedPtr<const FWFCProxyGeometry> Geometry;
+	TArray<FTransform> Transforms;
+};
+
+/**
+ * Merged mesh of a chunk proxy, with the material of each of its polygon groups
+ */
+struct HACKATON_CITY_API FWFCProxyMesh
+{
+	FMeshDescription MeshDescription;
+
+	// Indexed by polygon group
+	TArray<FSoftObjectPath> Materials;
+};
+
+/**
+ * Merged low-poly stand-in for the ISM Components of a distant chunk, with one section per material of the merged meshes.
+ * Geometry is gathered on the game thread, merged into a mesh description on any thread,
+ * then built into a transient static mesh on the game thread.
+ */
+struct HACKATON_CITY_API FWFCChunkProxy
+{
+	// Material slots of proxy meshes are named after it, numbered by polygon group
+	static const FName MaterialSlotName;
+
+	/**
+	* Returns the name of the material slot of a polygon group of a proxy mesh
+	* @param MaterialIndex Index of the polygon group and of its material in FWFCProxyMesh::Materials
+	*/
+	static FName GetMaterialSlotName(int32 MaterialIndex);
+
+	/**
+	* Read the lowest LOD of a mesh with the material of each of its sections, or its bounding box when that LOD has too many triangles.
+	* Meshes without CPU-readable data, i.e. without bAllowCPUAccess in cooked builds, are left empty and not merged.
+	* @param StaticMesh
+	* @param MaxTriangles Triangle limit of the lowest LOD
+	* @param OutGeometry
+	*/
+	static void GatherMeshGeometry(const UStaticMesh* StaticMesh, int32 MaxTriangles, FWFCProxyGeometry& OutGeometry);
+
+	/**
+	* Merge every instance of every mesh into a mesh description with one polygon group per material.  Thread safe.
+	* @param Instances Meshes and their instance transforms
+	* @param OutProxyMesh
+	*/
+	static void BuildMeshDescription(const TArray<FWFCProxyInstances>& Instances, FWFCProxyMesh& OutProxyMesh);
+
+	/**
+	* Returns the hash of the option layout of a chunk.  Chunks with the same hash share their proxy mesh.
+	* @param Chunk
+	* @param ModelHash Hash of the model the option IDs refer to
+	* @param TileSize
+	*/
+	static uint32 GetLayoutHash(const FWFCChunk& Chunk, uint32 ModelHash, float TileSize);
+};
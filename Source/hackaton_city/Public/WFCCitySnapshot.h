@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WFCChunk.h"
+#include "WFCCompiledModel.h"
+
+/**
+ * Compact binary snapshot of a generated city.
+ * The file holds the option palette once, followed by the record of every chunk as a raw array of option IDs:
+ *   Header   Magic, Version, ModelHash, TileSize, Resolution, NumOptions, NumChunks, WorldSeed
+ *   Palette  BaseObject, BaseRotator, BaseScale3D per option
+ *   Chunks   OriginCell, Seed, MinCell, Size, bDeterministic, option IDs per chunk
+ * Deterministic chunks are stored without option IDs, they are solved again from their seed.
+ * Files of another version are rejected.
+ */
+struct HACKATON_CITY_API FWFCCitySnapshot
+{
+	static constexpr uint32 Magic = 0x43434657;
+	static constexpr uint32 Version = 1;
+
+	/**
+	* Returns the snapshot file of a save slot, under Saved/WFCCities
+	* @param SlotName
+	*/
+	static FString GetSlotFilename(const FString& SlotName);
+
+	/**
+	* Write the records of all chunks to a snapshot file
+	* @param Filename
+	* @param CompiledModel Model the option IDs of the chunks refer to
+	* @param Resolution Solve window the chunks were generated with
+	* @param Chunks Chunks to save, resident or evicted
+	* @param WorldSeed Seed the deterministic chunks were generated from
+	*/
+	static bool Save(const FString& Filename, const FWFCCompiledModel& CompiledModel, const FIntVector& Resolution, const TMap<FIntVector, FWFCChunk>& Chunks, int32 WorldSeed);
+
+	/**
+	* Read the chunk records of a snapshot file.  The file is memory-mapped when the platform allows it.
+	* Option IDs are remapped through the file palette when it does not match the compiled model.
+	* @param Filename
+	* @param CompiledModel Model the loaded option IDs should refer to
+	* @param Resolution Current solve window, files saved with another resolution are rejected
+	* @param OutChunks Loaded chunk records, all evicted
+	* @param OutWorldSeed Seed the deterministic chunks were generated from, only set on success
+	*/
+	static bool Load(const FString& Filename, const FWFCCompiledModel& CompiledModel, const FIntVector& Resolution, TArray<FWFCChunk>& OutChunks, int32& OutWorldSeed);
+};
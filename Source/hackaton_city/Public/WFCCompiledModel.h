@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WaveFunctionCollapseModel.h"
+
+/**
+ * Index based view of a WFC model.
+ * Every option of the model gets a stable option ID, so placed tiles can be stored as small integers
+ * instead of full FWaveFunctionCollapseOption structs.
+ */
+struct HACKATON_CITY_API FWFCCompiledModel
+{
+	// Option ID used for cells without a placed option
+	static constexpr uint16 InvalidOptionId = MAX_uint16;
+
+	// Amount of faces of a solve window, one per EWaveFunctionCollapseAdjacency
+	static constexpr int32 NumFaces = 6;
+
+	// Option palette, indexed by option ID
+	TArray<FWaveFunctionCollapseOption> Options;
+
+	// Reverse lookup from an option to its option ID
+	TMap<FWaveFunctionCollapseOption, uint16> OptionToId;
+
+	// Hash of the palette and constraints, stored alongside option IDs to detect a model change
+	uint32 ModelHash = 0;
+
+	float TileSize = 0.0f;
+
+	// Options allowed on the inner border of a solve window, by option ID, indexed by the adjacency from the outside to the border cell.
+	// Built from the constraints of BorderOption, empty for the faces it does not constrain.
+	TBitArray<> BorderMasks[NumFaces];
+
+	// Same from the constraints of EmptyOption, used on the faces left unconstrained by BorderMasks when the border is empty space
+	TBitArray<> EmptyBorderMasks[NumFaces];
+
+	// 64-bit words of an option mask, rounded up to 1, 2 or 4 for the fixed-width propagation kernels of up to 256 options
+	int32 NumMaskWords = 0;
+
+	// Options allowed next to each option as mask words, NumMaskWords per option ID and face
+	TArray<uint64> AdjacencyMasks;
+
+	// Weight of each option and its Weight * log(Weight), indexed by option ID.  0 for options without constraints.
+	TArray<float> Weights;
+	TArray<float> WeightLogWeights;
+
+	// Options of the initial tile, the constraint keys but BorderOption in the order of the model
+	TArray<uint16> InitialOptionIds;
+
+	// Objects of the SpawnExclusion list of the model
+	TSet<FSoftObjectPath> SpawnExclusion;
+
+	/**
+	* Build the palette from a model.  Options are sorted so the same model always yields the same IDs.
+	* @param Model Model to compile
+	*/
+	void Compile(const UWaveFunctionCollapseModel* Model);
+
+	/**
+	* Compile a model and share the result with every solver context of the process.
+	* Returns the instance already shared by another world when the compiled model hash matches, so its palette is held only once.
+	* Shared models are immutable.
+	* @param Model Model to compile
+	*/
+	static TSharedRef<const FWFCCompiledModel> CompileShared(const UWaveFunctionCollapseModel* Model);
+
+	/**
+	* Returns the option ID of an option, or InvalidOptionId if the option is not part of the model
+	* @param Option
+	*/
+	uint16 FindOptionId(const FWaveFunctionCollapseOption& Option) const;
+
+	/**
+	* Returns the option of an option ID, or nullptr for InvalidOptionId
+	* @param OptionId
+	*/
+	const FWaveFunctionCollapseOption* GetOption(uint16 OptionId) const;
+
+	/**
+	* Returns the Shannon entropy of a tile from the compiled weights, same formula as UWaveFunctionCollapseBPLibrary::CalculateShannonEntropy.
+	* Returns -1 for options without weight.
+	* @param TileOptions Remaining options of the tile
+	*/
+	float CalculateShannonEntropy(const TArray<FWaveFunctionCollapseOption>& TileOptions) const;
+
+	/**
+	* Returns the Shannon entropy of a tile from the option IDs of its remaining options, InvalidOptionId entries are skipped
+	* @param TileOptionIds
+	*/
+	float CalculateShannonEntropy(TConstArrayView<uint16> TileOptionIds) const;
+
+	/**
+	* Returns the weight of an option, or 0 for InvalidOptionId
+	* @param OptionId
+	*/
+	float GetWeight(uint16 OptionId) const { return Weights.IsValidIndex(OptionId) ? Weights[OptionId] : 0.0f; }
+
+	/**
+	* Returns false for empty and void options and for objects in the SpawnExclusion list
+	* @param BaseObject
+	*/
+	bool IsObjectSpawnable(const FSoftObjectPath& BaseObject) const;
+
+	/**
+	* Returns the NumMaskWords words of the options allowed next to an option
+	* @param OptionId
+	* @param Face Adjacency from the option to its neighbor
+	*/
+	const uint64* GetAdjacencyMask(uint16 OptionId, int32 Face) const { return &AdjacencyMasks[(static_cast<int32>(OptionId) * NumFaces + Face) * NumMaskWords]; }
+
+	int32 NumOptions() const { return Options.Num(); }
+
+	bool IsValid() const { return !Options.IsEmpty(); }
+};
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WFCCompiledModel.h"
+
+/**
+ * Option ID placed on every resident grid cell.
+ * Cells are stored in pages of PageSize x PageSize cells, so a placed cell costs 2 bytes instead of a full option and a map entry.
+ * The full option is only materialized through FWFCCompiledModel::GetOption when needed.
+ */
+struct HACKATON_CITY_API FWFCPlacedTiles
+{
+	static constexpr int32 PageSize = 16;
+
+	/**
+	* Place an option ID on an absolute grid cell, replacing the previous one
+	* @param AbsoluteCell
+	* @param OptionId Must not be InvalidOptionId
+	*/
+	void Add(const FIntVector& AbsoluteCell, uint16 OptionId);
+
+	/**
+	* Clear an absolute grid cell.  Returns false if nothing was placed on it.
+	* @param AbsoluteCell
+	*/
+	bool Remove(const FIntVector& AbsoluteCell);
+
+	/**
+	* Returns the option ID placed on an absolute grid cell, or InvalidOptionId
+	* @param AbsoluteCell
+	*/
+	uint16 Find(const FIntVector& AbsoluteCell) const;
+
+	bool Contains(const FIntVector& AbsoluteCell) const { return Find(AbsoluteCell) != FWFCCompiledModel::InvalidOptionId; }
+
+	int32 Num() const { return NumCells; }
+
+	void Empty();
+
+	// Memory held by the pages
+	SIZE_T GetAllocatedSize() const;
+
+	/**
+	* Returns the PageSize x PageSize option IDs of a page, or nullptr when nothing is placed in it
+	* @param PageCoord
+	*/
+	const uint16* FindPage(const FIntVector& PageCoord) const;
+
+	static FIntVector GetPageCoord(const FIntVector& AbsoluteCell);
+	static int32 GetPageCellIndex(const FIntVector& AbsoluteCell, const FIntVector& PageCoord);
+
+private:
+	struct FPage
+	{
+		uint16 OptionIds[PageSize * PageSize];
+		int32 NumCells = 0;
+	};
+
+	TMap<FIntVector, FPage> Pages;
+	int32 NumCells = 0;
+};
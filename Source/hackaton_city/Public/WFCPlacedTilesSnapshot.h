@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "WFCCompiledModel.h"
+#include "WFCPlacedTiles.h"
+#include <atomic>
+
+/**
+ * Immutable copy of the placed tiles at one version, safe to read from any thread for as long as it is held.
+ * Pages no chunk touched between two versions are shared by both snapshots.
+ */
+class HACKATON_CITY_API FWFCPlacedTilesSnapshot
+{
+public:
+	using FPage = TStaticArray<uint16, FWFCPlacedTiles::PageSize * FWFCPlacedTiles::PageSize>;
+
+	/**
+	* Returns the option ID placed on an absolute grid cell at this version, or InvalidOptionId
+	* @param AbsoluteCell
+	*/
+	uint16 Find(const FIntVector& AbsoluteCell) const;
+
+	/**
+	* Returns the option placed on an absolute grid cell at this version, or nullptr
+	* @param AbsoluteCell
+	*/
+	const FWaveFunctionCollapseOption* FindOption(const FIntVector& AbsoluteCell) const { return CompiledModel->GetOption(Find(AbsoluteCell)); }
+
+	// Increases by one with every published chunk
+	uint64 GetVersion() const { return Version; }
+
+	// Model the option IDs refer to
+	const FWFCCompiledModel& GetCompiledModel() const { return *CompiledModel; }
+
+private:
+	friend class FWFCPlacedTilesPublisher;
+
+	FWFCPlacedTilesSnapshot(uint64 InVersion, const TSharedRef<const FWFCCompiledModel>& InCompiledModel)
+		: Version(InVersion)
+		, CompiledModel(InCompiledModel)
+	{
+	}
+
+	uint64 Version;
+	TSharedRef<const FWFCCompiledModel> CompiledModel;
+	TMap<FIntVector, TSharedRef<const FPage>> Pages;
+};
+
+/**
+ * Publishes a new FWFCPlacedTilesSnapshot whenever a chunk changes the placed tiles.  Single writer, any amount of readers.
+ * Published snapshots rotate through a few slots.  Readers register in the current slot with an atomic counter and copy its
+ * snapshot pointer.  The writer never waits: it only rewrites a slot no reader is registered in, and a reader that loses the
+ * race with a publication retries on the newer slot.
+ */
+class HACKATON_CITY_API FWFCPlacedTilesPublisher
+{
+public:
+	static constexpr int32 NumSlots = 4;
+
+	/**
+	* Publish the next version after a change of the placed tiles within a box of cells.  Game thread.
+	* Pages outside of the box are shared with the previous version, the map of pages is copied.
+	* @param PlacedTiles Placed tiles after the change
+	* @param CompiledModel Model the option IDs refer to
+	* @param MinCell First changed cell
+	* @param MaxCell Last changed cell
+	*/
+	void Publish(const FWFCPlacedTiles& PlacedTiles, const TSharedRef<const FWFCCompiledModel>& CompiledModel, const FIntVector& MinCell, const FIntVector& MaxCell);
+
+	/**
+	* Publish an empty version, e.g. once the city is cleared.  Game thread.
+	* @param CompiledModel
+	*/
+	void PublishEmpty(const TSharedRef<const FWFCCompiledModel>& CompiledModel);
+
+	/**
+	* Store the latest version if every free slot was busy when it was published.  Game thread.
+	*/
+	void FlushPending();
+
+	bool HasPending() const { return bPending; }
+
+	/**
+	* Returns the latest stored snapshot, or null before the first publication.  Lock-free, any thread.
+	*/
+	TSharedPtr<const FWFCPlacedTilesSnapshot> Acquire() const;
+
+private:
+	struct FSlot
+	{
+		TSharedPtr<const FWFCPlacedTilesSnapshot> Snapshot;
+
+		// Version of Snapshot, 0 while the writer owns the slot
+		std::atomic<uint64> Version = 0;
+
+		std::atomic<int32> NumReaders = 0;
+	};
+
+	void Store();
+
+	mutable FSlot Slots[NumSlots];
+	std::atomic<int32> CurrentSlot = INDEX_NONE;
+
+	// Writer only: latest version, stored or pending
+	TSharedPtr<const FWFCPlacedTilesSnapshot> Latest;
+	uint64 LatestVersion = 0;
+	bool bPending = false;
+};
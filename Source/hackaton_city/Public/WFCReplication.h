@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "WFCChunk.h"
+
+#include "WFCReplication.generated.h"
+
+class AWFCGenerationReplicator;
+
+/**
+ * Everything a client needs to solve a chunk exactly as the server did, instead of its actors and instances
+ */
+USTRUCT()
+struct HACKATON_CITY_API FWFCGenerationEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	// Order in which the server generated the chunks, clients apply events in this order
+	UPROPERTY()
+	int32 Sequence = 0;
+
+	// Lattice coordinates of a deterministic chunk, or solve origin cell of any other chunk
+	UPROPERTY()
+	FIntVector Cell = FIntVector::ZeroValue;
+
+	// Seed of the successful solve
+	UPROPERTY()
+	int32 Seed = 0;
+
+	UPROPERTY()
+	uint32 ModelHash = 0;
+
+	// (window cell index << 16) | option ID of every starter cell of the solve.  Empty for deterministic chunks.
+	UPROPERTY()
+	TArray<uint32> BoundaryCells;
+
+	// Checksum of the option IDs of the solved chunk, compared by clients to detect divergence
+	UPROPERTY()
+	uint32 Checksum = 0;
+
+	UPROPERTY()
+	bool bDeterministic = false;
+
+	/**
+	* Returns the checksum of the option IDs of a chunk
+	* @param Chunk
+	*/
+	static uint32 GetChunkChecksum(const FWFCChunk& Chunk);
+};
+
+/**
+ * Generation events of a world, delta replicated as they are added
+ */
+USTRUCT()
+struct HACKATON_CITY_API FWFCGenerationEventArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FWFCGenerationEvent> Events;
+
+	// Actor replicating the array, notified when events arrive
+	AWFCGenerationReplicator* Owner = nullptr;
+
+	void PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FWFCGenerationEvent, FWFCGenerationEventArray>(Events, DeltaParams, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FWFCGenerationEventArray> : public TStructOpsTypeTraitsBase2<FWFCGenerationEventArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Always relevant actor spawned by the server's UWFCSubsystem to replicate its generation events.
+ * Clients hand the events to their own UWFCSubsystem, which solves the chunks again with the recorded seeds.
+ */
+UCLASS(NotBlueprintable)
+class HACKATON_CITY_API AWFCGenerationReplicator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AWFCGenerationReplicator();
+
+	virtual void BeginPlay() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/**
+	* Append an event and mark it for replication.  Server only.
+	* @param Event
+	*/
+	void AddEvent(FWFCGenerationEvent&& Event);
+
+	const TArray<FWFCGenerationEvent>& GetEvents() const { return Events.Events; }
+
+	/**
+	* Forward newly replicated events to the UWFCSubsystem of the world
+	*/
+	void OnEventsReplicated();
+
+private:
+	UPROPERTY(Replicated)
+	FWFCGenerationEventArray Events;
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * One generation request as received by UWFCSubsystem::Collapse
+ */
+struct HACKATON_CITY_API FWFCJournalEntry
+{
+	// Seconds since the journal started
+	double Time = 0.0;
+
+	FVector OriginLocation = FVector::ZeroVector;
+
+	FIntVector Resolution = FIntVector::ZeroValue;
+
+	int32 TryCount = 1;
+
+	// Seed of the first attempt, random seeds included once drawn
+	int32 Seed = 0;
+
+	uint32 ModelHash = 0;
+
+	bool bDeterministic = false;
+
+	friend FArchive& operator<<(FArchive& Ar, FWFCJournalEntry& Entry)
+	{
+		return Ar << Entry.Time << Entry.OriginLocation << Entry.Resolution << Entry.TryCount << Entry.Seed << Entry.ModelHash << Entry.bDeterministic;
+	}
+};
+
+/**
+ * Compact binary journal of the generation requests of a session, replayed by UWFCSubsystem::ReplayJournal:
+ *   Header   Magic, Version, WorldSeed, SolverSettingsHash, NumChunksAtStart, NumEntries
+ *   Entries  Time, OriginLocation, Resolution, TryCount, Seed, ModelHash, bDeterministic per request
+ * Requests only depend on the tiles placed by the earlier requests, so a journal started on an empty city replays exactly.
+ */
+struct HACKATON_CITY_API FWFCSessionJournal
+{
+	static constexpr uint32 Magic = 0x4A434657;
+	static constexpr uint32 Version = 1;
+
+	int32 WorldSeed = 0;
+
+	// FWFCSolverContext::GetSolverSettingsHash of the world when recording started
+	uint32 SolverSettingsHash = 0;
+
+	// Chunks of the city when recording started, replays start from an empty city
+	int32 NumChunksAtStart = 0;
+
+	TArray<FWFCJournalEntry> Entries;
+
+	/**
+	* Returns the journal file of a save slot, under Saved/WFCJournals
+	* @param SlotName
+	*/
+	static FString GetSlotFilename(const FString& SlotName);
+
+	bool Save(const FString& Filename) const;
+
+	bool Load(const FString& Filename);
+};
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+
+/**
+ * Inputs of a solve that fully determine its result: model, window, starting seed and boundary cells
+ */
+struct HACKATON_CITY_API FWFCBoundarySignature
+{
+	uint32 ModelHash = 0;
+	FIntVector Resolution = FIntVector::ZeroValue;
+	int32 Seed = 0;
+	int32 TryCount = 0;
+
+	// Hash of the subsystem settings that change solve results, such as the border and observation heuristic
+	uint32 SolverSettingsHash = 0;
+
+	// (window cell index << 16) | option ID of every starter cell, sorted by window cell index
+	TArray<uint32> BoundaryCells;
+
+	// District option ID of every window cell, empty without a district model
+	TArray<uint16> DistrictIds;
+
+	uint32 Hash = 0;
+
+	/**
+	* Sort the boundary cells and compute Hash.  Call once all fields are set.
+	*/
+	void Finalize();
+
+	bool operator==(const FWFCBoundarySignature& Other) const
+	{
+		return Hash == Other.Hash
+			&& ModelHash == Other.ModelHash
+			&& Resolution == Other.Resolution
+			&& Seed == Other.Seed
+			&& TryCount == Other.TryCount
+			&& SolverSettingsHash == Other.SolverSettingsHash
+			&& BoundaryCells == Other.BoundaryCells
+			&& DistrictIds == Other.DistrictIds;
+	}
+
+	friend uint32 GetTypeHash(const FWFCBoundarySignature& Signature) { return Signature.Hash; }
+};
+
+/**
+ * Result of a solve, as option IDs of every window cell
+ */
+struct HACKATON_CITY_API FWFCCachedSolution
+{
+	bool bSolved = false;
+
+	// Seed of the successful attempt
+	int32 Seed = 0;
+
+	// Option ID per window cell, InvalidOptionId for cells left with several options
+	TArray<uint16> OptionIds;
+};
+
+/**
+ * LRU cache of solved windows keyed by their boundary signature.
+ * Failed solves are cached too, so a boundary that cannot be solved does not run all its attempts again.
+ */
+class HACKATON_CITY_API FWFCSolutionCache
+{
+public:
+	static constexpr uint32 Magic = 0x53434657;
+	static constexpr uint32 Version = 4;
+
+	/**
+	* Resize the cache, dropping every entry if the capacity changes
+	* @param Capacity Maximum amount of entries, 0 disables the cache
+	*/
+	void SetCapacity(int32 Capacity);
+
+	int32 GetCapacity() const { return Entries.Max(); }
+
+	int32 Num() const { return Entries.Num(); }
+
+	/**
+	* Returns the cached solution of a signature and marks it as most recently used, or nullptr
+	* @param Signature
+	*/
+	const FWFCCachedSolution* Find(const FWFCBoundarySignature& Signature);
+
+	/**
+	* Add or replace the solution of a signature, evicting the least recently used entry when full
+	* @param Signature
+	* @param Solution
+	*/
+	void Add(const FWFCBoundarySignature& Signature, FWFCCachedSolution&& Solution);
+
+	void Empty();
+
+	/**
+	* Returns the cache file of a model, under Saved/WFCCache
+	* @param ModelHash
+	*/
+	static FString GetCacheFilename(uint32 ModelHash);
+
+	/**
+	* Write every entry to a file, least recently used first
+	* @param Filename
+	*/
+	bool Save(const FString& Filename) const;
+
+	/**
+	* Add the entries of a file saved for the same model
+	* @param Filename
+	* @param ModelHash Entries of other models are skipped
+	*/
+	bool Load(const FString& Filename, uint32 ModelHash);
+
+	void LogStats() const;
+
+private:
+	TLruCache<FWFCBoundarySignature, FWFCCachedSolution> Entries;
+
+	int64 NumHits = 0;
+	int64 NumMisses = 0;
+};
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WaveFunctionCollapseBPLibrary.h"
+#include "WaveFunctionCollapseClasses.h"
+
+/**
+ * Scratch memory of the solver, owned by the solver context of a world and reused by all its solves.
+ * Containers are reset without releasing their allocations and tiles are copied into the option arrays they already hold,
+ * so once grown to the window size and option count, solves of the same model do not touch the heap.
+ * Solves of a world run one at a time, a nested solve would overwrite the arena.
+ */
+struct HACKATON_CITY_API FWFCSolveArena
+{
+	// Output of the current solve
+	TArray<FWaveFunctionCollapseTile> Tiles;
+	TArray<int32> RemainingTiles;
+
+	// Option IDs of each tile, parallel to its RemainingOptions, so propagation never looks options up
+	TArray<TArray<uint16>> TileOptionIds;
+
+	// Tiles as set up by InitializeWFC, copied back before each retry
+	TArray<FWaveFunctionCollapseTile> InitializedTiles;
+	TArray<TArray<uint16>> InitializedTileOptionIds;
+	TArray<int32> InitializedRemainingTiles;
+
+	TMap<int32, FWaveFunctionCollapseQueueElement> ObservationQueue;
+	TMap<int32, FWaveFunctionCollapseQueueElement> PropagationQueue;
+
+	// Options allowed by the neighbor of the propagated tile, as mask words, for models too large for the fixed-width kernels
+	TArray<uint64> AllowedOptionWords;
+
+	// Cumulative option weights of the observed tile
+	TArray<float> CumulativeDensity;
+
+	// Initial tile per model hash
+	TMap<uint32, FWaveFunctionCollapseTile> InitialTiles;
+
+	// Border tile per (model hash << 32) | (empty border << 24) | (district option ID << 8) | face bits, and its option IDs
+	TMap<uint64, FWaveFunctionCollapseTile> BorderTiles;
+	TMap<uint64, TArray<uint16>> BorderTileOptionIds;
+
+	// Set while SolveTiles runs
+	bool bSolving = false;
+
+	/**
+	* Grow the containers for a solve window, once instead of while solving
+	* @param NumCells Amount of cells of the window
+	* @param NumOptions Amount of options of the model
+	*/
+	void Reserve(int32 NumCells, int32 NumOptions);
+
+	/**
+	* Drop the initial and border tiles, for a model or district change
+	*/
+	void ResetCachedTiles();
+
+	/**
+	* Copy a tile into another, reusing the allocation of its option array
+	* @param Source
+	* @param Dest (by ref)
+	*/
+	static void CopyTile(const FWaveFunctionCollapseTile& Source, FWaveFunctionCollapseTile& Dest);
+
+	/**
+	* Copy tiles into another array, reusing the allocations of the tiles it already holds
+	* @param Source
+	* @param Dest (by ref)
+	*/
+	static void CopyTiles(const TArray<FWaveFunctionCollapseTile>& Source, TArray<FWaveFunctionCollapseTile>& Dest);
+
+	/**
+	* Copy the option IDs of tiles into another array, reusing the allocations of the ID arrays it already holds
+	* @param Source
+	* @param Dest (by ref)
+	*/
+	static void CopyTileOptionIds(const TArray<TArray<uint16>>& Source, TArray<TArray<uint16>>& Dest);
+
+	SIZE_T GetAllocatedSize() const;
+};
@@ -0,0 +1,281 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WaveFunctionCollapseModel.h"
+#include "WaveFunctionCollapseBPLibrary.h"
+#include "WaveFunctionCollapseClasses.h"
+#include "WFCCompiledModel.h"
+#include "WFCSolutionCache.h"
+#include "WFCSolveArena.h"
+#include <atomic>
+
+#include "WFCSolverContext.generated.h"
+
+/**
+ * How Observe picks the next tile to collapse
+ */
+UENUM(BlueprintType)
+enum class EWFCObservationHeuristic : uint8
+{
+	// Lowest Shannon entropy, ties broken at random.  Keeps RemainingTiles semi-sorted by entropy.
+	MinEntropy,
+	// Fewest remaining options, ties broken at random
+	MinRemainingValues,
+	// Lowest Shannon entropy plus random noise scaled by ObservationNoise
+	WeightedEntropyNoise,
+	// Lowest tile index, sweeping the window along X, then Y, then Z
+	Scanline
+};
+
+/**
+ * Fine options allowed by a district option, precompiled by UWFCSubsystem::CompileDistrictModel
+ */
+struct FWFCDistrictMask
+{
+	// Indexed by fine option ID
+	TBitArray<> AllowedOptions;
+
+	// Initial tile of the fine solve restricted to the allowed options, and the option IDs of its options
+	FWaveFunctionCollapseTile InitialTile;
+	TArray<uint16> InitialOptionIds;
+};
+
+/**
+ * Settings and state of the solves of one solve window: the compiled model, the window, its starter options and districts,
+ * the observation heuristic and the scratch memory.  The subsystem of a world, each worker of the bake commandlet and the
+ * speculative solve own one, so no two solves running at the same time share any of it.
+ * Solves read no UObject, the compiled model holds the weights and spawn exclusions of the model, so any thread can run them.
+ */
+USTRUCT(BlueprintType)
+struct HACKATON_CITY_API FWFCSolverContext
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	FIntVector Resolution = FIntVector::ZeroValue;
+
+	// Treat the outside of the solve window as EmptyOption on the faces BorderOption does not constrain
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	bool bUseEmptyBorder = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	TMap<FIntVector, FWaveFunctionCollapseOption> StarterOptions;
+
+	// Tile selection of Observe.  Compare them on a model with wfc.Benchmark.Heuristics.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	EWFCObservationHeuristic ObservationHeuristic = EWFCObservationHeuristic::MinEntropy;
+
+	// Scale of the random noise added to the entropy of each tile by WeightedEntropyNoise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings", meta = (ClampMin = "0.0"))
+	float ObservationNoise = 0.1f;
+
+	// Option palette, weights and adjacency of the model, immutable and shared between contexts
+	TSharedRef<const FWFCCompiledModel> CompiledModel = MakeShared<FWFCCompiledModel>();
+
+	// Fine option masks, indexed by district option ID, shared with the contexts copying the settings of this one
+	TSharedRef<const TArray<FWFCDistrictMask>> DistrictMasks = MakeShared<TArray<FWFCDistrictMask>>();
+
+	// District option ID per cell of the current solve window, read by InitializeWFC.  Empty without a district model.
+	TArray<uint16> WindowDistrictIds;
+
+	// Solution cache of the owner of the context, not owned.  Null for contexts solving off the game thread.
+	FWFCSolutionCache* SolutionCache = nullptr;
+
+	// Lowest tile index that may still be unobserved, advanced by the Scanline heuristic.  Reset for every solve.
+	// Scanline keeps RemainingTiles in descending index order, so the tile at the cursor is the last one and is popped in O(1).
+	int32 ScanlineCursor = 0;
+
+	// Propagate with the dynamic width kernel whatever the mask width, like wfc.Solver.ForceDynamicKernel for this context only
+	bool bForceDynamicKernel = false;
+
+	// Flag of the owner of the context, not owned.  Once set, the running solve fails at its next observation.  Null for solves that always complete.
+	const std::atomic<bool>* CancelSolve = nullptr;
+
+	// Scratch memory of every solve of this context
+	FWFCSolveArena SolveArena;
+
+	// Solves that succeeded with provisional starter options, and solves that had to drop them
+	int32 NumProvisionalAdoptions = 0;
+	int32 NumProvisionalRejections = 0;
+
+	/**
+	* Copy the model and solve settings of another context, without its starter options, district IDs or scratch memory
+	* @param Other
+	*/
+	void CopySettings(const FWFCSolverContext& Other);
+
+	/**
+	* Returns true if the owner of the context asked the running solve to stop through CancelSolve
+	*/
+	bool IsSolveCancelled() const
+	{
+		return CancelSolve && CancelSolve->load(std::memory_order_relaxed);
+	}
+
+	/**
+	* Initialize WFC process which sets up Tiles and RemainingTiles arrays
+	* Pre-populates Tiles with StarterOptions, BorderOptions and InitialTiles.
+	* Border tiles are the initial options ANDed with the precompiled border masks of the faces they touch.
+	* Also sets up the option IDs of the tiles in SolveArena.TileOptionIds.
+	* @param Tiles Array of tiles (by ref)
+	* @param RemainingTiles Array of remaining tile indices.  Semi-sorted: Min Entropy tiles at the front, the rest remains unsorted (by ref)
+	*/
+	void InitializeWFC(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles);
+
+	/**
+	* Rebuild SolveArena.TileOptionIds from tiles set up without InitializeWFC, before Observe and Propagate get them
+	* @param Tiles
+	*/
+	void SyncTileOptionIds(const TArray<FWaveFunctionCollapseTile>& Tiles);
+
+	/**
+	* Observation phase:
+	* This process selects one tile with the ObservationHeuristic, randomly among minimum entropy tiles by default,
+	* then randomly selects a valid option for that tile
+	* @param Tiles Array of tiles (by ref)
+	* @param RemainingTiles Array of remaining tile indices.  Semi-sorted: Min Entropy tiles at the front, the rest remains unsorted (by ref)
+	* @param ObservationQueue Array to store tiles that need to be checked whether remaining options are affected during propagation phase (by ref)
+	*/
+	bool Observe(TArray<FWaveFunctionCollapseTile>& Tiles,
+		TArray<int32>& RemainingTiles,
+		TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue,
+		int32 RandomSeed);
+
+	/**
+	* Propagation phase:
+	* This process checks if the selection made during the observation is valid by checking constraint validity with neighboring tiles.
+	* Neighboring tiles may reduce their remaining options to include only valid options.
+	* If the remaining options of a tile were modified, the neighboring tiles of the modified tile will be added to a queue.
+	* During this process, if any contradiction (a tile with zero remaining options) is encountered, the current solve will fail.
+	* @param Tiles Array of tiles (by ref)
+	* @param RemainingTiles Array of remaining tile indices.  Semi-sorted: Min Entropy tiles at the front, the rest remains unsorted (by ref)
+	* @param ObservationQueue Array to store tiles that need to be checked whether remaining options are affected (by ref)
+	* @param PropagationCount Counter for propagation passes
+	*/
+	bool Propagate(TArray<FWaveFunctionCollapseTile>& Tiles,
+		TArray<int32>& RemainingTiles,
+		TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue,
+		int32& PropagationCount);
+
+	/**
+	* Recursive Observation and Propagation cycle
+	* @param Tiles Array of tiles (by ref)
+	* @param RemainingTiles Array of remaining tile indices (by ref)
+	* @param ObservationQueue Array to store tiles that need to be checked whether remaining options are affected (by ref)
+	*/
+	bool ObservationPropagation(TArray<FWaveFunctionCollapseTile>& Tiles,
+		TArray<int32>& RemainingTiles,
+		TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue,
+		int32 RandomSeed);
+
+	/**
+	* Initialize the grid from StarterOptions and run the observation and propagation cycle, retrying with new seeds on failure
+	* @param TryCount Amount of times to attempt a successful solve
+	* @param InOutRandomSeed Seed of the first attempt, then seed of the successful attempt (by ref)
+	* Scratch memory comes from SolveArena, callers pass SolveArena.Tiles to keep the tile allocations as well.
+	* @param Tiles Solved array of tiles (by ref)
+	*/
+	bool SolveTiles(int32 TryCount, int32& InOutRandomSeed, TArray<FWaveFunctionCollapseTile>& Tiles);
+
+	/**
+	* Solve the window from StarterOptions into SolveArena.Tiles, first adding the provisional starter options if any
+	* @param TryCount Amount of times to attempt a successful solve
+	* @param ProvisionalStarterOptions Provisional tiles, dropped for the remaining attempts if they conflict
+	* @param InOutRandomSeed Seed of the first attempt, then seed of the successful attempt (by ref)
+	*/
+	bool SolveWindow(int32 TryCount, const TMap<FIntVector, FWaveFunctionCollapseOption>& ProvisionalStarterOptions, int32& InOutRandomSeed);
+
+	/**
+	* Solve the window of a deterministic chunk from StarterOptions and keep the option IDs of its inner cells
+	* @param TryCount Amount of times to attempt a successful solve
+	* @param InOutRandomSeed Seed of the first attempt, then seed of the successful attempt (by ref)
+	* @param OutOptionIds Option ID per chunk cell
+	*/
+	bool SolveChunk(int32 TryCount, int32& InOutRandomSeed, TArray<uint16>& OutOptionIds);
+
+	/**
+	* Builds the Initial Tile which is a tile containing all possible options, from the initial options of the compiled model
+	* @param InitialTile The Initial Tile (by ref)
+	*/
+	bool BuildInitialTile(FWaveFunctionCollapseTile& InitialTile) const;
+
+	/**
+	* Gather the option IDs of StarterOptions as sorted (window cell index << 16) | option ID values.
+	* Fails for windows of more than MAX_uint16 cells, whose indices do not fit.
+	* @param OutBoundaryCells
+	*/
+	bool GatherBoundaryCells(TArray<uint32>& OutBoundaryCells) const;
+
+	/**
+	* Build the solution cache key of a solve from StarterOptions
+	* @param TryCount Amount of times to attempt a successful solve
+	* @param RandomSeed Seed of the first attempt
+	* @param OutSignature
+	*/
+	bool MakeBoundarySignature(int32 TryCount, int32 RandomSeed, FWFCBoundarySignature& OutSignature) const;
+
+	/**
+	* Returns the hash of the settings that change solve results besides the model, window and seed
+	*/
+	uint32 GetSolverSettingsHash() const;
+
+	/**
+	* Returns the amount of cells covered by a deterministic chunk along each axis, the solve window minus a one cell margin on X and Y
+	*/
+	FIntVector GetChunkStride() const;
+
+	/**
+	* Returns the chunk stride of a lattice solved with given resolution
+	* @param WindowResolution
+	*/
+	static FIntVector GetChunkStride(const FIntVector& WindowResolution);
+
+	/**
+	* Returns the solve window cell of the first cell of a deterministic chunk
+	*/
+	FIntVector GetChunkWindowOffset() const;
+
+private:
+	/**
+	* Used in Observe and Propagate to add adjacent indices to a queue
+	* @param CenterIndex Index of the center object
+	* @param RemainingTiles Used to check if index still remains in RemainingTiles
+	* @param OutQueue Queue to add indices to
+	*/
+	void AddAdjacentIndicesToQueue(int32 CenterIndex, const TArray<int32>& RemainingTiles, TMap<int32,FWaveFunctionCollapseQueueElement>& OutQueue) const;
+
+	/**
+	* AddAdjacentIndicesToQueue for a window with or without several layers, single layer windows skip the Up and Down neighbors
+	*/
+	template<bool bIs3D>
+	void AddAdjacentIndicesToQueueKernel(int32 CenterIndex, const TArray<int32>& RemainingTiles, TMap<int32,FWaveFunctionCollapseQueueElement>& OutQueue) const;
+
+	/**
+	* Propagate specialized on the mask width of the compiled model, in 64-bit words or 0 for a width only known at runtime,
+	* and on the dimensionality of the window.  Propagate picks the instantiation.
+	*/
+	template<int32 NumWords, bool bIs3D>
+	bool PropagateKernel(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue, int32& PropagationCount);
+
+	/**
+	* Returns the district mask of a solve window cell, or nullptr if the cell is unconstrained
+	* @param WindowIndex
+	*/
+	const FWFCDistrictMask* FindWindowDistrictMask(int32 WindowIndex) const;
+
+	/**
+	* Returns the position in RemainingTiles of the tile to observe with any heuristic but MinEntropy
+	* @param Tiles
+	* @param RemainingTiles Sorted in descending index order by Scanline if they were not already
+	* @param RandomStream Stream of the observation, for tie-breaking and noise
+	*/
+	int32 SelectObservedTile(const TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles, FRandomStream& RandomStream);
+
+	/**
+	* Returns true if no remaining options in given tiles are an empty/void option or included in the SpawnExclusion list
+	* @param Tiles Successfully solved array of tiles
+	*/
+	bool AreAllTilesNonSpawnable(const TArray<FWaveFunctionCollapseTile>& Tiles) const;
+};
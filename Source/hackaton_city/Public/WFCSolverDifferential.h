@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WaveFunctionCollapseModel.h"
+#include "WaveFunctionCollapseClasses.h"
+#include "hackaton_city/Public/WFCSolverContext.h"
+
+/**
+ * Building blocks of the solver differential run by UWFCSubsystem::RunSolverDifferential.
+ * Random models, the reference solver and the tiling check are independent of the compiled model, so they do not share a bug with the solver.
+ */
+struct HACKATON_CITY_API FWFCSolverDifferential
+{
+	/**
+	* Returns a transient model of 2 to 320 options with random weights and random symmetric adjacency on all six faces.
+	* Option counts are spread over the mask widths of the compiled model, so every propagation kernel gets random models.
+	* The same seed always builds the same model.
+	* @param ModelSeed
+	*/
+	static UWaveFunctionCollapseModel* MakeRandomModel(int32 ModelSeed);
+
+	/**
+	* Reference solve of the differential: the observation and propagation of the original solver, written against the constraints
+	* of the model without the compiled model, solve arena or solution cache.  Districts are not supported, random models have none.
+	* @param Model Model to solve, the context only provides the settings
+	* @param Settings Resolution, starter options, border and observation settings of the solve
+	* @param TryCount Amount of times to attempt a successful solve
+	* @param InOutRandomSeed Seed of the first attempt, then seed of the successful attempt (by ref)
+	* @param OutTiles Solved array of tiles
+	*/
+	static bool SolveReference(UWaveFunctionCollapseModel* Model, const FWFCSolverContext& Settings, int32 TryCount, int32& InOutRandomSeed, TArray<FWaveFunctionCollapseTile>& OutTiles);
+
+	/**
+	* Check that every cell holds exactly one option of the model, that starter cells kept their option
+	* and that every pair of adjacent cells is allowed by the constraints of the model
+	* @param Model
+	* @param Tiles Solved tiles
+	* @param Resolution
+	* @param StarterOptions Starter options of the solve
+	* @param OutError Description of the first violation
+	*/
+	static bool CheckTiling(const UWaveFunctionCollapseModel* Model, const TArray<FWaveFunctionCollapseTile>& Tiles, const FIntVector& Resolution,
+		const TMap<FIntVector, FWaveFunctionCollapseOption>& StarterOptions, FString& OutError);
+};
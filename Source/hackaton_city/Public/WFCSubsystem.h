@@ -3,17 +3,137 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Subsystems/GameInstanceSubsystem.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
 #include "WaveFunctionCollapseModel.h"
 #include "WaveFunctionCollapseBPLibrary.h"
 #include "WaveFunctionCollapseClasses.h"
+#include "WFCChunk.h"
+#include "WFCChunkProxy.h"
+#include "WFCCompiledModel.h"
+#include "WFCPlacedTiles.h"
+#include "WFCPlacedTilesSnapshot.h"
+#include "WFCSessionJournal.h"
+#include "WFCSolutionCache.h"
+#include "WFCSolveArena.h"
+#include "WFCSolverContext.h"
+#include "Tasks/Task.h"
 
 #include "WFCSubsystem.generated.h"
+
+class AWFCGenerationReplicator;
+class UInstancedStaticMeshComponent;
+class UMaterialInterface;
+class UStaticMesh;
+struct FWFCGenerationEvent;
+
+/**
+ * A lattice of deterministic chunks: the context solving them, the records solved so far and the seed the chunk seeds derive from.
+ * The city and the district grid are two lattices, each with its own solver context, model and resolution.
+ */
+struct FWFCChunkLattice
+{
+	FWFCSolverContext& Solver;
+	const TMap<FIntVector, FWFCChunk>& Chunks;
+	int32 Seed;
+};
+
+/**
+ * A static mesh component extracted from a tile Blueprint
+ */
+USTRUCT(BlueprintType)
+struct FWFCFlattenedMesh
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCSettings")
+	TObjectPtr<UStaticMesh> StaticMesh = nullptr;
+
+	// Transform of the mesh relative to the Blueprint actor root
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCSettings")
+	FTransform RelativeTransform = FTransform::Identity;
+};
+
+/**
+ * A tile Blueprint flattened into its static meshes, so it can be placed with ISM instances
+ */
+USTRUCT(BlueprintType)
+struct FWFCFlattenedTile
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCSettings")
+	TArray<FWFCFlattenedMesh> Meshes;
+
+	// The Blueprint carries non-mesh logic and must still be spawned as a real actor
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "WFCSettings")
+	bool bSpawnActor = false;
+};
+
+/**
+ * Loaded representation of an option of the compiled model, resolved once instead of once per placed tile
+ */
+USTRUCT()
+struct FWFCResolvedOption
+{
+	GENERATED_BODY()
+
+	// Meshes emitted as ISM instances when the option is placed, relative to the tile transform
+	UPROPERTY()
+	TArray<FWFCFlattenedMesh> Meshes;
+
+	// Actor spawned when the option cannot be instanced
+	UPROPERTY()
+	TSubclassOf<AActor> ActorClass;
+
+	bool bResolved = false;
+};
+
+/**
+ * Fine tiles allowed inside the cells of a district option
+ */
+USTRUCT(BlueprintType)
+struct FWFCDistrictTileSet
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings", meta = (AllowedClasses = "StaticMesh, Blueprint"))
+	TArray<FSoftObjectPath> AllowedObjects;
+};
+
+/**
+ * Solve of a predicted Collapse window running ahead on a worker thread, see UWFCSubsystem::SpeculateCollapse
+ */
+struct FWFCSpeculativeSolve
+{
+	// Inputs of the predicted Collapse, compared with the Collapse committing the solve
+	FVector OriginLocation = FVector::ZeroVector;
+	FIntVector Resolution = FIntVector::ZeroValue;
+	int32 TryCount = 1;
+	uint32 ModelHash = 0;
+	uint32 SolverSettingsHash = 0;
+	TMap<FIntVector, FWaveFunctionCollapseOption> PlacedStarterOptions;
+	TMap<FIntVector, FWaveFunctionCollapseOption> ProvisionalStarterOptions;
+
+	// Seed of the first attempt
+	int32 RandomSeed = 0;
+
+	// Cleared once a Collapse committed or dropped the solve
+	bool bPending = true;
+
+	// Set once no Collapse is going to commit the solve, read by the worker between observations
+	std::atomic<bool> bCancelled = false;
+
+	// Seed of the successful attempt, unset if every attempt failed.  The tiles are left in the solve arena of the speculative solver context.
+	UE::Tasks::TTask<TOptional<int32>> Task;
+};
+
 /**
- * 
+ * Solver context of one world.  Each game world, PIE instance or server session gets its own placed tiles, chunks and solve state,
+ * while worlds solving the same model read one shared immutable compiled model.
  */
 UCLASS()
-class HACKATON_CITY_API UWFCSubsystem : public UGameInstanceSubsystem
+class HACKATON_CITY_API UWFCSubsystem : public UWorldSubsystem, public FTickableGameObject
 {
 	GENERATED_BODY()
 
@@ -21,31 +141,186 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
 	TObjectPtr<UWaveFunctionCollapseModel> WFCModel;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
-	FIntVector Resolution;
-
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
 	FVector OriginLocation = FVector::ZeroVector;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
 	FRotator Orientation = FRotator::ZeroRotator;
 
+	// Solve window, starter options and observation settings of this world.  CompileModel fills in its model.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
-	bool bUseEmptyBorder;
+	FWFCSolverContext Solver;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
-	TMap<FIntVector, FWaveFunctionCollapseOption> StarterOptions;
+	// Output field, filled at the end of the Collapse function with the option IDs of the placed tiles
+	// at their absolute grid cells.  Use FindPlacedOption or FindPlacedOptionId to read it.
+	FWFCPlacedTiles PlacedTiles;
 
-	// Output field, filled at the end of the Collapse function with the placed tiles and
-	// discrete positions in space, relative to the origin location and depending on the resolution.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")                    
-	TMap<FIntVector, FWaveFunctionCollapseOption> PlacedTiles{};
+	// Option IDs solved on cells that were not placed: the margin ring and the non-spawnable inner cells of earlier solves.
+	// Later solves overlapping them adopt them as soft starter options.
+	FWFCPlacedTiles ProvisionalTiles;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
 	TMap<FVector, AActor*> SpawnedActors{};
 
+	// Blueprint tiles flattened into static meshes, filled by FlattenBlueprintTiles and kept across model compiles
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Transient, Category = "WFCSettings")
+	TMap<FSoftObjectPath, FWFCFlattenedTile> FlattenedTiles{};
+
+	// Actor tag that makes a tile Blueprint opt out of flattening and spawn as a real actor
+	static const FName SpawnAsActorTag;
+
+	// Component tag of the ISM Components whose collision follows the collision state of their chunk
+	static const FName CollisionComponentTag;
+
+	// Component tag of the merged proxy mesh of a chunk
+	static const FName ChunkProxyComponentTag;
+
+	// Place chunks on a fixed lattice and seed them from WorldSeed and their lattice coordinates.
+	// Any chunk then regenerates identically, whatever order chunks were generated in.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	bool bDeterministicGeneration = false;
+
+	// Collapse first tries the window with the provisional tiles of earlier solves as starter options,
+	// then solves it from the placed tiles only if they conflict
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	bool bReuseProvisionalTiles = true;
+
+	// Projectiles solve the window around their predicted impact on a worker thread while in flight, see SpeculateCollapse
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	bool bSpeculativeSolves = true;
+
+	// Seed of the whole city when bDeterministicGeneration is set
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	int32 WorldSeed = 0;
+
+	// Amount of seeds tried for a deterministic chunk, derived from its chunk seed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	int32 DeterministicTryCount = 10;
+
+	// Maximum amount of solved windows kept by the solution cache. 0 disables the cache.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	int32 SolutionCacheCapacity = 0;
+
+	// Random seeds of Collapse are drawn from 1 to this value, so solves repeat and hit the solution cache. 0 draws from the whole range.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCSettings")
+	int32 RandomSeedPoolSize = 0;
+
+	// Coarse model solved over district cells.  Its results restrict the options of the fine solves inside each district.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCDistricts")
+	TObjectPtr<UWaveFunctionCollapseModel> DistrictModel;
+
+	// Fine tiles allowed per district option BaseObject.  District options without an entry allow every fine tile.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCDistricts")
+	TMap<FSoftObjectPath, FWFCDistrictTileSet> DistrictTileSets;
+
+	// Solve window of the district model, in district cells
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCDistricts")
+	FIntVector DistrictResolution = FIntVector(5, 5, 1);
+
+	// Amount of fine cells covered by a district cell along each axis
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCDistricts")
+	FIntVector DistrictCellSize = FIntVector(9, 9, 1);
+
+	// Deterministic chunks of the district model solved so far, keyed by origin district cell
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Transient, Category = "WFCDistricts")
+	TMap<FIntVector, FWFCChunk> DistrictChunks{};
+
+	// Option palette of DistrictModel, shared with the other worlds solving the same model
+	TSharedRef<const FWFCCompiledModel> DistrictCompiledModel = MakeShared<FWFCCompiledModel>();
+
+	// Solver context of the district chunks, with DistrictCompiledModel, DistrictResolution and no solution cache.  Set up by CompileDistrictModel.
+	FWFCSolverContext DistrictSolver;
+
+	// Chunks farther than this from every player are evicted down to their compact record. 0 disables distance eviction.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCChunks")
+	float ChunkEvictionRadius = 0.0f;
+
+	// Budget for the memory of resident chunks in MB, the farthest chunks are evicted above it. 0 disables the budget.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCChunks")
+	float ChunkMemoryBudgetMB = 0.0f;
+
+	// Seconds between two chunk residency updates
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCChunks")
+	float ChunkResidencyUpdateInterval = 0.5f;
+
+	// Evicted chunks re-materialized per frame at most, nearest first.  Deterministic chunks are solved again on the game thread.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCChunks", meta = (ClampMin = "1"))
+	int32 MaxRematerializationsPerTick = 2;
+
+	// Chunks are spawned without collision and only get it within this distance of a player or a registered actor.
+	// 0 creates collision right away when a chunk is spawned.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCCollision")
+	float CollisionRadius = 0.0f;
+
+	// Time spent per frame enabling and disabling chunk collision, in milliseconds.  At least one chunk is processed per frame.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCCollision")
+	float CollisionBudgetMs = 1.0f;
+
+	// Registered actors also request collision where their velocity takes them within this many seconds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCCollision")
+	float CollisionLookaheadTime = 0.5f;
+
+	// Meshes without simple collision collide through a hidden box per instance instead of their render triangles
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCCollision")
+	bool bUseCollisionProxies = false;
+
+	// Mesh of the collision proxies, scaled to the bounds of each proxied mesh
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCCollision")
+	TSoftObjectPtr<UStaticMesh> CollisionProxyMesh = TSoftObjectPtr<UStaticMesh>(FSoftObjectPath(TEXT("/Engine/BasicShapes/Cube.Cube")));
+
+	// Chunk components stay out of navigation and each complete chunk exports its geometry through one UWFCChunkNavigationComponent,
+	// so navigation is rebuilt once per spawned or evicted chunk.  Disabled, every component dirties navigation on its own.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCNavigation")
+	bool bBatchNavigationUpdates = true;
+
+	// Beyond this distance a chunk is drawn as a single merged proxy mesh instead of its ISM Components. 0 disables chunk proxies.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCProxies")
+	float ChunkProxySwapDistance = 0.0f;
+
+	// Meshes whose lowest LOD has more triangles are merged into proxies as their bounding box.
+	// Meshes without CPU-readable geometry are not merged and keep drawing at any distance.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCProxies")
+	int32 ChunkProxyMaxTrianglesPerMesh = 512;
+
+	// Material of the proxy sections whose source material cannot be loaded.  The other sections keep the material of their mesh slot.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WFCProxies")
+	TSoftObjectPtr<UMaterialInterface> ChunkProxyMaterial = TSoftObjectPtr<UMaterialInterface>(FSoftObjectPath(TEXT("/Engine/BasicShapes/BasicShapeMaterial.BasicShapeMaterial")));
+
+	// Built proxy meshes keyed by chunk layout hash, shared by every resident chunk with the same option layout
+	UPROPERTY(Transient)
+	TMap<uint32, TObjectPtr<UStaticMesh>> ChunkProxyMeshes;
+
+	// Every chunk generated so far, resident or evicted, keyed by the absolute grid cell of its solve origin
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Transient, Category = "WFCChunks")
+	TMap<FIntVector, FWFCChunk> Chunks{};
+
+	// Option palette of WFCModel, built by CompileModel and shared with the other worlds solving the same model
+	TSharedRef<const FWFCCompiledModel> CompiledModel = MakeShared<FWFCCompiledModel>();
+
+	// Solved windows keyed by boundary signature
+	FWFCSolutionCache SolutionCache;
+
+	// Loaded objects of every option of CompiledModel, indexed by option ID and filled on first use
+	UPROPERTY(Transient)
+	TArray<FWFCResolvedOption> ResolvedOptions;
+
+	/**
+	* Build the option palette of WFCModel and flatten its Blueprint tiles.  Call after WFCModel is assigned.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	void CompileModel();
+
+	/**
+	* Load-time pass that flattens every Blueprint tile of the model into its static mesh components.
+	* Placing a flattened tile emits ISM instances into the shared batches instead of spawning an actor.
+	* Blueprints with event graph logic, non-mesh components or the SpawnAsActorTag keep spawning an actor.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	void FlattenBlueprintTiles();
+
 	/**
 	* Solve a grid using a WFC model.  If successful, spawn an actor.
+	* With bDeterministicGeneration, the lattice chunk containing OriginLocation is generated instead, using DeterministicTryCount and its chunk seed.
 	* @param TryCount Amount of times to attempt a successful solve
 	* @param RandomSeed Seed for deterministic results.  When this value is 0 the seed will be generated. Seed value will be logged during the solve.
 	*/
@@ -53,20 +328,188 @@ public:
 	AActor* Collapse(int32 TryCount = 1, int32 RandomSeed = 0);
 
 	/**
-	* Initialize WFC process which sets up Tiles and RemainingTiles arrays
-	* Pre-populates Tiles with StarterOptions, BorderOptions and InitialTiles
+	* Start solving the window of a future Collapse on a worker thread.  The next Collapse at the same location with a generated seed
+	* commits the result if the tiles around the window did not change in between, any other Collapse solves as usual.
+	* Ignored with bDeterministicGeneration, on clients, or while the previous speculative solve is still running.
+	* @param Location Predicted OriginLocation of the Collapse, see GetCollapseLocation
+	* @param TryCount TryCount of the Collapse
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	void SpeculateCollapse(const FVector& Location, int32 TryCount = 1);
+
+	/**
+	* Returns the OriginLocation of the Collapse triggered by a hit: the hit location snapped down to the tile grid, on the ground
+	* @param HitLocation
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	FVector GetCollapseLocation(const FVector& HitLocation) const;
+
+	/**
+	* Build the palette of DistrictModel and precompile the fine option mask of every district option.  Called by CompileModel.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCDistricts")
+	void CompileDistrictModel();
+
+	/**
+	* Returns the district option ID of a district cell, solving its district chunk on first use.
+	* District chunks are deterministic chunks of DistrictModel seeded from WorldSeed, so they do not depend on the fine city.
+	* @param DistrictCell
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCDistricts")
+	int32 GetDistrictOptionId(FIntVector DistrictCell);
+
+	/**
+	* Returns the district cell containing an absolute grid cell
+	* @param AbsoluteCell
+	*/
+	UFUNCTION(BlueprintPure, Category = "WFCDistricts")
+	FIntVector GetDistrictCell(FIntVector AbsoluteCell) const;
+
+	/**
+	* Generate every deterministic chunk covering a district cell.  Requires bDeterministicGeneration.
+	* The chunks only depend on their district and primary neighbors, so the primaries, then the secondaries, are solved in parallel.
+	* @param DistrictCell
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCDistricts")
+	int32 GenerateDistrict(FIntVector DistrictCell);
+
+	/**
+	* Offline pre-population of the solution cache, saved under Saved/WFCCache for LoadSolutionCache.
+	* Starting from an empty boundary, every solved window yields the boundaries seen by the windows one chunk stride away,
+	* and every boundary is solved with each seed of the random seed pool.
+	* @param NumVariants Amount of solves to run
+	* @param TryCount Amount of times to attempt a successful solve
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	void PrepopulateSolutionCache(int32 NumVariants = 1000, int32 TryCount = 10);
+
+	/**
+	* Solve an empty window of the current resolution with every observation heuristic and log their time and failure rate.
+	* Each heuristic runs a single attempt per seed, from 1 to NumSolves.
+	* @param NumSolves Amount of seeds solved per heuristic
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	void BenchmarkObservationHeuristics(int32 NumSolves = 100);
+
+	/**
+	* Compare the solver paths against the reference solver on random models, resolutions, starter tiles and heuristics.
+	* Every output is checked for adjacency validity against the model, and every path must give the reference result bit for bit.
+	* Random models cover every mask width, and each fixed-width propagation kernel is also compared with the dynamic width kernel.
+	* The minimal failing seed of each failing configuration is logged with the model seed that rebuilds it.
+	* @param NumModels Amount of random models, each with its own resolution, starter tiles and try count
+	* @param NumSeeds Seeds solved per model and heuristic, from 1
+	* @param HarnessSeed Seed the model seeds are drawn from
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	bool RunSolverDifferential(int32 NumModels = 20, int32 NumSeeds = 50, int32 HarnessSeed = 1);
+
+	/**
+	* Load the solution cache saved for the compiled model, if any
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	bool LoadSolutionCache();
+
+	/**
+	* Save the solution cache of the compiled model under Saved/WFCCache
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	bool SaveSolutionCache() const;
+
+	/**
+	* Returns the lattice coordinates of the deterministic chunk containing an absolute grid cell
+	* @param AbsoluteCell
+	*/
+	UFUNCTION(BlueprintPure, Category = "WFCFunctions")
+	FIntVector GetChunkCoord(FIntVector AbsoluteCell) const;
+
+	/**
+	* Returns the seed of a deterministic chunk, derived from WorldSeed and the chunk coordinates only
+	* @param ChunkCoord Lattice coordinates of the chunk
+	*/
+	UFUNCTION(BlueprintPure, Category = "WFCFunctions")
+	int32 GetChunkSeed(FIntVector ChunkCoord) const;
+
+	/**
+	* Returns the lattice coordinates of the deterministic chunk containing a cell, in a lattice solved with given resolution
+	* @param AbsoluteCell
+	* @param WindowResolution Solve window of the lattice
+	*/
+	static FIntVector GetLatticeChunkCoord(const FIntVector& AbsoluteCell, const FIntVector& WindowResolution);
+
+	/**
+	* Returns the cell of the solve origin of a deterministic chunk, in a lattice solved with given resolution
+	* @param ChunkCoord Lattice coordinates of the chunk
+	* @param WindowResolution Solve window of the lattice
+	*/
+	static FIntVector GetLatticeOriginCell(const FIntVector& ChunkCoord, const FIntVector& WindowResolution);
+
+	/**
+	* Returns the seed of a deterministic chunk, derived from the lattice seed and the chunk coordinates only
+	* @param ChunkCoord Lattice coordinates of the chunk
+	* @param LatticeSeed
+	*/
+	static int32 GetLatticeChunkSeed(const FIntVector& ChunkCoord, int32 LatticeSeed);
+
+	/**
+	* Primary chunks are solved without neighbors, the others are constrained by their four primary neighbors
+	* @param ChunkCoord Lattice coordinates of the chunk
+	*/
+	static bool IsPrimaryChunk(const FIntVector& ChunkCoord) { return ((ChunkCoord.X + ChunkCoord.Y) & 1) == 0; }
+
+	/**
+	* Returns the record of a deterministic chunk without its option IDs
+	* @param ChunkSolver Solver context of the lattice
+	* @param ChunkCoord Lattice coordinates of the chunk
+	* @param RandomSeed Seed of the first attempt
+	*/
+	static FWFCChunk MakeDeterministicChunk(const FWFCSolverContext& ChunkSolver, const FIntVector& ChunkCoord, int32 RandomSeed);
+
+	/**
+	* Gather the starter options and district IDs of the solve window of a deterministic chunk, for FWFCSolverContext::SolveChunk.
+	* Solver contexts with the settings of ChunkSolver can then solve the chunk concurrently, without the subsystem.
+	* @param ChunkSolver Solver context of the lattice, district IDs are only gathered if it has district masks
+	* @param ChunkCoord Lattice coordinates of the chunk
+	* @param PrimaryNeighbors Solved records of the primary neighbors of a secondary chunk, the missing ones leave their side unconstrained
+	* @param OutStarterOptions Starter options of the solve window
+	* @param OutWindowDistrictIds District option ID per cell of the solve window
+	*/
+	void PrepareChunkSolve(const FWFCSolverContext& ChunkSolver, const FIntVector& ChunkCoord, TConstArrayView<const FWFCChunk*> PrimaryNeighbors,
+		TMap<FIntVector, FWaveFunctionCollapseOption>& OutStarterOptions, TArray<uint16>& OutWindowDistrictIds);
+
+	/**
+	* Solve deterministic chunks of the city in parallel, one solver context per task.  Failed chunks are left without option IDs.
+	* Starter options and districts are gathered on the game thread first.
+	* @param ChunkCoords Lattice coordinates of the chunks
+	* @param Solvers Solver contexts with the settings of Solver, never shared between tasks
+	* @param PrimaryChunks Solved primary chunks by lattice coordinates, read only
+	* @param OutChunks Record per chunk coordinates
+	*/
+	void SolveChunks(const TArray<FIntVector>& ChunkCoords, TArray<FWFCSolverContext>& Solvers, const TMap<FIntVector, FWFCChunk>& PrimaryChunks, TArray<FWFCChunk>& OutChunks);
+
+	/**
+	* Add a solved chunk record to the city and spawn its actors
+	* @param Chunk Record with option IDs, e.g. from FWFCSolverContext::SolveChunk
+	*/
+	AActor* SpawnChunkRecord(FWFCChunk&& Chunk);
+
+	/**
+	* Returns the record of a chunk, resident or evicted
+	* @param OriginCell Key of the chunk
+	*/
+	const FWFCChunk* FindChunk(const FIntVector& OriginCell) const { return Chunks.Find(OriginCell); }
+
+	/**
+	* Initialize WFC process of Solver, see FWFCSolverContext::InitializeWFC
 	* @param Tiles Array of tiles (by ref)
-	* @param RemainingTiles Array of remaining tile indices.  Semi-sorted: Min Entropy tiles at the front, the rest remains unsorted (by ref)
+	* @param RemainingTiles Array of remaining tile indices (by ref)
 	*/
 	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
 	void InitializeWFC(TArray<FWaveFunctionCollapseTile>& Tiles, TArray<int32>& RemainingTiles);
 	
 	/**
-	* Observation phase: 
-	* This process randomly selects one tile from minimum entropy tiles
-	* then randomly selects a valid option for that tile
+	* Observation phase of Solver, see FWFCSolverContext::Observe
 	* @param Tiles Array of tiles (by ref)
-	* @param RemainingTiles Array of remaining tile indices.  Semi-sorted: Min Entropy tiles at the front, the rest remains unsorted (by ref)
+	* @param RemainingTiles Array of remaining tile indices (by ref)
 	* @param ObservationQueue Array to store tiles that need to be checked whether remaining options are affected during propagation phase (by ref)
 	*/
 	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
@@ -76,13 +519,9 @@ public:
 		int32 RandomSeed);
 	
 	/**
-	* Propagation phase: 
-	* This process checks if the selection made during the observation is valid by checking constraint validity with neighboring tiles. 
-	* Neighboring tiles may reduce their remaining options to include only valid options.
-	* If the remaining options of a tile were modified, the neighboring tiles of the modified tile will be added to a queue.
-	* During this process, if any contradiction (a tile with zero remaining options) is encountered, the current solve will fail.
+	* Propagation phase of Solver, see FWFCSolverContext::Propagate
 	* @param Tiles Array of tiles (by ref)
-	* @param RemainingTiles Array of remaining tile indices.  Semi-sorted: Min Entropy tiles at the front, the rest remains unsorted (by ref)
+	* @param RemainingTiles Array of remaining tile indices (by ref)
 	* @param ObservationQueue Array to store tiles that need to be checked whether remaining options are affected (by ref)
 	* @param PropagationCount Counter for propagation passes
 	*/
@@ -93,7 +532,7 @@ public:
 		int32& PropagationCount);
 	
 	/**
-	* Recursive Observation and Propagation cycle
+	* Recursive Observation and Propagation cycle of Solver
 	* @param Tiles Array of tiles (by ref)
 	* @param RemainingTiles Array of remaining tile indices (by ref)
 	* @param ObservationQueue Array to store tiles that need to be checked whether remaining options are affected (by ref)
@@ -104,61 +543,406 @@ public:
 		TMap<int32, FWaveFunctionCollapseQueueElement>& ObservationQueue,
 		int32 RandomSeed);
 
-private:
+	/**
+	* Evict the chunks beyond ChunkEvictionRadius or above ChunkMemoryBudgetMB and queue the evicted chunks back in range,
+	* re-materialized by the next ticks within MaxRematerializationsPerTick
+	* @param ViewerLocations Locations of the players
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCChunks")
+	void UpdateChunkResidency(const TArray<FVector>& ViewerLocations);
 
 	/**
-	* Builds the Initial Tile which is a tile containing all possible options
-	* @param InitialTile The Initial Tile (by ref)
+	* Destroy the actors of a chunk and remove its tiles from PlacedTiles, keeping only its compact record
+	* @param OriginCell Key of the chunk
 	*/
-	bool BuildInitialTile(FWaveFunctionCollapseTile& InitialTile);
+	UFUNCTION(BlueprintCallable, Category = "WFCChunks")
+	bool EvictChunk(FIntVector OriginCell);
 
 	/**
-	* Get valid options for a border tile
-	* @param Position Position of border tile
-	* @param TmpInitialOptions Initial options which should contain all possible options
+	* Spawn an evicted chunk again from its compact record
+	* @param OriginCell Key of the chunk
 	*/
-	//TArray<FWaveFunctionCollapseOption> GetInnerBorderOptions(FIntVector Position, const TArray<FWaveFunctionCollapseOption>& InitialOptions);
+	UFUNCTION(BlueprintCallable, Category = "WFCChunks")
+	AActor* RematerializeChunk(FIntVector OriginCell);
 
 	/**
-	* Used in GetBorderOptions to gather invalid options for border tiles that should be removed from the InitialOptions set
-	* @param Adjacency Direction from Exterior Border to Inner Border
-	* @param InInitialOptions This should be the InitialOptions
-	* @param OutBorderOptionsToRemove Array containing gathered options to remove
+	* Returns the estimated memory of all resident chunks, in bytes
 	*/
-	//void GatherInnerBorderOptionsToRemove(EWaveFunctionCollapseAdjacency Adjacency, const TArray<FWaveFunctionCollapseOption>& InitialOptions, TArray<FWaveFunctionCollapseOption>& OutBorderOptionsToRemove);
-	
+	UFUNCTION(BlueprintPure, Category = "WFCChunks")
+	int64 GetResidentChunkMemoryBytes() const;
+
 	/**
-	* Checks if a position is an inner border
-	* @param Position
+	* Log the estimated memory of every chunk, also available as the wfc.Chunks.Report console command
 	*/
-	//bool IsPositionInnerBorder(FIntVector Position);
-	
+	UFUNCTION(BlueprintCallable, Category = "WFCChunks")
+	void LogChunkMemoryReport() const;
+
 	/**
-	* Used in Observe and Propagate to add adjacent indices to a queue
-	* @param CenterIndex Index of the center object
-	* @param RemainingTiles Used to check if index still remains in RemainingTiles
-	* @param OutQueue Queue to add indices to
+	* Enable collision on the chunks within CollisionRadius of the interest locations and disable it on the chunks beyond, nearest chunks first.
+	* Stops once CollisionBudgetMs is spent, the remaining chunks are handled on the next call.
+	* @param InterestLocations Locations of the players and registered actors
 	*/
-	void AddAdjacentIndicesToQueue(int32 CenterIndex, const TArray<int32>& RemainingTiles, TMap<int32,FWaveFunctionCollapseQueueElement>& OutQueue);
-	
+	UFUNCTION(BlueprintCallable, Category = "WFCCollision")
+	void UpdateChunkCollision(const TArray<FVector>& InterestLocations);
+
+	/**
+	* Create collision around an actor while it is registered, e.g. a projectile that may hit chunks away from the players
+	* @param Actor
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCCollision")
+	void RegisterCollisionInterest(AActor* Actor);
+
+	/**
+	* Stop creating collision around an actor registered with RegisterCollisionInterest
+	* @param Actor
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCCollision")
+	void UnregisterCollisionInterest(AActor* Actor);
+
+	/**
+	* Save the records of all chunks to a compact binary snapshot under Saved/WFCCities
+	* @param SlotName Name of the snapshot file
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCChunks")
+	bool SaveCity(const FString& SlotName);
+
+	/**
+	* Replace the current city with a snapshot saved by SaveCity.
+	* Chunks near the players, or all of them when eviction is disabled, are spawned right away with bulk instance uploads.
+	* @param SlotName Name of the snapshot file
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCChunks")
+	bool LoadCity(const FString& SlotName);
+
+	/**
+	* Destroy every chunk, resident or evicted, and clear the placed tiles
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCChunks")
+	void ClearCity();
+
+	/**
+	* Start recording every Collapse request into the session journal, also available as the wfc.Journal.Start console command
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCJournal")
+	void StartJournal();
+
+	/**
+	* Stop recording and save the session journal under Saved/WFCJournals
+	* @param SlotName Name of the journal file
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCJournal")
+	bool StopJournal(const FString& SlotName);
+
+	UFUNCTION(BlueprintPure, Category = "WFCJournal")
+	bool IsRecordingJournal() const { return bRecordingJournal; }
+
+	/**
+	* Replace the current city by executing the requests of a saved journal in order, with their recorded seeds,
+	* and log the time of each request with the distribution of all of them.
+	* Runs without players or rendering, e.g. on a dedicated server or with -nullrhi -ExecCmds="wfc.Journal.Replay <SlotName>".
+	* @param SlotName Name of the journal file
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCJournal")
+	bool ReplayJournal(const FString& SlotName);
+
+	/**
+	* Find the option placed on an absolute grid cell, whether its chunk is resident or evicted
+	* @param AbsoluteCell
+	* @param OutOption Placed option
+	*/
+	UFUNCTION(BlueprintCallable, Category = "WFCFunctions")
+	bool FindPlacedOption(const FIntVector& AbsoluteCell, FWaveFunctionCollapseOption& OutOption);
+
+	/**
+	* Returns the option ID placed on an absolute grid cell, whether its chunk is resident or evicted, or InvalidOptionId
+	* @param AbsoluteCell
+	*/
+	uint16 FindPlacedOptionId(const FIntVector& AbsoluteCell);
+
+	/**
+	* Returns the latest snapshot of PlacedTiles, published every time a chunk is spawned or evicted, or null before the first one.
+	* Lock-free and callable from any thread, the snapshot stays valid and unchanged for as long as it is held.
+	*/
+	TSharedPtr<const FWFCPlacedTilesSnapshot> GetPlacedTilesSnapshot() const { return PlacedTilesPublisher.Acquire(); }
+
+	/**
+	* Set the actor replicating generation events.  Clients apply the events it already holds.
+	* @param Replicator
+	*/
+	void SetGenerationReplicator(AWFCGenerationReplicator* Replicator);
+
+	/**
+	* Solve the chunks of the replicated generation events not applied yet, in the order the server generated them.
+	* Client only, the resulting option IDs are checked against the checksum of each event.
+	*/
+	void ApplyGenerationEvents();
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	// End of FTickableGameObject interface
+
+	// USubsystem interface
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
 	/**
 	* Add an Instance Component with a given name
 	* @param Actor Actor to add component to
 	* @param ComponentClass
 	* @param ComponentName
+	* @param RelativeTransform Transform of the component relative to the actor root
 	*/
-	UActorComponent* AddNamedInstanceComponent(AActor* Actor, TSubclassOf<UActorComponent> ComponentClass, FName ComponentName);
-	
+	UActorComponent* AddNamedInstanceComponent(AActor* Actor, TSubclassOf<UActorComponent> ComponentClass, FName ComponentName, const FTransform& RelativeTransform = FTransform::Identity);
+
 	/**
-	* Spawn an actor given an array of successfully solved tiles
-	* @param Tiles Successfully solved array of tiles
+	* Give a spawned actor a unique label after the model, in editor worlds only
+	* @param Actor
 	*/
-	AActor* SpawnActorFromTiles(const TArray<FWaveFunctionCollapseTile>& Tiles);
+	void LabelSpawnedActor(AActor* Actor) const;
+
+	/**
+	* Find the ISM Component batching a given mesh on an actor, or add it if missing
+	* @param Actor Actor owning the ISM Components
+	* @param StaticMesh Mesh rendered by the ISM Component
+	* @param MeshToISM Map of the ISM Components already created for the actor (by ref)
+	*/
+	UInstancedStaticMeshComponent* FindOrAddISMComponent(AActor* Actor, UStaticMesh* StaticMesh, TMap<FSoftObjectPath, UInstancedStaticMeshComponent*>& MeshToISM);
+
+	/**
+	* Collect the static meshes of an actor class from its class default object and construction script node templates
+	* @param ActorClass Generated class of the tile Blueprint
+	* @param OutFlattenedTile Flattened meshes, or bSpawnActor if the class cannot be flattened
+	*/
+	void FlattenActorClass(UClass* ActorClass, FWFCFlattenedTile& OutFlattenedTile);
 	
 	/**
-	* Returns true if no remaining options in given tiles are an empty/void option or included in the SpawnExclusion list
+	* Gather the tiles inside a solve window as starter options, resident or evicted
+	* @param WindowOrigin OriginLocation of the window
+	* @param OutPlacedStarterOptions Placed tiles, keyed by window cell
+	* @param OutProvisionalStarterOptions Provisional tiles of earlier solves on the free cells, keyed by window cell
+	*/
+	void GatherWindowStarterOptions(const FVector& WindowOrigin, TMap<FIntVector, FWaveFunctionCollapseOption>& OutPlacedStarterOptions, TMap<FIntVector, FWaveFunctionCollapseOption>& OutProvisionalStarterOptions);
+
+	/**
+	* Move the tiles of the speculative solve into SolveArena.Tiles if it solved the window of this Collapse, otherwise drop it
+	* @param TryCount TryCount of the Collapse
+	* @param ProvisionalStarterOptions Provisional starter options of the Collapse window, StarterOptions holding the placed ones
+	* @param OutFirstRandomSeed Seed of the first attempt
+	* @param OutRandomSeed Seed of the successful attempt
+	*/
+	bool CommitSpeculativeSolve(int32 TryCount, const TMap<FIntVector, FWaveFunctionCollapseOption>& ProvisionalStarterOptions, int32& OutFirstRandomSeed, int32& OutRandomSeed);
+
+	/**
+	* Gather the district option ID of every cell of a solve window
+	* @param WindowMinCell Absolute grid cell of the first window cell
+	* @param OutWindowDistrictIds District option ID per window cell, empty without a district model
+	*/
+	void GatherWindowDistrictIds(const FIntVector& WindowMinCell, TArray<uint16>& OutWindowDistrictIds);
+
+	/**
+	* Apply SolutionCacheCapacity to the solution cache and hand it to Solver
+	*/
+	void SyncSolutionCache();
+
+	/**
+	* Returns the absolute grid cell of the solve origin of a deterministic chunk
+	* @param ChunkCoord Lattice coordinates of the chunk
+	*/
+	FIntVector GetChunkOriginCell(const FIntVector& ChunkCoord) const;
+
+	/**
+	* Solve the option IDs of a deterministic chunk.  The result only depends on the seed, the chunk coordinates and the lattice seed.
+	* @param Lattice City or district lattice, its solver context is used for the solve
+	* @param ChunkCoord Lattice coordinates of the chunk
+	* @param TryCount Amount of times to attempt a successful solve
+	* @param InOutRandomSeed Seed of the first attempt, then seed of the successful attempt (by ref)
+	* @param OutOptionIds Option ID per chunk cell
+	*/
+	bool SolveDeterministicChunk(const FWFCChunkLattice& Lattice, const FIntVector& ChunkCoord, int32 TryCount, int32& InOutRandomSeed, TArray<uint16>& OutOptionIds);
+
+	/**
+	* Get the tiles of a primary chunk from its record, or solve them if the chunk was never generated or dropped them
+	* @param Lattice City or district lattice
+	* @param ChunkCoord Lattice coordinates of the chunk
+	* @param OutChunk Bounds and option IDs of the chunk
+	*/
+	bool GetPrimaryChunkTiles(const FWFCChunkLattice& Lattice, const FIntVector& ChunkCoord, FWFCChunk& OutChunk);
+
+	/**
+	* Returns the lattice of the city chunks, solved by Solver and seeded from WorldSeed
+	*/
+	FWFCChunkLattice GetCityLattice() { return FWFCChunkLattice{ Solver, Chunks, WorldSeed }; }
+
+	/**
+	* Returns the lattice of the district chunks, solved by DistrictSolver and seeded from WorldSeed
+	*/
+	FWFCChunkLattice GetDistrictLattice() { return FWFCChunkLattice{ DistrictSolver, DistrictChunks, WorldSeed }; }
+
+	/**
+	* Solve, record and spawn the deterministic chunk at given lattice coordinates
+	* @param ChunkCoord Lattice coordinates of the chunk
+	* @param TryCount Amount of times to attempt a successful solve
+	* @param RandomSeed Seed of the first attempt
+	*/
+	AActor* SpawnDeterministicChunk(const FIntVector& ChunkCoord, int32 TryCount, int32 RandomSeed);
+
+	/**
+	* Replicate the generation of a chunk to the clients.  Does nothing outside of a server.
+	* @param Chunk Generated chunk
+	* @param BoundaryCells Starter cells of the solve, see GatherBoundaryCells
+	*/
+	void RecordGenerationEvent(const FWFCChunk& Chunk, TArray<uint32>&& BoundaryCells);
+
+	/**
+	* Solve and spawn the chunk of a replicated generation event
+	* @param Event
+	*/
+	void ApplyGenerationEvent(const FWFCGenerationEvent& Event);
+
+	/**
+	* Record the tiles of a successful solve as a chunk and spawn it
 	* @param Tiles Successfully solved array of tiles
+	* @param RandomSeed Seed of the successful solve
+	*/
+	AActor* SpawnActorFromTiles(const TArray<FWaveFunctionCollapseTile>& Tiles, int32 RandomSeed);
+
+	/**
+	* Spawn the actor and components of a chunk from its option IDs and register its tiles in PlacedTiles
+	* @param Chunk Chunk to materialize (by ref)
+	*/
+	AActor* SpawnChunk(FWFCChunk& Chunk);
+
+	/**
+	* Load the objects of an option once and cache them in ResolvedOptions
+	* @param OptionId
+	*/
+	const FWFCResolvedOption& ResolveOption(uint16 OptionId);
+
+	/**
+	* Attach the cached proxy mesh of a chunk layout, or start building it on a background task
+	* @param Chunk Resident chunk (by ref)
+	* @param MeshToInstanceTransforms Instance transforms of the chunk ISM Components
+	*/
+	void RequestChunkProxy(FWFCChunk& Chunk, const TMap<UStaticMesh*, TArray<FTransform>>& MeshToInstanceTransforms);
+
+	/**
+	* Build the static meshes of the finished background merges and attach them to the resident chunks waiting for them
 	*/
-	bool AreAllTilesNonSpawnable(const TArray<FWaveFunctionCollapseTile>& Tiles);
+	void FinishChunkProxies();
+
+	/**
+	* Add the proxy mesh component to a chunk and limit the draw distance of its ISM Components to ChunkProxySwapDistance
+	* @param Chunk Resident chunk (by ref)
+	* @param ProxyMesh
+	*/
+	void AttachChunkProxy(FWFCChunk& Chunk, UStaticMesh* ProxyMesh);
+
+	/**
+	* Drop the reference of a chunk to its proxy layout, the proxy mesh is released with the last chunk using it
+	* @param Chunk Chunk being evicted (by ref)
+	*/
+	void ReleaseChunkProxy(FWFCChunk& Chunk);
+
+	/**
+	* Collect the locations of all players, used to decide chunk residency
+	*/
+	TArray<FVector> GetViewerLocations() const;
+
+	/**
+	* Collect the viewer locations, plus the current and look-ahead locations of the registered actors
+	*/
+	TArray<FVector> GetCollisionInterestLocations() const;
+
+	/**
+	* Switch the collision of the tagged components of a chunk
+	* @param Chunk (by ref)
+	* @param bEnabled
+	*/
+	void SetChunkCollisionEnabled(FWFCChunk& Chunk, bool bEnabled);
+
+	/**
+	* Returns the option ID placed on an absolute grid cell by an evicted chunk, or InvalidOptionId.
+	* Evicted deterministic chunks are solved again with EvictedChunkSolver, their record keeps the tiles until re-materialized.
+	* @param AbsoluteCell
+	*/
+	uint16 FindEvictedOptionId(const FIntVector& AbsoluteCell);
+
+	/**
+	* Add a chunk record to ChunkCellPages
+	* @param Chunk
+	*/
+	void IndexChunkCells(const FWFCChunk& Chunk);
+
+	/**
+	* Re-materialize the nearest chunks of RematerializationQueue that are still evicted and fit in the memory budget
+	* @param MaxChunks Amount of chunks to re-materialize at most
+	*/
+	void RematerializeQueuedChunks(int32 MaxChunks);
+
+	// Origin cells of the chunks overlapping each page of cells, keyed by page coordinates
+	TMap<FIntVector, TArray<FIntVector, TInlineAllocator<2>>> ChunkCellPages;
+
+	// Evicted chunks in range, a heap on the squared distance to the closest viewer, refreshed by UpdateChunkResidency
+	TArray<TPair<double, FIntVector>> RematerializationQueue;
+
+	// Memory of the resident chunks as of the last residency update, plus the chunks re-materialized since
+	int64 QueuedResidentBytes = 0;
+
+	// Solver context solving evicted deterministic chunks again, so lookups never touch the solve in preparation in Solver
+	FWFCSolverContext EvictedChunkSolver;
+
+	int32 NumEvictedChunks = 0;
+
+	float ChunkResidencyTimer = 0.0f;
+
+	// Background merges of chunk proxies, keyed by chunk layout hash
+	TMap<uint32, UE::Tasks::TTask<TSharedPtr<FWFCProxyMesh>>> PendingChunkProxies;
+
+	// Amount of resident chunks using each proxy layout, built or pending
+	TMap<uint32, int32> ChunkProxyUsers;
+
+	// Geometry merged into chunk proxies per mesh, gathered once and dropped when no chunk uses a proxy anymore
+	TMap<FSoftObjectPath, TSharedPtr<const FWFCProxyGeometry>> ProxyGeometries;
+
+	// Actor replicating the generation events of this world
+	TWeakObjectPtr<AWFCGenerationReplicator> GenerationReplicator;
+
+	// Sequence of the next generation event, recorded by the server or applied by a client
+	int32 NextGenerationEventSequence = 0;
+
+	// Replicated chunks whose solve did not match the server checksum
+	int32 NumDivergedChunks = 0;
+
+	// Actors registered with RegisterCollisionInterest
+	TArray<TWeakObjectPtr<AActor>> CollisionInterestActors;
+
+	// Solver context of speculative solves, with the settings of Solver and no solution cache
+	FWFCSolverContext SpeculativeSolver;
+
+	// Last speculative solve, running or waiting for its Collapse
+	TUniquePtr<FWFCSpeculativeSolve> SpeculativeSolve;
+
+	// Speculative solves committed by Collapse, and dropped because Collapse solved another window
+	int32 NumSpeculativeCommits = 0;
+	int32 NumSpeculativeMisses = 0;
+
+	// Versioned copies of PlacedTiles for readers on other threads
+	FWFCPlacedTilesPublisher PlacedTilesPublisher;
+
+	// Cleared while ClearCity evicts every chunk, which publishes a single empty snapshot instead
+	bool bPublishPlacedTiles = true;
 
+	// Requests recorded since StartJournal
+	FWFCSessionJournal Journal;
+	bool bRecordingJournal = false;
+	double JournalStartTime = 0.0;
 };
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WaveFunctionCollapseModel.h"
+
+#include "WFCSymmetry.generated.h"
+
+/**
+ * Rotational symmetry of a tile around the Z axis, which decides how many yaw variants are derived from it
+ */
+UENUM(BlueprintType)
+enum class EWFCTileSymmetry : uint8
+{
+	// Looks the same under every quarter turn: one variant at Yaw 0
+	X,
+	// Looks the same after a half turn: two variants at Yaw 0 and 90
+	I,
+	// No rotational symmetry: four variants at Yaw 0, 90, 180 and -90
+	T
+};
+
+/**
+ * A tile declared once at Yaw 0.  Its rotated variants and their adjacency tables are derived by FWFCSymmetry::ExpandTiles.
+ */
+USTRUCT(BlueprintType)
+struct FWFCSymmetricTile
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "WaveFunctionCollapse", meta = (AllowedClasses = "StaticMesh, Blueprint"))
+	FSoftObjectPath BaseObject;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "WaveFunctionCollapse")
+	EWFCTileSymmetry Symmetry = EWFCTileSymmetry::T;
+
+	// Weight of every variant
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "WaveFunctionCollapse")
+	float Weight = 1.0f;
+
+	// Adjacent options of the Yaw 0 variant.  Every variant gets them with directions and rotations turned along with the tile.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "WaveFunctionCollapse")
+	TMap<EWaveFunctionCollapseAdjacency, FWaveFunctionCollapseOptions> AdjacencyToOptionsMap;
+};
+
+/**
+ * Derives the rotated variants of symmetric tiles by permuting adjacency directions
+ */
+struct HACKATON_CITY_API FWFCSymmetry
+{
+	/**
+	* Returns the amount of distinct yaw variants of a symmetry class
+	* @param Symmetry
+	*/
+	static int32 GetNumVariants(EWFCTileSymmetry Symmetry);
+
+	/**
+	* Returns the direction an adjacency faces after turning the tile by quarter turns of +90 yaw.  Up and Down are unchanged.
+	* @param Adjacency
+	* @param QuarterTurns
+	*/
+	static EWaveFunctionCollapseAdjacency RotateAdjacency(EWaveFunctionCollapseAdjacency Adjacency, int32 QuarterTurns);
+
+	/**
+	* Add the constraints of every variant of the tiles.
+	* Adjacent options that are symmetric tiles are rotated along with the variant and normalized to one of their own variants.
+	* Other options, like the empty option, are kept as declared.
+	* @param Tiles Tiles declared at Yaw 0
+	* @param OutConstraints Constraints of a model (by ref)
+	*/
+	static void ExpandTiles(const TArray<FWFCSymmetricTile>& Tiles, TMap<FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap>& OutConstraints);
+};
@@ -8,6 +8,12 @@ public class hackaton_city : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "WaveFunctionCollapse", "UnrealEd", "DeveloperSettings" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "NetCore", "InputCore", "EnhancedInput", "WaveFunctionCollapse", "DeveloperSettings", "MeshDescription", "StaticMeshDescription" });
+
+		// Only the bake commandlet and editor world labels use editor code, packaged games and servers build without it
+		if (Target.bBuildEditor)
+		{
+			PrivateDependencyModuleNames.Add("UnrealEd");
+		}
 	}
 }
@@ -13,6 +13,7 @@
 #include "WaveFunctionCollapseModel.h"
 #include "Engine/LocalPlayer.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
 #include "Public/WFCSubsystem.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
@@ -83,7 +84,7 @@ void Ahackaton_cityCharacter::BeginPlay()
 	Super::BeginPlay();
 
 
-	auto* wfcSubsystem = GetWorld()->GetGameInstance()->GetSubsystem<UWFCSubsystem>();
+	auto* wfcSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>();
 	
 	//wfcSubsystem->WFCModel = LoadObject<UWaveFunctionCollapseModel>(this, TEXT("/WaveFunctionCollapse/Sample_Buildings/WFCM_Sample_Buildings.WFCM_Sample_Buildings"));
 	//wfcSubsystem->WFCModel = LoadObject<UWaveFunctionCollapseModel>(this, TEXT("/WaveFunctionCollapse/Sample_Pipes/WFCM_Sample_Pipes.WFCM_Sample_Pipes"));
@@ -93,10 +94,35 @@ void Ahackaton_cityCharacter::BeginPlay()
 	Speed = settings->Speed;
 	wfcSubsystem->WFCModel = Cast<UWaveFunctionCollapseModel>(settings->BaseModel.TryLoad());
 	settings->PopulateModel(wfcSubsystem->WFCModel);
+	wfcSubsystem->DistrictModel = Cast<UWaveFunctionCollapseModel>(settings->DistrictModel.TryLoad());
+	wfcSubsystem->DistrictTileSets = settings->DistrictTileSets;
+	wfcSubsystem->DistrictResolution = settings->DistrictResolution;
+	wfcSubsystem->DistrictCellSize = settings->DistrictCellSize;
 
 	TMap<FWaveFunctionCollapseOption, FWaveFunctionCollapseAdjacencyToOptionsMap> constraints = wfcSubsystem->WFCModel->Constraints;
 	constraints.Add(FWaveFunctionCollapseOption::EmptyOption, FWaveFunctionCollapseAdjacencyToOptionsMap{});
-	wfcSubsystem->Resolution = settings->WFCResolution;
+	wfcSubsystem->Solver.Resolution = settings->WFCResolution;
+	wfcSubsystem->ChunkEvictionRadius = settings->ChunkEvictionRadius;
+	wfcSubsystem->ChunkMemoryBudgetMB = settings->ChunkMemoryBudgetMB;
+	wfcSubsystem->CollisionRadius = settings->CollisionRadius;
+	wfcSubsystem->CollisionBudgetMs = settings->CollisionBudgetMs;
+	wfcSubsystem->bUseCollisionProxies = settings->bUseCollisionProxies;
+	wfcSubsystem->ChunkProxySwapDistance = settings->ChunkProxySwapDistance;
+	wfcSubsystem->bDeterministicGeneration = settings->bDeterministicGeneration;
+	wfcSubsystem->WorldSeed = settings->WorldSeed;
+	wfcSubsystem->bReuseProvisionalTiles = settings->bReuseProvisionalTiles;
+	wfcSubsystem->SolutionCacheCapacity = settings->SolutionCacheCapacity;
+	wfcSubsystem->RandomSeedPoolSize = settings->RandomSeedPoolSize;
+	wfcSubsystem->Solver.ObservationHeuristic = settings->ObservationHeuristic;
+	wfcSubsystem->Solver.ObservationNoise = settings->ObservationNoise;
+
+	// Compile once every setting is in place, CompileModel ends by applying the generation events replicated so far
+	wfcSubsystem->CompileModel();
+	wfcSubsystem->LoadSolutionCache();
+	if (settings->bRecordSessionJournal && !wfcSubsystem->IsRecordingJournal())
+	{
+		wfcSubsystem->StartJournal();
+	}
 }
 
 
@@ -127,6 +153,28 @@ void Ahackaton_cityCharacter::Look(const FInputActionValue& Value)
 
 }
 
+void Ahackaton_cityCharacter::ServerCollapseAt_Implementation(FVector_NetQuantize Location)
+{
+	auto* wfcSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>();
+	if (!wfcSubsystem->WFCModel)
+	{
+		return;
+	}
+
+	// Only locations a projectile of this pawn can reach are generated, snapped like the projectile does
+	const FVector collapseLocation = wfcSubsystem->GetCollapseLocation(Location);
+	const Ahackaton_cityProjectile* projectileDefaults = GetDefault<Ahackaton_cityProjectile>();
+	const float maxCollapseDistance = projectileDefaults->GetProjectileMovement()->MaxSpeed * projectileDefaults->InitialLifeSpan + 2.0f * wfcSubsystem->WFCModel->TileSize;
+	if (FVector::Dist2D(collapseLocation, GetActorLocation()) > maxCollapseDistance)
+	{
+		UE_LOG(LogTemplateCharacter, Warning, TEXT("Rejected Collapse at %s, out of reach of %s"), *collapseLocation.ToString(), *GetNameSafe(this));
+		return;
+	}
+
+	wfcSubsystem->OriginLocation = collapseLocation;
+	wfcSubsystem->Collapse(Ahackaton_cityProjectile::CollapseTryCount, 0);
+}
+
 void Ahackaton_cityCharacter::GenerateCity(const FInputActionValue&)
 {
 	Super::Jump();
@@ -68,6 +68,10 @@ protected:
 public:
 	/** Returns Mesh1P subobject **/
 	USkeletalMeshComponent* GetMesh1P() const { return Mesh1P; }
+	/** Generate the chunk at a location on the server, clients then receive it as a replicated generation event */
+	UFUNCTION(Server, Reliable)
+	void ServerCollapseAt(FVector_NetQuantize Location);
+
 	/** Returns FirstPersonCameraComponent subobject **/
 	UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
 
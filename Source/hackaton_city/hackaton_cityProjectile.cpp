@@ -3,6 +3,8 @@
 #include "hackaton_cityProjectile.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
+#include "hackaton_cityCharacter.h"
+#include "hackaton_cityWeaponComponent.h"
 #include "Public/WFCSubsystem.h"
 
 Ahackaton_cityProjectile::Ahackaton_cityProjectile()
@@ -33,28 +35,110 @@ Ahackaton_cityProjectile::Ahackaton_cityProjectile()
 	InitialLifeSpan = 3.0f;
 }
 
+void Ahackaton_cityProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Pooled projectiles wait for their first Launch
+	if (Pool.IsValid())
+	{
+		Park();
+		return;
+	}
+
+	// Chunks along the flight path need their collision before the projectile gets there
+	if (auto* wfcSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>())
+	{
+		wfcSubsystem->RegisterCollisionInterest(this);
+	}
+}
+
+void Ahackaton_cityProjectile::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (auto* wfcSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>())
+	{
+		wfcSubsystem->UnregisterCollisionInterest(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void Ahackaton_cityProjectile::LifeSpanExpired()
+{
+	Release();
+}
+
+void Ahackaton_cityProjectile::Launch(const FVector& Location, const FRotator& Rotation)
+{
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// The movement component lets go of its updated component once it stops
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->Velocity = Rotation.Vector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->Activate(true);
+	ProjectileMovement->UpdateComponentVelocity();
+
+	SetLifeSpan(GetDefault<Ahackaton_cityProjectile>(GetClass())->InitialLifeSpan);
+
+	if (auto* wfcSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>())
+	{
+		wfcSubsystem->RegisterCollisionInterest(this);
+	}
+}
+
+void Ahackaton_cityProjectile::Park()
+{
+	SetLifeSpan(0.0f);
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+
+	if (auto* wfcSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>())
+	{
+		wfcSubsystem->UnregisterCollisionInterest(this);
+	}
+}
+
+void Ahackaton_cityProjectile::Release()
+{
+	if (Uhackaton_cityWeaponComponent* weapon = Pool.Get())
+	{
+		weapon->ReleaseProjectile(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
 void Ahackaton_cityProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp,
                                      FVector NormalImpulse, const FHitResult& Hit)
 {
-	auto* wfcSubsystem = GetWorld()->GetGameInstance()->GetSubsystem<UWFCSubsystem>();
-	const TWeakObjectPtr model = wfcSubsystem->WFCModel.Get();
-	const auto tileSize = model->TileSize;
-	const FVector buildingLocation{
-		FMath::FloorToFloat(Hit.Location.X / tileSize) * tileSize,
-		FMath::FloorToFloat(Hit.Location.Y / tileSize) * tileSize,
-		0
-	};
-
-	wfcSubsystem->OriginLocation = buildingLocation;
-	wfcSubsystem->Collapse(10, 0);
-
-	Destroy();
-	
-	// Only add impulse and destroy projectile if we hit a physics
+	auto* wfcSubsystem = GetWorld()->GetSubsystem<UWFCSubsystem>();
+	const FVector buildingLocation = wfcSubsystem->GetCollapseLocation(Hit.Location);
+
+	// Clients only regenerate what the server replicates, so they ask the server to generate
+	if (GetNetMode() == NM_Client)
+	{
+		if (auto* character = Cast<Ahackaton_cityCharacter>(GetInstigator()))
+		{
+			character->ServerCollapseAt(buildingLocation);
+		}
+	}
+	else
+	{
+		wfcSubsystem->OriginLocation = buildingLocation;
+		wfcSubsystem->Collapse(CollapseTryCount, 0);
+	}
+
+	// Only add impulse if we hit a physics, before the velocity is reset by the pool
 	if ((OtherActor != nullptr) && (OtherActor != this) && (OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
 	{
 		OtherComp->AddImpulseAtLocation(GetVelocity() * 100.0f, GetActorLocation());
-
-		Destroy();
 	}
+
+	Release();
 }
@@ -8,6 +8,7 @@
 
 class USphereComponent;
 class UProjectileMovementComponent;
+class Uhackaton_cityWeaponComponent;
 
 UCLASS(config=Game)
 class Ahackaton_cityProjectile : public AActor
@@ -23,8 +24,24 @@ class Ahackaton_cityProjectile : public AActor
 	UProjectileMovementComponent* ProjectileMovement;
 
 public:
+	/** TryCount of the Collapse triggered by a hit */
+	static constexpr int32 CollapseTryCount = 10;
+
 	Ahackaton_cityProjectile();
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void LifeSpanExpired() override;
+
+	/** Fires the projectile from a location, restarting its movement, collision and life span */
+	void Launch(const FVector& Location, const FRotator& Rotation);
+
+	/** Hides the projectile and stops its movement and collision until the next Launch */
+	void Park();
+
+	/** Weapon recycling this projectile, null for projectiles destroyed after use */
+	TWeakObjectPtr<Uhackaton_cityWeaponComponent> Pool;
+
 	/** called when projectile hits something */
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
@@ -33,5 +50,9 @@ public:
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
 	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+private:
+	/** Returns the projectile to its pool, or destroys it without one */
+	void Release();
 };
 
@@ -4,9 +4,13 @@
 #include "hackaton_cityWeaponComponent.h"
 #include "hackaton_cityCharacter.h"
 #include "hackaton_cityProjectile.h"
+#include "Public/WFCSubsystem.h"
+#include "Components/SphereComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
 #include "GameFramework/PlayerController.h"
 #include "Camera/PlayerCameraManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "Kismet/GameplayStaticsTypes.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "Animation/AnimInstance.h"
@@ -39,12 +43,31 @@ void Uhackaton_cityWeaponComponent::Fire()
 			// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
 			const FVector SpawnLocation = GetOwner()->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
 	
-			//Set Spawn Collision Handling Override
-			FActorSpawnParameters ActorSpawnParams;
-			ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
-	
-			// Spawn the projectile at the muzzle
-			World->SpawnActor<Ahackaton_cityProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+			// Launch a recycled projectile from the muzzle
+			bool bLaunched = false;
+			if (Ahackaton_cityProjectile* Projectile = AcquireProjectile())
+			{
+				Projectile->SetInstigator(Character);
+				Projectile->Launch(SpawnLocation, SpawnRotation);
+				ActiveProjectiles.Add(Projectile);
+				bLaunched = true;
+			}
+			else if (ProjectilePoolSize <= 0 || (PoolOverflow == EProjectilePoolOverflow::SpawnUnpooled && PooledProjectiles.Num() >= GetMaxPooledProjectiles()))
+			{
+				//Set Spawn Collision Handling Override
+				FActorSpawnParameters ActorSpawnParams;
+				ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+				ActorSpawnParams.Instigator = Character;
+
+				// Spawn the projectile at the muzzle
+				bLaunched = World->SpawnActor<Ahackaton_cityProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams) != nullptr;
+			}
+
+			// Start generating at the predicted impact while the projectile is in flight, a skipped or failed shot collapses nothing
+			if (bLaunched)
+			{
+				SpeculateImpact(SpawnLocation, SpawnRotation);
+			}
 		}
 	}
 	
@@ -66,6 +89,126 @@ void Uhackaton_cityWeaponComponent::Fire()
 	}
 }
 
+void Uhackaton_cityWeaponComponent::SpeculateImpact(const FVector& SpawnLocation, const FRotator& SpawnRotation) const
+{
+	UWorld* const World = GetWorld();
+	UWFCSubsystem* WFCSubsystem = World->GetSubsystem<UWFCSubsystem>();
+	if (WFCSubsystem == nullptr || !WFCSubsystem->bSpeculativeSolves || GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	// Trace the flight of the projectile class defaults up to its first blocking hit, as its OnHit collapses there
+	const Ahackaton_cityProjectile* ProjectileDefaults = GetDefault<Ahackaton_cityProjectile>(ProjectileClass);
+	const UProjectileMovementComponent* ProjectileMovement = ProjectileDefaults->GetProjectileMovement();
+	const USphereComponent* ProjectileCollision = ProjectileDefaults->GetCollisionComp();
+	FPredictProjectilePathParams PathParams(ProjectileCollision->GetUnscaledSphereRadius(), SpawnLocation, SpawnRotation.Vector() * ProjectileMovement->InitialSpeed,
+		ProjectileDefaults->InitialLifeSpan > 0.0f ? ProjectileDefaults->InitialLifeSpan : 3.0f, ProjectileCollision->GetCollisionObjectType());
+	PathParams.OverrideGravityZ = World->GetGravityZ() * ProjectileMovement->ProjectileGravityScale;
+	PathParams.ActorsToIgnore.Add(GetOwner());
+
+	FPredictProjectilePathResult PathResult;
+	if (UGameplayStatics::PredictProjectilePath(this, PathParams, PathResult))
+	{
+		WFCSubsystem->SpeculateCollapse(WFCSubsystem->GetCollapseLocation(PathResult.HitResult.Location), Ahackaton_cityProjectile::CollapseTryCount);
+	}
+}
+
+Ahackaton_cityProjectile* Uhackaton_cityWeaponComponent::SpawnPooledProjectile()
+{
+	UWorld* const World = GetWorld();
+	if (World == nullptr || ProjectileClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	// The pool is set before BeginPlay, which parks the projectile instead of starting its life span
+	Ahackaton_cityProjectile* Projectile = World->SpawnActorDeferred<Ahackaton_cityProjectile>(ProjectileClass, GetOwner()->GetActorTransform(), GetOwner(), Character,
+		ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (Projectile == nullptr)
+	{
+		return nullptr;
+	}
+	Projectile->Pool = this;
+	Projectile->FinishSpawning(GetOwner()->GetActorTransform());
+	PooledProjectiles.Add(Projectile);
+	return Projectile;
+}
+
+Ahackaton_cityProjectile* Uhackaton_cityWeaponComponent::AcquireProjectile()
+{
+	if (ProjectilePoolSize <= 0)
+	{
+		return nullptr;
+	}
+
+	// Parked projectiles may have been destroyed with their level
+	while (!FreeProjectiles.IsEmpty())
+	{
+		Ahackaton_cityProjectile* Projectile = FreeProjectiles.Pop(EAllowShrinking::No);
+		if (IsValid(Projectile))
+		{
+			return Projectile;
+		}
+		PooledProjectiles.Remove(Projectile);
+	}
+
+	if (PooledProjectiles.Num() < GetMaxPooledProjectiles())
+	{
+		return SpawnPooledProjectile();
+	}
+
+	if (PoolOverflow == EProjectilePoolOverflow::RecycleOldest)
+	{
+		while (!ActiveProjectiles.IsEmpty())
+		{
+			Ahackaton_cityProjectile* Projectile = ActiveProjectiles[0];
+			ActiveProjectiles.RemoveAt(0, EAllowShrinking::No);
+			if (IsValid(Projectile))
+			{
+				Projectile->Park();
+				return Projectile;
+			}
+			PooledProjectiles.Remove(Projectile);
+		}
+
+		// Every projectile in flight was destroyed, refill the pool instead of skipping the shot
+		if (PooledProjectiles.Num() < GetMaxPooledProjectiles())
+		{
+			return SpawnPooledProjectile();
+		}
+	}
+	return nullptr;
+}
+
+int32 Uhackaton_cityWeaponComponent::GetMaxPooledProjectiles() const
+{
+	return FMath::Max(MaxPooledProjectiles, ProjectilePoolSize);
+}
+
+#if WITH_EDITOR
+void Uhackaton_cityWeaponComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// A pool capped below its initial size could not recycle anything and would never fire
+	const FName PropertyName = PropertyChangedEvent.GetMemberPropertyName();
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(Uhackaton_cityWeaponComponent, ProjectilePoolSize) || PropertyName == GET_MEMBER_NAME_CHECKED(Uhackaton_cityWeaponComponent, MaxPooledProjectiles))
+	{
+		MaxPooledProjectiles = FMath::Max(MaxPooledProjectiles, ProjectilePoolSize);
+	}
+}
+#endif
+
+void Uhackaton_cityWeaponComponent::ReleaseProjectile(Ahackaton_cityProjectile* Projectile)
+{
+	Projectile->Park();
+	if (ActiveProjectiles.Remove(Projectile) > 0)
+	{
+		FreeProjectiles.Add(Projectile);
+	}
+}
+
 bool Uhackaton_cityWeaponComponent::AttachWeapon(Ahackaton_cityCharacter* TargetCharacter)
 {
 	Character = TargetCharacter;
@@ -80,6 +223,17 @@ bool Uhackaton_cityWeaponComponent::AttachWeapon(Ahackaton_cityCharacter* Target
 	FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, true);
 	AttachToComponent(Character->GetMesh1P(), AttachmentRules, FName(TEXT("GripPoint")));
 
+	// Spawn the projectile pool up front, so firing only moves existing projectiles
+	while (PooledProjectiles.Num() < ProjectilePoolSize)
+	{
+		Ahackaton_cityProjectile* Projectile = SpawnPooledProjectile();
+		if (Projectile == nullptr)
+		{
+			break;
+		}
+		FreeProjectiles.Add(Projectile);
+	}
+
 	// Set up action bindings
 	if (APlayerController* PlayerController = Cast<APlayerController>(Character->GetController()))
 	{
@@ -114,6 +268,18 @@ void Uhackaton_cityWeaponComponent::EndPlay(const EEndPlayReason::Type EndPlayRe
 		}
 	}
 
+	// the pool goes away with the weapon
+	for (Ahackaton_cityProjectile* Projectile : PooledProjectiles)
+	{
+		if (IsValid(Projectile))
+		{
+			Projectile->Destroy();
+		}
+	}
+	PooledProjectiles.Empty();
+	FreeProjectiles.Empty();
+	ActiveProjectiles.Empty();
+
 	// maintain the EndPlay call chain
 	Super::EndPlay(EndPlayReason);
 }
\ No newline at end of file
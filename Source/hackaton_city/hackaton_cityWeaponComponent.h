@@ -7,6 +7,19 @@
 #include "hackaton_cityWeaponComponent.generated.h"
 
 class Ahackaton_cityCharacter;
+class Ahackaton_cityProjectile;
+
+/** What Fire does once the projectile pool is full and every projectile is in flight */
+UENUM(BlueprintType)
+enum class EProjectilePoolOverflow : uint8
+{
+	/** Relaunch the projectile that was fired first */
+	RecycleOldest,
+	/** Spawn an extra projectile that is destroyed after use, like without a pool */
+	SpawnUnpooled,
+	/** Don't fire */
+	Skip
+};
 
 UCLASS(Blueprintable, BlueprintType, ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class HACKATON_CITY_API Uhackaton_cityWeaponComponent : public USkeletalMeshComponent
@@ -18,6 +31,18 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category=Projectile)
 	TSubclassOf<class Ahackaton_cityProjectile> ProjectileClass;
 
+	/** Projectiles spawned up front when the weapon is attached, recycled instead of destroyed. 0 spawns a new projectile every shot */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile, meta=(ClampMin="0"))
+	int32 ProjectilePoolSize = 16;
+
+	/** The pool grows up to this many projectiles under sustained fire, never fewer than ProjectilePoolSize */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile, meta=(ClampMin="0"))
+	int32 MaxPooledProjectiles = 32;
+
+	/** What to do when firing with every pooled projectile in flight */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile)
+	EProjectilePoolOverflow PoolOverflow = EProjectilePoolOverflow::RecycleOldest;
+
 	/** Sound to play each time we fire */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
 	USoundBase* FireSound;
@@ -49,6 +74,13 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Weapon")
 	void Fire();
 
+	/** Hands a pooled projectile back once it hit something or its life span expired */
+	void ReleaseProjectile(Ahackaton_cityProjectile* Projectile);
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 protected:
 	/** Ends gameplay for this component. */
 	UFUNCTION()
@@ -57,4 +89,28 @@ protected:
 private:
 	/** The Character holding this weapon*/
 	Ahackaton_cityCharacter* Character;
+
+	/** Traces the trajectory of a projectile fired now and starts solving the window around its predicted impact */
+	void SpeculateImpact(const FVector& SpawnLocation, const FRotator& SpawnRotation) const;
+
+	/** Spawns a projectile owned by the pool, parked until launched */
+	Ahackaton_cityProjectile* SpawnPooledProjectile();
+
+	/** Size the pool may grow to, MaxPooledProjectiles raised to ProjectilePoolSize for assets saved with a smaller value */
+	int32 GetMaxPooledProjectiles() const;
+
+	/** Returns a parked projectile, or applies PoolOverflow when there is none */
+	Ahackaton_cityProjectile* AcquireProjectile();
+
+	/** Every projectile owned by the pool */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<Ahackaton_cityProjectile>> PooledProjectiles;
+
+	/** Parked projectiles, ready to launch */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<Ahackaton_cityProjectile>> FreeProjectiles;
+
+	/** Projectiles in flight, oldest first */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<Ahackaton_cityProjectile>> ActiveProjectiles;
 };
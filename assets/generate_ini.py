@@ -12,6 +12,16 @@ class CamelCaseConfigParser(configparser.ConfigParser):
     def optionxform(self, optionstr: str) -> str:
         return optionstr
 
+def generate_adjacency_str(adjacency_to_options_map) -> str:
+    adjacency_str = ''
+    for adjacency in adjacency_to_options_map:
+        if adjacency.options:
+            options_str = ',\n                            '.join([f'(\n                                BaseObject="{option.BaseObject}",\n                                BaseRotator=(\n                                    Pitch={float(option.BaseRotator.Pitch)},\n                                    Yaw={float(option.BaseRotator.Yaw)},\n                                    Roll={float(option.BaseRotator.Roll)}\n                                ),\n                                BaseScale3D=(\n                                    X={option.BaseScale3D.X},\n                                    Y={option.BaseScale3D.Y},\n                                    Z={option.BaseScale3D.Z}\n                                )\n                            )' for option in adjacency.options])
+            adjacency_str += f'\n                (\n                    {adjacency.direction}, (\n                        Options=(\n                            {options_str}\n                        )\n                    )\n                ),'
+        else:
+            adjacency_str += f'\n                (\n                    {adjacency.direction}, ()\n                ),'
+    return adjacency_str
+
 def generate_config(model_data: ModelData) -> CamelCaseConfigParser:
     config = CamelCaseConfigParser()
 
@@ -23,18 +33,23 @@ def generate_config(model_data: ModelData) -> CamelCaseConfigParser:
     constraints_str = []
     for constraint in model_data.Constraints:
         constraint_str = f'    (\n        (\n            BaseObject="{constraint.BaseObject}",\n            BaseRotator=(\n                Pitch={float(constraint.BaseRotator.Pitch)},\n                Yaw={float(constraint.BaseRotator.Yaw)},\n                Roll={float(constraint.BaseRotator.Roll)}\n            ),\n            BaseScale3D=(\n                X={constraint.BaseScale3D.X},\n                Y={constraint.BaseScale3D.Y},\n                Z={constraint.BaseScale3D.Z}\n            )\n        ),\n        (\n            Weight={constraint.Weight},\n            AdjacencyToOptionsMap=('
-        
-        for adjacency in constraint.AdjacencyToOptionsMap:
-            if adjacency.options:
-                options_str = ',\n                            '.join([f'(\n                                BaseObject="{option.BaseObject}",\n                                BaseRotator=(\n                                    Pitch={float(option.BaseRotator.Pitch)},\n                                    Yaw={float(option.BaseRotator.Yaw)},\n                                    Roll={float(option.BaseRotator.Roll)}\n                                ),\n                                BaseScale3D=(\n                                    X={option.BaseScale3D.X},\n                                    Y={option.BaseScale3D.Y},\n                                    Z={option.BaseScale3D.Z}\n                                )\n                            )' for option in adjacency.options])
-                constraint_str += f'\n                (\n                    {adjacency.direction}, (\n                        Options=(\n                            {options_str}\n                        )\n                    )\n                ),'
-            else:
-                constraint_str += f'\n                (\n                    {adjacency.direction}, ()\n                ),'
-        
+        constraint_str += generate_adjacency_str(constraint.AdjacencyToOptionsMap)
         constraint_str = constraint_str.rstrip(',') + '\n            )\n        )\n    )'
         constraints_str.append(constraint_str)
-    
-    model_data_str = f'(\nTileSize=7000.000000,\nConstraints=(\n{",\n".join(constraints_str)}\n)\n)'
+
+    symmetric_tiles_str = []
+    for tile in model_data.SymmetricTiles:
+        tile_str = f'    (\n        BaseObject="{tile.BaseObject}",\n        Symmetry={tile.Symmetry},\n        Weight={tile.Weight},\n        AdjacencyToOptionsMap=('
+        tile_str += generate_adjacency_str(tile.AdjacencyToOptionsMap)
+        tile_str = tile_str.rstrip(',') + '\n        )\n    )'
+        symmetric_tiles_str.append(tile_str)
+
+    model_data_str = '(\nTileSize=7000.000000'
+    if constraints_str:
+        model_data_str += ',\nConstraints=(\n' + ',\n'.join(constraints_str) + '\n)'
+    if symmetric_tiles_str:
+        model_data_str += ',\nSymmetricTiles=(\n' + ',\n'.join(symmetric_tiles_str) + '\n)'
+    model_data_str += '\n)'
     model_data_str = model_data_str.replace(" ", "").replace("\n", "")
 
     base_model_str = "/Game/HackatonCity/DataModel/DS_WFCM_HackatonCity.DS_WFCM_HackatonCity"
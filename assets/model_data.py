@@ -31,6 +31,15 @@ class Constraint:
     Weight: float = 1.0
     AdjacencyToOptionsMap: list[AdjacencyOption] = field(default_factory=list)
 
+@dataclass
+class SymmetricTile:
+    """A tile declared once at Yaw 0, its rotated variants are derived when the model is populated"""
+    BaseObject: str
+    Symmetry: str = "T"
+    Weight: float = 1.0
+    AdjacencyToOptionsMap: list[AdjacencyOption] = field(default_factory=list)
+
 @dataclass
 class ModelData:
     Constraints: list[Constraint] = field(default_factory=list)
+    SymmetricTiles: list[SymmetricTile] = field(default_factory=list)
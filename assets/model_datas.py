@@ -1,4 +1,4 @@
-from model_data import ModelData, Constraint, Rotator, Option, AdjacencyOption
+from model_data import ModelData, SymmetricTile, Rotator, Option, AdjacencyOption
 from itertools import product
 from collections import defaultdict
 
@@ -117,12 +117,16 @@ def model_data_matrix():
         count
     )
 
+# Every lot has a distinct look at each of the four angles
+SYMMETRY = "T"
+
 def generate_model_datas(model_dict, weight) -> ModelData:
+    # Only the Yaw 0 adjacency is written, the other angles are derived by rotating it
     model_data = ModelData(
-        Constraints=[
-            Constraint(
+        SymmetricTiles=[
+            SymmetricTile(
                 BaseObject=BASE_PATH + key,
-                BaseRotator=Rotator(Yaw=rotation),
+                Symmetry=SYMMETRY,
                 Weight=weight,
                 AdjacencyToOptionsMap=[
                     AdjacencyOption(
@@ -132,14 +136,13 @@ def generate_model_datas(model_dict, weight) -> ModelData:
                                 BaseObject=BASE_PATH + option[0],
                                 BaseRotator=Rotator(Yaw=option[1])
                             )
-                            for option in constraints[direction]
+                            for option in value[0][direction]
                         ]
                     )
-                    for direction in constraints
+                    for direction in value[0]
                 ]
             )
             for key, value in model_dict.items()
-            for rotation, constraints in value.items()
         ]
     )
     